@@ -1,60 +1,13 @@
-QT       += core gui widgets
-QT       += svg
-QT       += xml
-QT       += testlib
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-CONFIG += c++11
-# The following define makes your compiler emit warnings if you use
-# any Qt feature that has been marked deprecated (the exact warnings
-# depend on your compiler). Please consult the documentation of the
-# deprecated API in order to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if it uses deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-
-SOURCES += \
-    flowlayout.cpp \
-    main.cpp \
-    mainwindow.cpp \
-    operation.cpp \
-    operationstack.cpp \
-    view.cpp \
-    scene.cpp \
-    chartbutton.cpp \
-    pixmapitem.cpp \
-    chartitem.cpp \
-    lineitem.cpp \
-    textitem.cpp \
-    controlpoint.cpp \
-    testmainwindow.cpp
-
-HEADERS += \
-    flowlayout.h \
-    mainwindow.h \
-    operation.h \
-    operationstack.h \
-    view.h \
-    scene.h \
-    chartbutton.h \
-    pixmapitem.h \
-    chartitem.h \
-    lineitem.h \
-    textitem.h \
-    controlpoint.h
-
-FORMS += \
-    mainwindow.ui
-
-# Default rules for deployment.
-qnx: target.path = /tmp/$${TARGET}/bin
-else: unix:!android: target.path = /opt/$${TARGET}/bin
-!isEmpty(target.path): INSTALLS += target
-
-RESOURCES += \
-    sources.qrc
+# core：数据模型、撤销栈和空间索引组成的静态库，不依赖 widgets
+# app：流程图编辑器；tests 和 benchmarks 分别为功能测试和性能基准测试
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    core \
+    app \
+    tests \
+    benchmarks
+
+app.depends = core
+tests.depends = core
+benchmarks.depends = core
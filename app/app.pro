@@ -0,0 +1,33 @@
+# 流程图编辑器
+include(../flowcharts.pri)
+
+QT       += testlib
+
+TARGET = FlowCharts
+
+# 调试版本编译性能计数器和浮层（F12显示，Ctrl+F12导出），发布版本中不包含
+CONFIG(debug, debug|release): DEFINES += FLOWCHARTS_PROFILING
+# You can also make your code fail to compile if it uses deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+    ../flowlayout.cpp \
+    ../main.cpp \
+    ../mainwindow.cpp \
+    ../chartbutton.cpp \
+    ../testmainwindow.cpp
+
+HEADERS += \
+    ../flowlayout.h \
+    ../mainwindow.h \
+    ../chartbutton.h
+
+FORMS += \
+    ../mainwindow.ui
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,21 @@
+﻿#ifndef BENCHMAIN_H
+#define BENCHMAIN_H
+
+#include <QtTest>
+#include "view.h"
+
+// 基准测试的入口：未指定平台时使用 offscreen 无界面运行，并关闭提示框
+#define FLOWCHARTS_BENCHMARK_MAIN(TestObject) \
+int main(int argc, char *argv[]) \
+{ \
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) \
+    { \
+        qputenv("QT_QPA_PLATFORM", "offscreen"); \
+    } \
+    QApplication app(argc, argv); \
+    View::showPrompts = false; \
+    TestObject test; \
+    return QTest::qExec(&test, argc, argv); \
+}
+
+#endif // BENCHMAIN_H
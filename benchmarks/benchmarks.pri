@@ -0,0 +1,16 @@
+# 各个基准测试共用的配置：编译应用中的场景、视图和图形项源码并链接核心库
+include($$PWD/../flowcharts.pri)
+
+QT       += testlib
+
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/diagramgenerator.cpp
+
+HEADERS += \
+    $$PWD/benchmain.h \
+    $$PWD/diagramgenerator.h
@@ -0,0 +1,9 @@
+# 性能基准测试，结果可用 QtTest 的参数输出为机器可读格式，例如：
+#   ./diagramoperations -o results.xml,xml
+#   ./diagramoperations -o results.csv,csv
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    sceneindex \
+    diagramoperations \
+    startup
@@ -0,0 +1,85 @@
+﻿#include "diagramgenerator.h"
+
+#include <QRandomGenerator>
+
+DiagramGenerator::DiagramGenerator(int shapes, int edges, int labels, DegreeDistribution distribution, quint32 seed)
+    : shapes(shapes), edges(edges), labels(labels), distribution(distribution), seed(seed)
+{}
+
+QString DiagramGenerator::labelText(int index)
+{
+    return QString("节点%1").arg(index % 100);
+}
+
+void DiagramGenerator::populate(Scene* scene) const
+{
+    QRandomGenerator random(seed);
+
+    // 图形按正方形网格摆放
+    QVector<ChartItem*> charts;
+    int columns = qMax(1, qCeil(qSqrt(shapes)));
+    for (int i = 0; i < shapes; ++i)
+    {
+        ChartItem* chartItem = new ChartItem(FlowEnumItem(random.bounded(1, 11)));
+        chartItem->setPos((i % columns) * spacing, (i / columns) * spacing);
+        scene->addItem(chartItem);
+        charts.append(chartItem);
+    }
+
+    // 连线
+    QVector<LineItem*> lines;
+    QVector<int> endpoints;                                 // 已有连线的端点，用于优先连接
+    for (int i = 0; i < edges && shapes > 1; ++i)
+    {
+        int start = 0;
+        int end = 0;
+        switch (distribution)
+        {
+            case Uniform:
+                start = random.bounded(shapes);
+                end = random.bounded(shapes);
+                break;
+            case PowerLaw:
+                start = random.bounded(shapes);
+                end = (!endpoints.isEmpty() && random.bounded(10) < 8) ? endpoints[random.bounded(endpoints.size())] : random.bounded(shapes);
+                break;
+            case Chain:
+                start = i < shapes - 1 ? i : random.bounded(shapes - 1);
+                end = qMin(start + 1 + (i < shapes - 1 ? 0 : random.bounded(3)), shapes - 1);
+                break;
+        }
+        if (start == end)
+        {
+            end = (end + 1) % shapes;
+        }
+        endpoints << start << end;
+        LineItem* lineItem = new LineItem(charts[start], charts[end]);
+        scene->addItem(lineItem);
+        scene->allLines.append(lineItem);
+        QObject::connect(lineItem, &LineItem::doubleClickItem, scene, &Scene::doubleClickItem);
+        lines.append(lineItem);
+    }
+
+    // 文本先关联图形，再关联连线，其余为独立文本
+    for (int i = 0; i < labels; ++i)
+    {
+        TextItem* textItem = new TextItem();
+        textItem->setPlainText(labelText(i));
+        textItem->text = labelText(i);
+        if (i < charts.size())
+        {
+            scene->connectText(textItem, charts[i]);
+        }
+        else if (i - charts.size() < lines.size())
+        {
+            scene->connectText(textItem, lines[i - charts.size()]);
+        }
+        else
+        {
+            textItem->setPos(random.bounded(columns * spacing), random.bounded(columns * spacing));
+        }
+        scene->addItem(textItem);
+        scene->allTexts.append(textItem);
+    }
+    scene->flushLayout();
+}
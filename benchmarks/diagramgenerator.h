@@ -0,0 +1,32 @@
+﻿#ifndef DIAGRAMGENERATOR_H
+#define DIAGRAMGENERATOR_H
+
+#include "scene.h"
+
+// 生成用于基准测试的流程图：指定图形、连线和文本的数量以及连线的度分布
+class DiagramGenerator
+{
+public:
+    enum DegreeDistribution
+    {
+        Uniform,    // 两端随机选取
+        PowerLaw,   // 优先连接，少数图形拥有大量连线
+        Chain,      // 沿流程顺序连接，偶尔向后跳几步
+    };
+
+    DiagramGenerator(int shapes, int edges, int labels, DegreeDistribution distribution = Uniform, quint32 seed = 1);
+
+    static const int spacing = 250;                         // 图形之间的间距
+
+    void populate(Scene* scene) const;                      // 在场景中生成图形、连线和文本
+    static QString labelText(int index);                    // 第index个文本的内容，每100个重复一次便于查找
+
+private:
+    int shapes;
+    int edges;
+    int labels;
+    DegreeDistribution distribution;
+    quint32 seed;
+};
+
+#endif // DIAGRAMGENERATOR_H
@@ -0,0 +1,377 @@
+﻿#include <QtTest>
+#include <numeric>
+#include "benchmain.h"
+#include "view.h"
+#include "diagramgenerator.h"
+
+// 在生成的大型流程图上测量常用操作的耗时
+// 每个测试按图形数量和连线的度分布分组，结果可用 -o file,xml 或 -o file,csv 输出
+class BenchDiagramOperations : public QObject
+{
+    Q_OBJECT
+
+private:
+    View* view = nullptr;
+
+    void addColumns()
+    {
+        QTest::addColumn<int>("shapes");
+        QTest::addColumn<int>("edges");
+        QTest::addColumn<int>("labels");
+        QTest::addColumn<int>("distribution");
+        QTest::newRow("uniform-1k") << 1000 << 1500 << 1000 << int(DiagramGenerator::Uniform);
+        QTest::newRow("powerlaw-1k") << 1000 << 1500 << 1000 << int(DiagramGenerator::PowerLaw);
+        QTest::newRow("chain-1k") << 1000 << 1500 << 1000 << int(DiagramGenerator::Chain);
+        QTest::newRow("uniform-5k") << 5000 << 7500 << 5000 << int(DiagramGenerator::Uniform);
+    }
+
+    // 按当前数据行生成新的视图和流程图
+    Scene* generate()
+    {
+        QFETCH(int, shapes);
+        QFETCH(int, edges);
+        QFETCH(int, labels);
+        QFETCH(int, distribution);
+        delete view;
+        view = new View();
+        view->resize(1920, 1080);
+        DiagramGenerator(shapes, edges, labels, DiagramGenerator::DegreeDistribution(distribution)).populate(view->graphicsScene);
+        return view->graphicsScene;
+    }
+
+    QList<QGraphicsItem*> chartItems(Scene* scene)
+    {
+        QList<QGraphicsItem*> charts;
+        QList<QGraphicsItem*> allItems = scene->items();
+        for (QGraphicsItem* item : qAsConst(allItems))
+        {
+            if (item->type() == ChartItem::Type)
+            {
+                charts.append(item);
+            }
+        }
+        return charts;
+    }
+
+    void sendMouse(Scene* scene, QEvent::Type type, QPointF position, QPointF pressPosition)
+    {
+        QGraphicsSceneMouseEvent event(type);
+        event.setScenePos(position);
+        event.setButtonDownScenePos(Qt::LeftButton, pressPosition);
+        event.setButton(Qt::LeftButton);
+        event.setButtons(type == QEvent::GraphicsSceneMouseRelease ? Qt::NoButton : Qt::LeftButton);
+        QApplication::sendEvent(scene, &event);
+    }
+
+private slots:
+    void cleanup()
+    {
+        delete view;
+        view = nullptr;
+    }
+
+    void benchGenerate_data() { addColumns(); }
+    void benchGenerate()
+    {
+        QBENCHMARK_ONCE
+        {
+            generate();
+        }
+    }
+
+    void benchSave_data() { addColumns(); }
+    void benchSave()
+    {
+        Scene* scene = generate();
+        QBENCHMARK
+        {
+            QByteArray data;
+            QBuffer buffer(&data);
+            buffer.open(QIODevice::WriteOnly);
+            scene->saveToXml(&buffer, "bench", "bench");
+        }
+    }
+
+    void benchLoad_data() { addColumns(); }
+    void benchLoad()
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        generate()->saveToXml(&buffer, "bench", "bench");
+        buffer.close();
+        QBENCHMARK
+        {
+            Scene scene;
+            buffer.open(QIODevice::ReadOnly);
+            scene.loadFromXml(&buffer);
+            buffer.close();
+            scene.flushLayout();
+        }
+    }
+
+    void benchRenderFrame_data() { addColumns(); }
+    void benchRenderFrame()
+    {
+        Scene* scene = generate();
+        QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+        QBENCHMARK
+        {
+            image.fill(Qt::white);
+            QPainter painter(&image);
+            scene->render(&painter, QRectF(image.rect()), QRectF(0, 0, 1920, 1080));
+        }
+    }
+
+    void benchRenderBundled_data() { addColumns(); }
+    void benchRenderBundled()
+    {
+        // 与 benchRenderFrame 相同，但开启扇入连线捆绑
+        Scene* scene = generate();
+        scene->setEdgeBundling(true);
+        QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+        QBENCHMARK
+        {
+            image.fill(Qt::white);
+            QPainter painter(&image);
+            scene->render(&painter, QRectF(image.rect()), QRectF(0, 0, 1920, 1080));
+        }
+    }
+
+    void benchDrag_data() { addColumns(); }
+    void benchDrag()
+    {
+        Scene* scene = generate();
+        QList<QGraphicsItem*> charts = chartItems(scene);
+        for (QGraphicsItem* item : qAsConst(charts))
+        {
+            item->setSelected(true);
+        }
+        QGraphicsItem* handle = charts.last();
+        // 每次拖动：按下、移动10次、松开，并完成一次布局
+        QBENCHMARK
+        {
+            QPointF start = handle->sceneBoundingRect().center();
+            sendMouse(scene, QEvent::GraphicsSceneMousePress, start, start);
+            for (int i = 1; i <= 10; ++i)
+            {
+                sendMouse(scene, QEvent::GraphicsSceneMouseMove, start + QPointF(i * 5, i * 3), start);
+            }
+            sendMouse(scene, QEvent::GraphicsSceneMouseRelease, start + QPointF(50, 30), start);
+            scene->flushLayout();
+        }
+    }
+
+    void benchDelete_data() { addColumns(); }
+    void benchDelete()
+    {
+        Scene* scene = generate();
+        QList<QGraphicsItem*> charts = chartItems(scene);
+        QList<QGraphicsItem*> removed = charts.mid(0, charts.size() / 10);   // 删除十分之一的图形及其连线、文本
+        QBENCHMARK_ONCE
+        {
+            scene->removeAllSelect(removed);
+        }
+    }
+
+    void benchCopy_data() { addColumns(); }
+    void benchCopy()
+    {
+        Scene* scene = generate();
+        QList<QGraphicsItem*> allItems = scene->items();
+        QString data;
+        QBENCHMARK
+        {
+            data = scene->copyToXml(allItems);
+        }
+        QVERIFY(!data.isEmpty());
+    }
+
+    void benchPaste_data() { addColumns(); }
+    void benchPaste()
+    {
+        Scene* scene = generate();
+        QString data = scene->copyToXml(scene->items());
+        QList<QGraphicsItem*> pasted;
+        QBENCHMARK_ONCE
+        {
+            pasted = scene->pasteFromXml(data, QPointF(0, 0));
+            scene->flushLayout();
+        }
+        QVERIFY(!pasted.isEmpty());
+    }
+
+    void benchSearch_data() { addColumns(); }
+    void benchSearch()
+    {
+        Scene* scene = generate();
+        QBENCHMARK
+        {
+            scene->searchText(DiagramGenerator::labelText(7));
+        }
+        QVERIFY(!scene->containTexts.isEmpty());
+    }
+
+    void benchIndexedSearch_data() { addColumns(); }
+    void benchIndexedSearch()
+    {
+        // 包含和正则查找由三字组索引缩小候选，不随文本总数线性增长
+        Scene* scene = generate();
+        QString label = DiagramGenerator::labelText(7);
+        QBENCHMARK
+        {
+            scene->searchText(label, LabelIndex::Substring);           // 同时匹配 70 到 79
+            scene->searchText("^" + label + "\\d$", LabelIndex::Regex);
+        }
+        QVERIFY(!scene->containTexts.isEmpty());
+    }
+
+    void benchReplaceAll_data() { addColumns(); }
+    void benchReplaceAll()
+    {
+        // 替换所有文本并撤销：后台计算、整批应用、一次重新定位
+        Scene* scene = generate();
+        QBENCHMARK
+        {
+            scene->replaceAll("节点", LabelIndex::Substring, "步骤");
+            scene->getReplacer()->waitForDone();
+            view->operationStack->undo();
+        }
+        QVERIFY(!scene->getLabelIndex().search("节点", LabelIndex::Substring).isEmpty());
+    }
+
+    void benchModelBulk_data() { addColumns(); }
+    void benchModelBulk()
+    {
+        // 在按列存放的模型上整体移动、改色并做命中测试
+        DiagramModel model = generate()->toModel(view->graphicsScene->items());
+        QVector<int> allNodes(model.nodeCount());
+        std::iota(allNodes.begin(), allNodes.end(), 0);
+        QRectF bounds = model.boundingRect();
+        QBENCHMARK
+        {
+            model.translate(QPointF(1, 1));
+            model.setNodeStyles(allNodes, DiagramModel::styleId("r", "y"));
+            model.nodesInRect(QRectF(bounds.center(), QSizeF(1000, 1000)));
+        }
+    }
+
+    void benchAutoLayout_data() { addColumns(); }
+    void benchAutoLayout()
+    {
+        // 只计算布局，不包括移动图形项
+        DiagramModel model = generate()->toModel(view->graphicsScene->items());
+        QVector<QPointF> positions;
+        QBENCHMARK
+        {
+            positions = LayeredLayout::layout(model);
+        }
+        QCOMPARE(positions.size(), model.nodeCount());
+    }
+
+    void benchGraphAnalysis_data() { addColumns(); }
+    void benchGraphAnalysis()
+    {
+        // 一次完整的流程检查：建立邻接表、可达性和强连通分量
+        DiagramModel model = generate()->toModel(view->graphicsScene->items());
+        QVector<quint8> warnings;
+        QBENCHMARK
+        {
+            warnings = GraphAnalysis::analyze(model);
+        }
+        QCOMPARE(warnings.size(), model.nodeCount());
+    }
+
+    void benchRouteEdges_data() { addColumns(); }
+    void benchRouteEdges()
+    {
+        // 在所有图形作为障碍物时为每条连线计算正交折线
+        DiagramModel model = generate()->toModel(view->graphicsScene->items());
+        OrthogonalRouter router;
+        for (int i = 0; i < model.nodeCount(); ++i)
+        {
+            router.setObstacle(quintptr(i + 1), model.nodeBounds(i));
+        }
+        int routed = 0;
+        QBENCHMARK
+        {
+            routed = 0;
+            for (int e = 0; e < model.edgeCount(); ++e)
+            {
+                int start = model.edgeStarts.at(e);
+                int end = model.edgeEnds.at(e);
+                routed += router.route(model.nodeBounds(start), model.nodeBounds(end), quintptr(start + 1), quintptr(end + 1)).size() >= 2;
+            }
+        }
+        QCOMPARE(routed, model.edgeCount());
+    }
+
+    void benchResizePixmap()
+    {
+        // 拖动缩放一张 6000×4000 的图片：每一步只从最近的一级快速缩放
+        QImage image(6000, 4000, QImage::Format_RGB32);
+        image.fill(Qt::darkCyan);
+        Scene scene;
+        PixmapItem* item = new PixmapItem(QPixmap::fromImage(image));
+        scene.addItem(item);
+        QThreadPool::globalInstance()->waitForDone();
+        QCoreApplication::processEvents();
+        int step = 0;
+        QBENCHMARK
+        {
+            item->changeRect(QRectF(0, 0, 800 + (step++ % 10) * 40, 600), true);
+        }
+        QVERIFY(!item->pixmap().isNull());
+    }
+
+    void benchDecodeAtDisplaySize()
+    {
+        // 导入一张 6000×4000 的照片并以 600×400 显示：JPEG 在解码时直接缩小
+        QImage image(6000, 4000, QImage::Format_RGB32);
+        image.fill(Qt::darkYellow);
+        QByteArray encoded;
+        QBuffer buffer(&encoded);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "jpg");
+        Scene scene;
+        QString key = scene.getImageStore().insert(encoded);
+        QBENCHMARK
+        {
+            delete scene.createPixmapItem(key, QSizeF(600, 400));
+        }
+        QThreadPool::globalInstance()->waitForDone();
+    }
+
+    void benchPanBackground()
+    {
+        // 以 4000×3000 的照片为背景平移视图：块缓存后每帧只绘制暴露区域
+        QImage photo(4000, 3000, QImage::Format_RGB32);
+        photo.fill(Qt::darkGreen);
+        Scene scene;
+        scene.setBackgroundImage(scene.getImageStore().insert(photo), photo.size());
+        QImage image(1920, 1080, QImage::Format_ARGB32_Premultiplied);
+        int step = 0;
+        QBENCHMARK
+        {
+            QPainter painter(&image);
+            QPointF offset((step++ % 20) * 64, 0);
+            scene.render(&painter, QRectF(image.rect()), QRectF(offset, QSizeF(1920, 1080)));
+        }
+    }
+
+    void benchUndoRedo_data() { addColumns(); }
+    void benchUndoRedo()
+    {
+        Scene* scene = generate();
+        view->operationStack->addOperation(new MoveOperation(QPointF(0, 0), QPointF(100, 100), chartItems(scene), view));
+        QBENCHMARK
+        {
+            view->operationStack->undo();
+            view->operationStack->redo();
+            scene->flushLayout();
+        }
+    }
+};
+
+FLOWCHARTS_BENCHMARK_MAIN(BenchDiagramOperations)
+#include "benchdiagramoperations.moc"
@@ -0,0 +1,6 @@
+include(../benchmarks.pri)
+
+TARGET = diagramoperations
+
+SOURCES += \
+    benchdiagramoperations.cpp
@@ -0,0 +1,142 @@
+﻿#include <QtTest>
+#include "benchmain.h"
+#include "scene.h"
+
+// 比较 BSP、无索引和网格索引在插入、移动和查询上的开销
+// 使用共享像素图的 PixmapItem 代替 ChartItem，避免把 SVG 解析计入索引的开销
+class BenchSceneIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    QPixmap shapePixmap;                                            // 与默认图形尺寸相近的像素图
+
+    static const int spacing = 200;                                 // 图形之间的间距
+
+    void addColumns()
+    {
+        QTest::addColumn<int>("method");
+        QTest::addColumn<int>("count");
+        const QList<int> counts = QList<int>() << 1000 << 10000 << 100000;
+        for (int count : counts)
+        {
+            QTest::newRow(qPrintable(QString("bsp-%1").arg(count))) << int(BspTreeIndexing) << count;
+            QTest::newRow(qPrintable(QString("noindex-%1").arg(count))) << int(LinearIndexing) << count;
+            QTest::newRow(qPrintable(QString("grid-%1").arg(count))) << int(GridIndexing) << count;
+        }
+    }
+
+    // 按正方形网格摆放 count 个图形
+    QList<PixmapItem*> populate(Scene& scene, int count)
+    {
+        QList<PixmapItem*> items;
+        int columns = qCeil(qSqrt(count));
+        for (int i = 0; i < count; ++i)
+        {
+            PixmapItem* item = new PixmapItem(shapePixmap);
+            item->setPos((i % columns) * spacing, (i / columns) * spacing);
+            scene.addItem(item);
+            items.append(item);
+        }
+        return items;
+    }
+
+private slots:
+    void initTestCase()
+    {
+        shapePixmap = QPixmap(160, 160);
+        shapePixmap.fill(Qt::white);
+    }
+
+    void benchInsert_data()
+    {
+        addColumns();
+    }
+
+    void benchInsert()
+    {
+        QFETCH(int, method);
+        QFETCH(int, count);
+        QBENCHMARK
+        {
+            Scene scene;
+            scene.setIndexMethod(IndexMethod(method));
+            populate(scene, count);
+            scene.diagramItems(QPointF(0, 0));                      // BSP 在第一次查询时才建立索引
+        }
+    }
+
+    void benchMove_data()
+    {
+        addColumns();
+    }
+
+    void benchMove()
+    {
+        QFETCH(int, method);
+        QFETCH(int, count);
+        Scene scene;
+        scene.setIndexMethod(IndexMethod(method));
+        QList<PixmapItem*> items = populate(scene, count);
+        scene.diagramItems(QPointF(0, 0));
+
+        // 模拟拖动：每帧移动 500 个图形后做一次命中查询
+        int moved = qMin(500, count);
+        int frame = 0;
+        QBENCHMARK
+        {
+            QPointF delta(frame % 2 == 0 ? 3 : -3, 0);
+            for (int i = 0; i < moved; ++i)
+            {
+                items[i]->setPos(items[i]->pos() + delta);
+            }
+            scene.diagramItems(items[0]->pos() + QPointF(80, 80));
+            ++frame;
+        }
+    }
+
+    void benchQuery_data()
+    {
+        addColumns();
+    }
+
+    void benchQuery()
+    {
+        QFETCH(int, method);
+        QFETCH(int, count);
+        Scene scene;
+        scene.setIndexMethod(IndexMethod(method));
+        populate(scene, count);
+        scene.diagramItems(QPointF(0, 0));
+
+        // 1000 次点查询和 100 次视口大小的区域查询
+        int extent = qCeil(qSqrt(count)) * spacing;
+        QRandomGenerator random(42);
+        QVector<QPointF> points;
+        QVector<QRectF> rects;
+        for (int i = 0; i < 1000; ++i)
+        {
+            points.append(QPointF(random.bounded(extent), random.bounded(extent)));
+        }
+        for (int i = 0; i < 100; ++i)
+        {
+            rects.append(QRectF(random.bounded(extent), random.bounded(extent), 1920, 1080));
+        }
+        int hits = 0;
+        QBENCHMARK
+        {
+            for (const QPointF& point : qAsConst(points))
+            {
+                hits += scene.diagramItems(point).count();
+            }
+            for (const QRectF& rect : qAsConst(rects))
+            {
+                hits += scene.diagramItems(rect).count();
+            }
+        }
+        QVERIFY(hits > 0);
+    }
+};
+
+FLOWCHARTS_BENCHMARK_MAIN(BenchSceneIndex)
+#include "benchsceneindex.moc"
@@ -0,0 +1,6 @@
+include(../benchmarks.pri)
+
+TARGET = sceneindex
+
+SOURCES += \
+    benchsceneindex.cpp
@@ -0,0 +1,63 @@
+﻿#include <QtTest>
+#include "benchmain.h"
+#include "mainwindow.h"
+
+// 测量主窗口的启动时间
+// 冷启动时图标缓存为空，需要光栅化所有图形的SVG；热启动时直接读取缓存的PNG
+// benchStartupPhase 按启动时间线报告显示后画完第一帧和创建完其余界面（可交互）的时间
+class BenchStartup : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase()
+    {
+        QStandardPaths::setTestModeEnabled(true);   // 缓存写到测试目录，不影响用户的缓存
+    }
+
+    void cleanupTestCase()
+    {
+        IconCache().clear();
+    }
+
+    void benchConstruct_data()
+    {
+        QTest::addColumn<bool>("warmCache");
+        QTest::newRow("cold-cache") << false;
+        QTest::newRow("warm-cache") << true;
+    }
+    void benchConstruct()
+    {
+        QFETCH(bool, warmCache);
+        IconCache cache;
+        cache.clear();
+        if (warmCache)
+        {
+            delete new MainWindow();                // 先启动一次写入缓存
+        }
+        // 每次启动都会改变缓存，只测量一次
+        QBENCHMARK_ONCE
+        {
+            MainWindow window;
+        }
+    }
+
+    void benchStartupPhase_data()
+    {
+        QTest::addColumn<QString>("phase");
+        QTest::newRow("first-frame") << "firstFrame";
+        QTest::newRow("interactive") << "interactive";
+    }
+    void benchStartupPhase()
+    {
+        QFETCH(QString, phase);
+        StartupTrace::start();
+        MainWindow window;
+        window.show();
+        QTRY_VERIFY(window.isStartupFinished());
+        QTest::setBenchmarkResult(StartupTrace::elapsed(phase) / 1e6, QTest::WalltimeMilliseconds);
+    }
+};
+
+FLOWCHARTS_BENCHMARK_MAIN(BenchStartup)
+#include "benchstartup.moc"
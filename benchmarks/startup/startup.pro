@@ -0,0 +1,17 @@
+include(../benchmarks.pri)
+
+TARGET = startup
+
+SOURCES += \
+    benchstartup.cpp \
+    ../../flowlayout.cpp \
+    ../../mainwindow.cpp \
+    ../../chartbutton.cpp
+
+HEADERS += \
+    ../../flowlayout.h \
+    ../../mainwindow.h \
+    ../../chartbutton.h
+
+FORMS += \
+    ../../mainwindow.ui
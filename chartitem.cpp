@@ -1,17 +1,19 @@
 ﻿#include "chartitem.h"
+#include "scene.h"
+#include "profiler.h"
+
+#include <QCoreApplication>
+#include <QPointer>
 
 ChartItem::ChartItem(FlowEnumItem type, QGraphicsItem* parent, QString Uid)
-    : QGraphicsSvgItem(parent), Uid(Uid), chartType(type),  currentFillColor("w"), currentBorderColor("b")
+    : QGraphicsSvgItem(parent), Uid(Uid), chartType(type), style(0)
 {
     this->setAcceptHoverEvents(true);                                           // 设置接受悬停事件
     setFlag(QGraphicsSvgItem::ItemIsMovable, true);                             // 设置图形项可移动
     setFlag(QGraphicsSvgItem::ItemIsSelectable, true);                          // 设置图形项可选中
     setFlag(QGraphicsSvgItem::ItemSendsGeometryChanges, true);                  // 设置几何变更事件
     this->Uid = QUuid::createUuid().toString(QUuid::WithoutBraces);             // 生成新的唯一ID
-    svgRender = new QSvgRenderer;                                               // 创建SVG渲染器
-    svgRender->load(QString(":/image/flowchart/icon/fc-%1-bw.svg").arg(type));  // 加载对应类型的SVG文件
-    setSharedRenderer(svgRender);                                               // 设置共享渲染器
-    currentSvgPath = QString(":/image/flowchart/icon/fc-%1-bw.svg").arg(type);  // 初始化currentSvgPath为默认路径
+    updateRenderer();                                                           // 使用对应类型的共享渲染器
     text = QString(FlowTypeStrings[type - 1]).replace("流程图：", "");           // 设置文本，去掉“流程图：”前缀
     setTransform(transform().scale(10, 10));                                    // 设置标题，去掉“流程图：”前缀
 
@@ -34,73 +36,86 @@ void ChartItem::setChartType(FlowEnumItem type)
     {
         chartType = type;
     }
-    currentSvgPath = QString(":/image/flowchart/icon/fc-%1-%2%3.svg").arg(static_cast<int>(chartType)).arg(currentBorderColor).arg(currentFillColor);
-    svgRender->load(currentSvgPath);
-    setSharedRenderer(svgRender);   // 更新渲染器
+    updateRenderer();
+    Scene::updateGraphItem(this);       // 类型影响流程检查
 }
 
 QString ChartItem::getCurrentFillColor() const
 {
-    return currentFillColor;
+    return DiagramModel::fillColor(style);
 }
 
 void ChartItem::setCurrentFillColor(const QString& color)
 {
-    if (color == "r" || color == "g" || color == "y" || color == "w")
+    if (DiagramModel::isFillColor(color))
     {
-        currentFillColor = color;
+        setStyle(DiagramModel::styleId(getCurrentBorderColor(), color));
     }
-    currentSvgPath = QString(":/image/flowchart/icon/fc-%1-%2%3.svg").arg(static_cast<int>(chartType)).arg(currentBorderColor).arg(currentFillColor);
-    svgRender->load(currentSvgPath);
-    setSharedRenderer(svgRender);   // 更新渲染器
 }
 
 QString ChartItem::getCurrentBorderColor() const
 {
-    return currentBorderColor;
+    return DiagramModel::borderColor(style);
 }
 
 void ChartItem::setCurrentBorderColor(const QString& color)
 {
-    if (color == "r" || color == "l" || color == "b")
+    if (DiagramModel::isBorderColor(color))
     {
-        currentBorderColor = color;
+        setStyle(DiagramModel::styleId(color, getCurrentFillColor()));
     }
-    currentSvgPath = QString(":/image/flowchart/icon/fc-%1-%2%3.svg").arg(static_cast<int>(chartType)).arg(currentBorderColor).arg(currentFillColor);
-    svgRender->load(currentSvgPath);
-    setSharedRenderer(svgRender);   // 更新渲染器
 }
 
 QString ChartItem::getCurrentPath(){
-    return currentSvgPath;
+    return DiagramModel::svgPath(static_cast<int>(chartType), style);
 }
 
-void ChartItem::setCurrentPath(QString currentPath)
+int ChartItem::getStyle() const
 {
-    currentSvgPath = currentPath;
-    svgRender->load(currentSvgPath);
-    setSharedRenderer(svgRender);   // 更新渲染器
+    return style;
 }
 
-int ChartItem::type() const
+void ChartItem::setStyle(int style)
 {
-    return Type;
+    if (style >= 0 && style < DiagramModel::styleCount)
+    {
+        this->style = style;
+    }
+    updateRenderer();
+}
+
+QSvgRenderer* ChartItem::sharedRenderer(int type, int style)
+{
+    // 每种类型和样式的图元只解析一次，渲染器随应用程序释放
+    static QHash<int, QPointer<QSvgRenderer>> renderers;
+    int key = type * DiagramModel::styleCount + style;
+    QSvgRenderer* renderer = renderers.value(key);
+    if (renderer == nullptr)
+    {
+        renderer = new QSvgRenderer(DiagramModel::svgPath(type, style), QCoreApplication::instance());
+        renderers.insert(key, renderer);
+    }
+    return renderer;
+}
+
+void ChartItem::updateRenderer()
+{
+    QSvgRenderer* renderer = sharedRenderer(static_cast<int>(chartType), style);
+    if (renderer != svgRender)
+    {
+        svgRender = renderer;
+        setSharedRenderer(svgRender);   // 更新渲染器
+    }
 }
 
-extern QPainterPath qt_regionToPath(const QRegion& region);
+ChartItem::~ChartItem()
+{
+    Scene::removeItemIndex(this);       // 析构时不会收到场景变更事件
+}
 
-void ChartItem::getPolys()
+int ChartItem::type() const
 {
-    QPixmap* pixmap = new QPixmap(svgRender->defaultSize());            // 创建一个与SVG大小相同的QPixmap
-    pixmap->fill(Qt::transparent);                                      // 设置背景透明
-    QPainter painter(pixmap);                                           // 创建QPainter对象
-    painter.setRenderHints(QPainter::Antialiasing);                     // 开启抗锯齿
-    svgRender->render(&painter);                                        // 渲染SVG内容到pixmap
-    pixmap = new QPixmap(pixmap->transformed(this->transform()));       // 应用当前变换
-    QBitmap mask = pixmap->mask();                                      // 获取像素掩码
-    QPainterPath mappath = qt_regionToPath(QRegion(mask));              // 将掩码转换为路径
-    mappath.translate(this->transform().dx(), this->transform().dy());  // 将路径平移到当前变换的dx和dy位置
-    delete pixmap;                                                      // 删除pixmap，释放内存
+    return Type;
 }
 
 QPainterPath ChartItem::shape() const
@@ -109,9 +124,54 @@ QPainterPath ChartItem::shape() const
     return path;                                    // 返回形状
 }
 
+int ChartItem::getWarnings() const
+{
+    return warnings;
+}
+
+void ChartItem::setWarnings(int warnings)
+{
+    if (this->warnings == warnings)
+    {
+        return;
+    }
+    this->warnings = warnings;
+    QStringList messages;
+    if (warnings & GraphAnalysis::Unreachable)
+    {
+        messages << tr("从开始图形无法到达");
+    }
+    if (warnings & GraphAnalysis::DeadEnd)
+    {
+        messages << tr("无法到达结束图形");
+    }
+    if (warnings & GraphAnalysis::JudgeBranches)
+    {
+        messages << tr("判定的分支少于两个");
+    }
+    if (warnings & GraphAnalysis::InCycle)
+    {
+        messages << tr("位于环路中");
+    }
+    setToolTip(messages.join("\n"));
+    update();
+}
+
 void ChartItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
 {
+    PROFILE_PAINT(ChartPaint);
     QGraphicsSvgItem::paint(painter, option, widget);  // 调用基类的绘制方法
+    if (warnings != GraphAnalysis::NoWarning)
+    {
+        // 右上角的警告标记，只有环路时为橙色
+        QRectF rect = boundingRect();
+        qreal radius = rect.width() / 8;
+        painter->save();
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(warnings == GraphAnalysis::InCycle ? QColor(255, 140, 0) : QColor(220, 0, 0));
+        painter->drawEllipse(QPointF(rect.right() - radius, rect.top() + radius), radius, radius);
+        painter->restore();
+    }
 }
 
 QVariant ChartItem::itemChange(GraphicsItemChange change, const QVariant &value)
@@ -145,14 +205,38 @@ QVariant ChartItem::itemChange(GraphicsItemChange change, const QVariant &value)
     // 处理几何变更事件
     else if (change == QGraphicsSvgItem::ItemTransformHasChanged)
     {
-        getPolys();                     // 更新多边形路径
-        emit itemPositionHasChanged();  // 发射位置变更信号
+        Scene::updateItemIndex(this);   // 更新网格索引
+        markLayoutDirty();              // 等待下一次布局更新关联的文本和线
     }
     // 处理位置变更事件
     else if (change == QGraphicsSvgItem::ItemPositionHasChanged)
     {
-        emit itemPositionHasChanged(); // 发射位置变更信号
+        Scene::updateItemIndex(this);   // 更新网格索引
+        markLayoutDirty();              // 等待下一次布局更新关联的文本和线
+    }
+    // 处理场景变更事件
+    else if (change == QGraphicsSvgItem::ItemSceneChange)
+    {
+        Scene::removeItemIndex(this);   // 从原场景的索引中移除
+    }
+    else if (change == QGraphicsSvgItem::ItemSceneHasChanged)
+    {
+        Scene::updateItemIndex(this);   // 登记到新场景的索引
+        Scene::updateGraphItem(this);   // 登记到流程检查
     }
     // 返回基类的处理结果
     return QGraphicsSvgItem::itemChange(change, value);
 }
+
+void ChartItem::markLayoutDirty()
+{
+    Scene* flowScene = qobject_cast<Scene*>(scene());
+    if (flowScene)
+    {
+        flowScene->markLayoutDirty(this);   // 同一帧内的多次移动合并为一次更新
+    }
+    else
+    {
+        emit itemPositionHasChanged();      // 不在场景中时直接通知
+    }
+}
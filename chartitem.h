@@ -8,6 +8,8 @@
 
 #include "qpainter.h"
 #include "controlpoint.h"
+#include "diagrammodel.h"
+#include "graphanalysis.h"
 
 // 图形类型
 enum FlowEnumItem
@@ -42,10 +44,12 @@ class ChartItem : public QGraphicsSvgItem
     Q_OBJECT
 public:
     ChartItem(FlowEnumItem flowtype = FlowEnumItem::StartOrEnd, QGraphicsItem* parent = nullptr, QString Uid = "");
+    ~ChartItem() override;
 
-    QSvgRenderer* svgRender = nullptr;                                                                  // 数据源
+    QSvgRenderer* svgRender = nullptr;                                                                  // 数据源，同类型同样式的图形共用
     QString text;                                                                                       // 文本内容
     QString Uid = "";                                                                                   // 唯一识别id
+    bool layoutDirty = false;                                                                           // 是否已排入场景的布局队列
 
     enum { Type = UserType + 1 };                                                                       // 类型标识
 
@@ -56,7 +60,11 @@ public:
     QString getCurrentBorderColor() const;                                                              // 返回边框颜色
     void setCurrentBorderColor(const QString& color);                                                   // 设置边框的颜色
     QString getCurrentPath();                                                                           // 获取SVG路径
-    void setCurrentPath(QString currentPath);                                                           // 更新SVG路径
+    int getStyle() const;                                                                               // 返回样式编号
+    void setStyle(int style);                                                                           // 设置样式编号，见 DiagramModel::styleId
+    static QSvgRenderer* sharedRenderer(int type, int style);                                           // 按类型和样式缓存的渲染器
+    int getWarnings() const;                                                                            // 返回流程检查的警告，见 GraphAnalysis::Warning
+    void setWarnings(int warnings);                                                                     // 设置警告，显示标记和提示
     int type() const override;                                                                          // 返回图片类型
 
 protected:
@@ -67,15 +75,15 @@ protected:
 
 private:
     FlowEnumItem chartType;                             // 图形类型
-    QString currentFillColor;                           // 当前填充颜色
-    QString currentBorderColor;                         // 当前边框颜色
-    QString currentSvgPath;                             // 当前数据源文本
+    int style;                                          // 样式编号：边框颜色和填充颜色的组合
+    int warnings = GraphAnalysis::NoWarning;            // 流程检查的警告
     QPointF clickPosition;                              // 鼠标按下时的位置
 
-    void getPolys();                                    // 获取外接轮廓
+    void updateRenderer();                              // 切换到当前类型和样式的共享渲染器
+    void markLayoutDirty();                             // 标记需要重新布局
 
 signals:
-    void itemPositionHasChanged();
+    void itemPositionHasChanged();                                                                      // 位置改变，由场景在每帧布局时统一发出
 };
 
 #endif // CHARTITEM_H
@@ -108,7 +108,7 @@ void ControlPoint::setParentItemTransform(QPointF postop, QPointF posbtn)
     this->parentItem()->setTransform(tran);
     this->update();
 
-    (qobject_cast<View*>(this->parentItem()->scene()->parent()))->operationStack->addOperation(new ChangeOperation(oldtran, tran, this->parentItem()));
+    qobject_cast<Scene*>(this->parentItem()->scene())->addOperation(new ChangeOperation(oldtran, tran, this->parentItem()));
 }
 
 QRectF ControlPoint::boundingRect() const
@@ -0,0 +1,91 @@
+﻿#include "backgroundrenderer.h"
+
+#include <QPainter>
+#include <QtMath>
+
+// qBound 等按引用传参，C++11 下需要类外定义
+const int BackgroundRenderer::tileSize;
+const int BackgroundRenderer::minBucket;
+const int BackgroundRenderer::maxBucket;
+
+BackgroundRenderer::BackgroundRenderer(int cacheKilobytes)
+    : tiles(cacheKilobytes)
+{
+}
+
+void BackgroundRenderer::setImage(const QImage& image)
+{
+    this->image = image;
+    tiles.clear();
+}
+
+void BackgroundRenderer::clear()
+{
+    setImage(QImage());
+}
+
+int BackgroundRenderer::bucketFor(qreal scale)
+{
+    if (scale <= 0)
+    {
+        return 0;
+    }
+    return qBound(minBucket, qCeil(std::log2(scale) - 1e-9), maxBucket);
+}
+
+QPixmap* BackgroundRenderer::tile(int bucket, int column, int row)
+{
+    quint64 key = (quint64(bucket - minBucket) << 56) | (quint64(column) << 28) | quint64(row);
+    QPixmap* pixmap = tiles.object(key);
+    if (pixmap != nullptr)
+    {
+        return pixmap;
+    }
+    // 一块对应原图中边长为 span 的区域，缩放到 tileSize 像素，边缘的块只包含剩余部分
+    qreal factor = qPow(2, bucket);
+    int span = qRound(tileSize / factor);
+    QRect source = QRect(column * span, row * span, span, span) & image.rect();
+    QSize size(qMax(1, qCeil(source.width() * factor)), qMax(1, qCeil(source.height() * factor)));
+    pixmap = new QPixmap(QPixmap::fromImage(image.copy(source).scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)));
+    tiles.insert(key, pixmap, qMax(1, size.width() * size.height() * 4 / 1024));
+    return pixmap;
+}
+
+void BackgroundRenderer::draw(QPainter* painter, const QRectF& exposed)
+{
+    if (image.isNull() || exposed.isEmpty())
+    {
+        return;
+    }
+    QTransform transform = painter->worldTransform();
+    int bucket = bucketFor(qSqrt(qAbs(transform.determinant())));
+    int span = qRound(tileSize / qPow(2, bucket));
+    int width = image.width();
+    int height = image.height();
+    int columns = (width + span - 1) / span;
+    int rows = (height + span - 1) / span;
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+    // 与暴露区域相交的每个重复单元中，只画相交的块
+    for (int j = qFloor(exposed.top() / height); j * height < exposed.bottom(); ++j)
+    {
+        for (int i = qFloor(exposed.left() / width); i * width < exposed.right(); ++i)
+        {
+            QPointF origin(i * width, j * height);
+            QRectF local = exposed.translated(-origin) & QRectF(0, 0, width, height);
+            int lastColumn = qMin(columns - 1, qFloor(local.right() / span));
+            int lastRow = qMin(rows - 1, qFloor(local.bottom() / span));
+            for (int row = qMax(0, qFloor(local.top() / span)); row <= lastRow; ++row)
+            {
+                for (int column = qMax(0, qFloor(local.left() / span)); column <= lastColumn; ++column)
+                {
+                    QRectF target = QRectF(column * span, row * span, span, span) & QRectF(0, 0, width, height);
+                    QPixmap* pixmap = tile(bucket, column, row);
+                    painter->drawPixmap(target.translated(origin), *pixmap, QRectF(pixmap->rect()));
+                }
+            }
+        }
+    }
+    painter->restore();
+}
@@ -0,0 +1,38 @@
+﻿#ifndef BACKGROUNDRENDERER_H
+#define BACKGROUNDRENDERER_H
+
+#include <QCache>
+#include <QImage>
+#include <QPixmap>
+
+class QPainter;
+
+// 平铺的背景图片：按视图缩放比例取最近的2的幂作为档位，每档把图片切成 tileSize 像素的块并缓存
+// 绘制时只画与暴露区域相交的块，每块由绘制器再缩放不超过2倍，平移和重绘时不再缩放整张图片
+// 图片从场景原点开始向各个方向重复，与以图片为纹理的画刷相同
+class BackgroundRenderer
+{
+public:
+    static const int tileSize = 256;                                    // 每块的像素边长
+    static const int minBucket = -4;                                    // 最小档位，缩小到1/16以下时由绘制器继续缩小
+    static const int maxBucket = 2;                                     // 最大档位，放大到4倍以上时由绘制器继续放大
+
+    explicit BackgroundRenderer(int cacheKilobytes = 64 * 1024);        // 缓存的块的总大小上限
+
+    void setImage(const QImage& image);                                 // 设置背景图片，图片的像素大小即重复单元在场景中的大小，清空缓存
+    void clear();
+    bool isNull() const { return image.isNull(); }
+    QSize imageSize() const { return image.size(); }
+    int cachedTiles() const { return tiles.count(); }
+    void draw(QPainter* painter, const QRectF& exposed);                // 在场景坐标的 exposed 区域内绘制背景
+
+    static int bucketFor(qreal scale);                                  // 不小于 scale 的2的幂的指数，限制在档位范围内
+
+private:
+    QImage image;
+    QCache<quint64, QPixmap> tiles;                                     // 键由档位和块的行列组成，代价为千字节数
+
+    QPixmap* tile(int bucket, int column, int row);                     // 取出或生成一块
+};
+
+#endif // BACKGROUNDRENDERER_H
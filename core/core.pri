@@ -0,0 +1,11 @@
+# 链接核心库 flowcore，需要从顶层 FlowCharts.pro 构建以保证核心库先编译
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+FLOWCORE_DIR = $$shadowed($$PWD)
+win32:CONFIG(release, debug|release): FLOWCORE_DIR = $$FLOWCORE_DIR/release
+else:win32:CONFIG(debug, debug|release): FLOWCORE_DIR = $$FLOWCORE_DIR/debug
+
+LIBS += -L$$FLOWCORE_DIR -lflowcore
+win32-msvc*: PRE_TARGETDEPS += $$FLOWCORE_DIR/flowcore.lib
+else: PRE_TARGETDEPS += $$FLOWCORE_DIR/libflowcore.a
@@ -0,0 +1,43 @@
+# 核心库 flowcore：流程图的数据模型、撤销栈、空间索引以及布局和布线算法，只依赖 QtCore 和 QtGui
+# 无界面工具、基准测试和工作线程可以直接链接，不需要创建任何控件
+TEMPLATE = lib
+TARGET = flowcore
+QT = core gui
+
+CONFIG += staticlib c++11
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    backgroundrenderer.cpp \
+    diagrammodel.cpp \
+    edgebundler.cpp \
+    graphanalysis.cpp \
+    iconcache.cpp \
+    imagestore.cpp \
+    incrementalrouter.cpp \
+    labelindex.cpp \
+    layeredlayout.cpp \
+    layoutsearch.cpp \
+    mippyramid.cpp \
+    operationstack.cpp \
+    orthogonalrouter.cpp \
+    projectfile.cpp \
+    textreplacer.cpp
+
+HEADERS += \
+    backgroundrenderer.h \
+    diagrammodel.h \
+    edgebundler.h \
+    graphanalysis.h \
+    iconcache.h \
+    imagestore.h \
+    incrementalrouter.h \
+    labelindex.h \
+    layeredlayout.h \
+    layoutsearch.h \
+    mippyramid.h \
+    operationstack.h \
+    orthogonalrouter.h \
+    projectfile.h \
+    spatialgrid.h \
+    textreplacer.h
@@ -0,0 +1,565 @@
+﻿#include "diagrammodel.h"
+
+#include <QHash>
+#include <QUuid>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+static const char borderCodes[] = "blr";                 // 黑、蓝、红
+static const char fillCodes[] = "wrgy";                  // 白、红、绿、黄
+
+// 颜色代码在代码表中的下标，不在表中时返回-1
+static int codeIndex(const char* codes, const QString& color)
+{
+    if (color.size() == 1)
+    {
+        for (int i = 0; codes[i] != 0; ++i)
+        {
+            if (color.at(0) == QLatin1Char(codes[i]))
+            {
+                return i;
+            }
+        }
+    }
+    return -1;
+}
+
+bool DiagramModel::isEmpty() const
+{
+    return nodeUids.isEmpty() && edgeUids.isEmpty() && labelUids.isEmpty() && pictureUids.isEmpty();
+}
+
+void DiagramModel::clear()
+{
+    *this = DiagramModel();
+}
+
+void DiagramModel::reserve(int nodes, int edges, int labels)
+{
+    nodeUids.reserve(nodes);
+    nodePositions.reserve(nodes);
+    nodeTransforms.reserve(nodes);
+    nodeTypes.reserve(nodes);
+    nodeStyles.reserve(nodes);
+    edgeUids.reserve(edges);
+    edgeStarts.reserve(edges);
+    edgeEnds.reserve(edges);
+    edgeColors.reserve(edges);
+    edgeLines.reserve(edges);
+    labelUids.reserve(labels);
+    labelTexts.reserve(labels);
+    labelColors.reserve(labels);
+    labelFonts.reserve(labels);
+    labelPositions.reserve(labels);
+    labelTransforms.reserve(labels);
+    labelOwners.reserve(labels);
+    labelOwnerIndices.reserve(labels);
+}
+
+int DiagramModel::addNode(const QString& uid, int type, QPointF position, const QTransform& transform, int style)
+{
+    nodeUids.append(uid);
+    nodePositions.append(position);
+    nodeTransforms.append(transform);
+    nodeTypes.append(quint8(type));
+    nodeStyles.append(quint8(style));
+    return nodeUids.size() - 1;
+}
+
+int DiagramModel::addEdge(const QString& uid, int start, int end, const QLineF& line, QRgb color)
+{
+    edgeUids.append(uid);
+    edgeStarts.append(start);
+    edgeEnds.append(end);
+    edgeColors.append(color);
+    edgeLines.append(line);
+    return edgeUids.size() - 1;
+}
+
+int DiagramModel::addLabel(const QString& uid, const QString& text, QPointF position, const QFont& font, QRgb color,
+                           const QTransform& transform, LabelOwner owner, int ownerIndex)
+{
+    labelUids.append(uid);
+    labelTexts.append(text);
+    labelColors.append(color);
+    labelFonts.append(fontId(font));
+    labelPositions.append(position);
+    labelTransforms.append(transform);
+    labelOwners.append(quint8(owner));
+    labelOwnerIndices.append(owner == NoOwner ? -1 : ownerIndex);
+    return labelUids.size() - 1;
+}
+
+int DiagramModel::addPicture(const QString& uid, const QString& image, QPointF position, QSize size)
+{
+    pictureUids.append(uid);
+    pictureImages.append(image);
+    picturePositions.append(position);
+    pictureSizes.append(size);
+    return pictureUids.size() - 1;
+}
+
+int DiagramModel::fontId(const QFont& font)
+{
+    // 一张流程图中的字体种类很少，线性查找即可
+    int index = fonts.indexOf(font);
+    if (index < 0)
+    {
+        index = fonts.size();
+        fonts.append(font);
+    }
+    return index;
+}
+
+QPointF DiagramModel::center() const
+{
+    double x = 0;
+    double y = 0;
+    for (const QPointF& position : nodePositions)
+    {
+        x += position.x();
+        y += position.y();
+    }
+    for (const QPointF& position : labelPositions)
+    {
+        x += position.x();
+        y += position.y();
+    }
+    for (const QPointF& position : picturePositions)
+    {
+        x += position.x();
+        y += position.y();
+    }
+    int count = nodePositions.size() + labelPositions.size() + picturePositions.size();
+    return count > 0 ? QPointF(x / count, y / count) : QPointF();
+}
+
+void DiagramModel::translate(QPointF offset)
+{
+    QPointF* nodes = nodePositions.data();
+    for (int i = 0, n = nodePositions.size(); i < n; ++i)
+    {
+        nodes[i] += offset;
+    }
+    QLineF* lines = edgeLines.data();
+    for (int i = 0, n = edgeLines.size(); i < n; ++i)
+    {
+        lines[i].translate(offset);
+    }
+    QPointF* labels = labelPositions.data();
+    for (int i = 0, n = labelPositions.size(); i < n; ++i)
+    {
+        labels[i] += offset;
+    }
+    QPointF* pictures = picturePositions.data();
+    for (int i = 0, n = picturePositions.size(); i < n; ++i)
+    {
+        pictures[i] += offset;
+    }
+}
+
+void DiagramModel::translateNodes(const QVector<int>& nodes, QPointF offset)
+{
+    QVector<quint8> moved(nodeUids.size(), 0);
+    QPointF* positions = nodePositions.data();
+    for (int node : nodes)
+    {
+        positions[node] += offset;
+        moved[node] = 1;
+    }
+    QLineF* lines = edgeLines.data();
+    for (int i = 0, n = edgeLines.size(); i < n; ++i)
+    {
+        if (moved.at(edgeStarts.at(i)) & moved.at(edgeEnds.at(i)))
+        {
+            lines[i].translate(offset);
+        }
+    }
+}
+
+void DiagramModel::setNodeStyles(const QVector<int>& nodes, int style)
+{
+    quint8* styles = nodeStyles.data();
+    for (int node : nodes)
+    {
+        styles[node] = quint8(style);
+    }
+}
+
+void DiagramModel::regenerateUids()
+{
+    // 关联关系用下标保存，只需替换ID本身
+    for (QString& uid : nodeUids)
+    {
+        uid = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    }
+    for (QString& uid : edgeUids)
+    {
+        uid = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    }
+    for (QString& uid : labelUids)
+    {
+        uid = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    }
+    for (QString& uid : pictureUids)
+    {
+        uid = QUuid::createUuid().toString(QUuid::WithoutBraces);
+    }
+}
+
+QRectF DiagramModel::nodeBounds(int node) const
+{
+    return nodeTransforms.at(node).mapRect(QRectF(0, 0, nodeSize, nodeSize)).translated(nodePositions.at(node));
+}
+
+QRectF DiagramModel::boundingRect() const
+{
+    QRectF bounds;
+    for (int i = 0, n = nodeUids.size(); i < n; ++i)
+    {
+        bounds |= nodeBounds(i);
+    }
+    for (const QLineF& line : edgeLines)
+    {
+        bounds |= QRectF(line.p1(), line.p2()).normalized();
+    }
+    for (int i = 0, n = pictureUids.size(); i < n; ++i)
+    {
+        bounds |= QRectF(picturePositions.at(i), pictureSizes.at(i));
+    }
+    return bounds;
+}
+
+QVector<int> DiagramModel::nodesInRect(const QRectF& rect) const
+{
+    QVector<int> result;
+    for (int i = 0, n = nodeUids.size(); i < n; ++i)
+    {
+        if (nodeBounds(i).intersects(rect))
+        {
+            result.append(i);
+        }
+    }
+    return result;
+}
+
+int DiagramModel::nodeAt(QPointF point) const
+{
+    // 后添加的图形在上层，从后往前找
+    for (int i = nodeUids.size() - 1; i >= 0; --i)
+    {
+        if (nodeBounds(i).contains(point))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int DiagramModel::styleId(const QString& borderColor, const QString& fillColor)
+{
+    return qMax(codeIndex(borderCodes, borderColor), 0) * 4 + qMax(codeIndex(fillCodes, fillColor), 0);
+}
+
+QString DiagramModel::borderColor(int style)
+{
+    return QString(QLatin1Char(borderCodes[(style / 4) % 3]));
+}
+
+QString DiagramModel::fillColor(int style)
+{
+    return QString(QLatin1Char(fillCodes[style % 4]));
+}
+
+bool DiagramModel::isBorderColor(const QString& color)
+{
+    return codeIndex(borderCodes, color) >= 0;
+}
+
+bool DiagramModel::isFillColor(const QString& color)
+{
+    return codeIndex(fillCodes, color) >= 0;
+}
+
+QString DiagramModel::svgPath(int type, int style)
+{
+    return QString(":/image/flowchart/icon/fc-%1-%2%3.svg").arg(type).arg(borderColor(style)).arg(fillColor(style));
+}
+
+QString DiagramModel::transformToString(const QTransform& transform)
+{
+    QStringList trans;
+    trans << QString::number(transform.m11()) << QString::number(transform.m12()) << QString::number(transform.m13());
+    trans << QString::number(transform.m21()) << QString::number(transform.m22()) << QString::number(transform.m23());
+    trans << QString::number(transform.m31()) << QString::number(transform.m32()) << QString::number(transform.m33());
+    return trans.join(" ");
+}
+
+bool DiagramModel::transformFromString(const QString& text, QTransform* transform)
+{
+    QStringList tranlist = text.split(" ");
+    if (tranlist.size() != 9)
+    {
+        return false;
+    }
+    *transform = QTransform(tranlist[0].toDouble(), tranlist[1].toDouble(), tranlist[2].toDouble(),
+                            tranlist[3].toDouble(), tranlist[4].toDouble(), tranlist[5].toDouble(),
+                            tranlist[6].toDouble(), tranlist[7].toDouble(), tranlist[8].toDouble());
+    return true;
+}
+
+bool DiagramModel::writeXml(QIODevice* device) const
+{
+    QXmlStreamWriter xml(device);
+    xml.setAutoFormatting(true);
+    xml.writeStartDocument();
+    xml.writeStartElement("FlowCharts");
+    xml.writeAttribute("guid", guid);
+    xml.writeAttribute("Tabname", tabName);
+    writeItems(xml);
+    if (!backgroundImage.isEmpty() && images.contains(backgroundImage))
+    {
+        xml.writeStartElement("Background");
+        xml.writeAttribute("Image", backgroundImage);
+        xml.writeAttribute("Width", QString::number(backgroundSize.width()));
+        xml.writeAttribute("Height", QString::number(backgroundSize.height()));
+        xml.writeEndElement();
+    }
+    xml.writeEndElement();
+    xml.writeEndDocument();
+    return !xml.hasError();
+}
+
+bool DiagramModel::readXml(QIODevice* device, QString* errorString)
+{
+    QXmlStreamReader reader(device);
+    return readItems(reader, errorString);
+}
+
+QString DiagramModel::toClipboardXml() const
+{
+    QString clipboardData;
+    QXmlStreamWriter xml(&clipboardData);
+    xml.setAutoFormatting(true);
+    xml.writeStartDocument();
+    xml.writeStartElement("CopiedItems");
+    writeItems(xml);
+    xml.writeEndElement();
+    xml.writeEndDocument();
+    return clipboardData;
+}
+
+bool DiagramModel::fromClipboardXml(const QString& data, QString* errorString)
+{
+    QXmlStreamReader reader(data);
+    return readItems(reader, errorString);
+}
+
+void DiagramModel::writeItems(QXmlStreamWriter& xml) const
+{
+    // 图片数据每个哈希只写一次，图片项和背景只引用哈希
+    for (QHash<QString, QByteArray>::const_iterator it = images.constBegin(); it != images.constEnd(); ++it)
+    {
+        xml.writeStartElement("Image");
+        xml.writeAttribute("Hash", it.key());
+        xml.writeCharacters(QString::fromLatin1(it.value().toBase64()));
+        xml.writeEndElement();
+    }
+
+    for (int i = 0, n = nodeUids.size(); i < n; ++i)
+    {
+        int style = nodeStyles.at(i);
+        xml.writeStartElement("ChartItem");
+        xml.writeAttribute("Uid", nodeUids.at(i));
+        xml.writeAttribute("FlowType", QString::number(nodeTypes.at(i)));
+        xml.writeAttribute("FillColor", fillColor(style));
+        xml.writeAttribute("BorderColor", borderColor(style));
+        xml.writeAttribute("SvgPath", svgPath(nodeTypes.at(i), style));
+        xml.writeAttribute("QTransform", transformToString(nodeTransforms.at(i)));
+        xml.writeAttribute("X", QString::number(nodePositions.at(i).x()));
+        xml.writeAttribute("Y", QString::number(nodePositions.at(i).y()));
+        xml.writeEndElement();
+    }
+
+    for (int i = 0, n = edgeUids.size(); i < n; ++i)
+    {
+        const QLineF& line = edgeLines.at(i);
+        xml.writeStartElement("LineItem");
+        xml.writeAttribute("Uid", edgeUids.at(i));
+        xml.writeAttribute("myStartItem", nodeUids.value(edgeStarts.at(i)));
+        xml.writeAttribute("myEndItem", nodeUids.value(edgeEnds.at(i)));
+        xml.writeAttribute("myColor", QColor(edgeColors.at(i)).name());
+        xml.writeAttribute("x1", QString::number(line.x1()));
+        xml.writeAttribute("y1", QString::number(line.y1()));
+        xml.writeAttribute("x2", QString::number(line.x2()));
+        xml.writeAttribute("y2", QString::number(line.y2()));
+        xml.writeEndElement();
+    }
+
+    // 字体描述每种只生成一次
+    QStringList fontNames;
+    for (const QFont& font : fonts)
+    {
+        fontNames.append(font.toString());
+    }
+    for (int i = 0, n = labelUids.size(); i < n; ++i)
+    {
+        xml.writeStartElement("TextItem");
+        xml.writeAttribute("Uid", labelUids.at(i));
+        xml.writeAttribute("HtmlText", labelTexts.at(i));
+        xml.writeAttribute("defaultTextColor", QColor(labelColors.at(i)).name());
+        xml.writeAttribute("Font", fontNames.value(labelFonts.at(i)));
+        xml.writeAttribute("X", QString::number(labelPositions.at(i).x()));
+        xml.writeAttribute("Y", QString::number(labelPositions.at(i).y()));
+        xml.writeAttribute("QTransform", transformToString(labelTransforms.at(i)));
+        xml.writeEndElement();
+    }
+
+    for (int i = 0, n = pictureUids.size(); i < n; ++i)
+    {
+        xml.writeStartElement("PixmapItem");
+        xml.writeAttribute("Uid", pictureUids.at(i));
+        xml.writeAttribute("Image", pictureImages.at(i));
+        xml.writeAttribute("X", QString::number(picturePositions.at(i).x()));
+        xml.writeAttribute("Y", QString::number(picturePositions.at(i).y()));
+        xml.writeAttribute("Width", QString::number(pictureSizes.at(i).width()));
+        xml.writeAttribute("Height", QString::number(pictureSizes.at(i).height()));
+        xml.writeEndElement();
+    }
+
+    // 关联信息写在最后，读取时图形、连线和文本都已存在
+    for (int i = 0, n = labelUids.size(); i < n; ++i)
+    {
+        QString connectUid;
+        if (labelOwners.at(i) == NodeOwner)
+        {
+            connectUid = nodeUids.value(labelOwnerIndices.at(i));
+        }
+        else if (labelOwners.at(i) == EdgeOwner)
+        {
+            connectUid = edgeUids.value(labelOwnerIndices.at(i));
+        }
+        if (connectUid.isEmpty())
+        {
+            continue;
+        }
+        xml.writeStartElement("ConnectItem");
+        xml.writeAttribute("TextItemUid", labelUids.at(i));
+        xml.writeAttribute("ConnectItemUid", connectUid);
+        xml.writeEndElement();
+    }
+}
+
+bool DiagramModel::readItems(QXmlStreamReader& reader, QString* errorString)
+{
+    QHash<QString, int> nodeIndex;
+    QHash<QString, int> edgeIndex;
+    QHash<QString, int> labelIndex;
+    QHash<QString, int> fontIndex;                      // 字体描述到下标，避免重复解析
+
+    while (!reader.atEnd())
+    {
+        reader.readNext();
+        if (!reader.isStartElement())
+        {
+            continue;
+        }
+        QXmlStreamAttributes attributes = reader.attributes();
+        if (reader.name() == "FlowCharts")
+        {
+            guid = attributes.value("guid").toString();
+            tabName = attributes.value("Tabname").toString();
+        }
+        else if (reader.name() == "ChartItem")
+        {
+            // 图元路径由类型和样式决定，读取时不使用 SvgPath
+            QTransform transform;
+            transformFromString(attributes.value("QTransform").toString(), &transform);
+            QString uid = attributes.value("Uid").toString();
+            nodeIndex.insert(uid, nodeUids.size());
+            addNode(uid, attributes.value("FlowType").toInt(),
+                    QPointF(attributes.value("X").toDouble(), attributes.value("Y").toDouble()), transform,
+                    styleId(attributes.value("BorderColor").toString(), attributes.value("FillColor").toString()));
+        }
+        else if (reader.name() == "LineItem")
+        {
+            // 端点图形不存在的连线忽略
+            int start = nodeIndex.value(attributes.value("myStartItem").toString(), -1);
+            int end = nodeIndex.value(attributes.value("myEndItem").toString(), -1);
+            if (start < 0 || end < 0)
+            {
+                continue;
+            }
+            QString uid = attributes.value("Uid").toString();
+            edgeIndex.insert(uid, edgeUids.size());
+            addEdge(uid, start, end,
+                    QLineF(attributes.value("x1").toDouble(), attributes.value("y1").toDouble(),
+                           attributes.value("x2").toDouble(), attributes.value("y2").toDouble()),
+                    QColor(attributes.value("myColor").toString()).rgb());
+        }
+        else if (reader.name() == "TextItem")
+        {
+            QString fontName = attributes.value("Font").toString();
+            int font = fontIndex.value(fontName, -1);
+            if (font < 0)
+            {
+                QFont parsed;
+                parsed.fromString(fontName);
+                font = fontId(parsed);
+                fontIndex.insert(fontName, font);
+            }
+            QTransform transform;
+            transformFromString(attributes.value("QTransform").toString(), &transform);
+            QString uid = attributes.value("Uid").toString();
+            labelIndex.insert(uid, labelUids.size());
+            addLabel(uid, attributes.value("HtmlText").toString(),
+                     QPointF(attributes.value("X").toDouble(), attributes.value("Y").toDouble()), fonts.at(font),
+                     QColor(attributes.value("defaultTextColor").toString()).rgb(), transform);
+        }
+        else if (reader.name() == "Image")
+        {
+            QString hash = attributes.value("Hash").toString();
+            images.insert(hash, QByteArray::fromBase64(reader.readElementText().toLatin1()));
+        }
+        else if (reader.name() == "PixmapItem")
+        {
+            addPicture(attributes.value("Uid").toString(), attributes.value("Image").toString(),
+                       QPointF(attributes.value("X").toDouble(), attributes.value("Y").toDouble()),
+                       QSize(attributes.value("Width").toInt(), attributes.value("Height").toInt()));
+        }
+        else if (reader.name() == "Background")
+        {
+            backgroundImage = attributes.value("Image").toString();
+            backgroundSize = QSize(attributes.value("Width").toInt(), attributes.value("Height").toInt());
+        }
+        else if (reader.name() == "ConnectItem")
+        {
+            int label = labelIndex.value(attributes.value("TextItemUid").toString(), -1);
+            QString connectUid = attributes.value("ConnectItemUid").toString();
+            if (label < 0)
+            {
+                continue;
+            }
+            if (nodeIndex.contains(connectUid))
+            {
+                labelOwners[label] = NodeOwner;
+                labelOwnerIndices[label] = nodeIndex.value(connectUid);
+            }
+            else if (edgeIndex.contains(connectUid))
+            {
+                labelOwners[label] = EdgeOwner;
+                labelOwnerIndices[label] = edgeIndex.value(connectUid);
+            }
+        }
+    }
+
+    if (reader.hasError())
+    {
+        if (errorString != nullptr)
+        {
+            *errorString = reader.errorString();
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,113 @@
+﻿#ifndef DIAGRAMMODEL_H
+#define DIAGRAMMODEL_H
+
+#include <QColor>
+#include <QFont>
+#include <QHash>
+#include <QLineF>
+#include <QRectF>
+#include <QTransform>
+#include <QVector>
+#include <QIODevice>
+
+class QXmlStreamReader;
+class QXmlStreamWriter;
+
+// 流程图的数据模型，不依赖界面，读写与应用相同格式的XML
+// 图形、连线和文本按列存放在连续的数组中，同一下标的各列属于同一个对象，
+// 批量操作（整体移动、改色、序列化、命中测试、布局）都是对数组的简单循环
+// 是值类型，复制一份后即可在工作线程中独立处理
+class DiagramModel
+{
+public:
+    enum LabelOwner { NoOwner, NodeOwner, EdgeOwner };                      // 文本关联对象的种类
+
+    static const int styleCount = 12;                                       // 边框颜色（黑、蓝、红）与填充颜色（白、红、绿、黄）的组合数
+    static const int nodeSize = 16;                                         // 图元未缩放时的边长
+
+    QString guid;                                                           // 页面的唯一识别id
+    QString tabName;                                                        // 页面名称
+
+    // 图形（节点）
+    QVector<QString> nodeUids;                                              // 唯一识别id
+    QVector<QPointF> nodePositions;                                         // 位置
+    QVector<QTransform> nodeTransforms;                                     // 缩放矩阵
+    QVector<quint8> nodeTypes;                                              // 图形类型，与 FlowEnumItem 一致
+    QVector<quint8> nodeStyles;                                             // 样式编号，见 styleId
+
+    // 连线，端点为图形的下标
+    QVector<QString> edgeUids;
+    QVector<int> edgeStarts;                                                // 起点图形
+    QVector<int> edgeEnds;                                                  // 终点图形
+    QVector<QRgb> edgeColors;                                               // 颜色
+    QVector<QLineF> edgeLines;                                              // 线段
+
+    // 文本，可以关联到一个图形或一条连线
+    QVector<QString> labelUids;
+    QVector<QString> labelTexts;                                            // 文本内容
+    QVector<QRgb> labelColors;                                              // 文本颜色
+    QVector<int> labelFonts;                                                // 字体在 fonts 中的下标
+    QVector<QPointF> labelPositions;                                        // 位置
+    QVector<QTransform> labelTransforms;                                    // 缩放矩阵
+    QVector<quint8> labelOwners;                                            // 关联对象的种类
+    QVector<int> labelOwnerIndices;                                         // 关联对象在图形或连线中的下标
+    QVector<QFont> fonts;                                                   // 文本使用的字体，相同字体只保存一份
+
+    // 图片，像素数据按内容哈希存放在 images 中
+    QVector<QString> pictureUids;
+    QVector<QString> pictureImages;                                         // 图片数据的哈希
+    QVector<QPointF> picturePositions;                                      // 位置
+    QVector<QSize> pictureSizes;                                            // 显示大小
+    QHash<QString, QByteArray> images;                                      // 哈希到压缩的图片数据，相同图片只保存一份
+    QString backgroundImage;                                                // 背景图片的哈希，没有背景图片时为空
+    QSize backgroundSize;                                                   // 背景图片的显示大小
+
+    int nodeCount() const { return nodeUids.size(); }
+    int edgeCount() const { return edgeUids.size(); }
+    int labelCount() const { return labelUids.size(); }
+    int pictureCount() const { return pictureUids.size(); }
+    bool isEmpty() const;
+    void clear();                                                           // 清空模型
+    void reserve(int nodes, int edges, int labels);                         // 预留空间
+
+    int addNode(const QString& uid, int type, QPointF position, const QTransform& transform = QTransform(), int style = 0);
+    int addEdge(const QString& uid, int start, int end, const QLineF& line, QRgb color = qRgb(0, 0, 0));
+    int addLabel(const QString& uid, const QString& text, QPointF position, const QFont& font = QFont(), QRgb color = qRgb(0, 0, 0),
+                 const QTransform& transform = QTransform(), LabelOwner owner = NoOwner, int ownerIndex = -1);
+    int addPicture(const QString& uid, const QString& image, QPointF position, QSize size);
+    int fontId(const QFont& font);                                          // 字体的下标，不存在时添加
+
+    // 批量操作
+    QPointF center() const;                                                 // 图形、文本和图片位置的平均值
+    void translate(QPointF offset);                                         // 平移所有图形、连线、文本和图片
+    void translateNodes(const QVector<int>& nodes, QPointF offset);         // 平移部分图形，两端都被平移的连线随之平移
+    void setNodeStyles(const QVector<int>& nodes, int style);               // 批量修改图形样式
+    void regenerateUids();                                                  // 全部换成新的唯一ID，用于复制
+    QRectF nodeBounds(int node) const;                                      // 图形在场景中的边界
+    QRectF boundingRect() const;                                            // 所有图形、连线和图片的边界
+    QVector<int> nodesInRect(const QRectF& rect) const;                     // 与区域相交的图形
+    int nodeAt(QPointF point) const;                                        // 包含该点的最上层图形，没有时返回-1
+
+    // 样式
+    static int styleId(const QString& borderColor, const QString& fillColor); // 颜色代码转换为样式编号，无效的颜色按默认处理
+    static QString borderColor(int style);                                  // 边框颜色代码
+    static QString fillColor(int style);                                    // 填充颜色代码
+    static bool isBorderColor(const QString& color);
+    static bool isFillColor(const QString& color);
+    static QString svgPath(int type, int style);                            // 按类型和样式生成图元路径
+
+    // 读写
+    bool writeXml(QIODevice* device) const;                                 // 保存为流程图文件
+    bool readXml(QIODevice* device, QString* errorString = nullptr);        // 读取流程图文件
+    QString toClipboardXml() const;                                         // 写成剪贴板中的XML文本
+    bool fromClipboardXml(const QString& data, QString* errorString = nullptr); // 读取剪贴板中的XML文本
+
+    static QString transformToString(const QTransform& transform);          // 将变换矩阵写成9个以空格分隔的数
+    static bool transformFromString(const QString& text, QTransform* transform); // 读取变换矩阵，格式不对时返回false
+
+private:
+    void writeItems(QXmlStreamWriter& xml) const;                           // 写入图形、连线、文本、图片和关联信息
+    bool readItems(QXmlStreamReader& reader, QString* errorString);         // 读取图形、连线、文本、图片和关联信息
+};
+
+#endif // DIAGRAMMODEL_H
@@ -0,0 +1,129 @@
+﻿#include "edgebundler.h"
+
+#include <QLineF>
+#include <QtMath>
+#include <limits>
+
+QVector<EdgeBundler::Bundle> EdgeBundler::bundle(const QVector<QRectF>& bounds, const QVector<int>& starts, const QVector<int>& ends,
+                                                 const Options& options)
+{
+    // 按目标统计入边，自环不参与
+    QVector<QVector<int>> incoming(bounds.size());
+    for (int e = 0; e < starts.size(); ++e)
+    {
+        if (starts.at(e) != ends.at(e))
+        {
+            incoming[ends.at(e)].append(e);
+        }
+    }
+
+    QVector<Bundle> bundles;
+    for (int target = 0; target < bounds.size(); ++target)
+    {
+        const QVector<int>& edges = incoming.at(target);
+        if (edges.size() < qMax(2, options.minFanIn))
+        {
+            continue;
+        }
+        const QRectF& rect = bounds.at(target);
+        QPointF center = rect.center();
+
+        // 主干沿入边的平均方向伸出，方向相互抵消时朝上
+        QPointF mean(0, 0);
+        for (int e : edges)
+        {
+            mean += bounds.at(starts.at(e)).center();
+        }
+        mean /= edges.size();
+        QLineF direction(center, mean);
+        if (direction.length() < 1)
+        {
+            direction = QLineF(center, center - QPointF(0, 1));
+        }
+        QPointF trunkEnd = boundaryPoint(rect, direction.p2());
+        QLineF unit = direction.unitVector();
+        QPointF junction = trunkEnd + (unit.p2() - unit.p1()) * options.trunkLength;
+
+        // 按相对主汇合点的方向分组
+        int sectorCount = qMax(1, options.sectors);
+        QVector<QVector<int>> sectors(sectorCount);
+        for (int e : edges)
+        {
+            QPointF offset = bounds.at(starts.at(e)).center() - junction;
+            double angle = qAtan2(offset.y(), offset.x()) + M_PI;
+            sectors[qMin(sectorCount - 1, int(angle / (2 * M_PI) * sectorCount))].append(e);
+        }
+
+        Bundle bundle;
+        bundle.target = target;
+        bundle.junction = junction;
+        for (const QVector<int>& sector : qAsConst(sectors))
+        {
+            if (sector.isEmpty())
+            {
+                continue;
+            }
+            // 只有一条边的分组直接连到主汇合点
+            QPointF sectorJunction = junction;
+            if (sector.size() > 1)
+            {
+                QPointF centroid(0, 0);
+                for (int e : sector)
+                {
+                    centroid += bounds.at(starts.at(e)).center();
+                }
+                centroid /= sector.size();
+                sectorJunction = junction + (centroid - junction) * options.branchRatio;
+                bundle.path.moveTo(sectorJunction);
+                bundle.path.lineTo(junction);
+            }
+            // 每段单独成一条子路径，填充时不会围出面积
+            for (int e : sector)
+            {
+                bundle.path.moveTo(boundaryPoint(bounds.at(starts.at(e)), sectorJunction));
+                bundle.path.lineTo(sectorJunction);
+                bundle.edges.append(e);
+            }
+        }
+        bundle.path.moveTo(junction);
+        bundle.path.lineTo(trunkEnd);
+
+        // 箭头，与连线的箭头形状相同
+        QLineF tail(junction, trunkEnd);
+        double angle = std::atan2(-tail.dy(), tail.dx());
+        QPolygonF arrow;
+        arrow << trunkEnd
+              << trunkEnd + QPointF(qSin(angle - M_PI / 3) * options.arrowSize, qCos(angle - M_PI / 3) * options.arrowSize)
+              << trunkEnd + QPointF(qSin(angle - M_PI + M_PI / 3) * options.arrowSize, qCos(angle - M_PI + M_PI / 3) * options.arrowSize)
+              << trunkEnd;
+        bundle.path.addPolygon(arrow);
+        bundles.append(bundle);
+    }
+    return bundles;
+}
+
+QVector<EdgeBundler::Bundle> EdgeBundler::bundle(const DiagramModel& model, const Options& options)
+{
+    QVector<QRectF> bounds(model.nodeCount());
+    for (int i = 0; i < model.nodeCount(); ++i)
+    {
+        bounds[i] = model.nodeBounds(i);
+    }
+    return bundle(bounds, model.edgeStarts, model.edgeEnds, options);
+}
+
+QPointF EdgeBundler::boundaryPoint(const QRectF& rect, QPointF toward)
+{
+    QPointF center = rect.center();
+    QPointF offset = toward - center;
+    if (qFuzzyIsNull(offset.x()) && qFuzzyIsNull(offset.y()))
+    {
+        return center;
+    }
+    // 按较先碰到的一条边缩放
+    const double infinity = std::numeric_limits<double>::infinity();
+    double scaleX = qFuzzyIsNull(offset.x()) ? infinity : rect.width() / 2 / qAbs(offset.x());
+    double scaleY = qFuzzyIsNull(offset.y()) ? infinity : rect.height() / 2 / qAbs(offset.y());
+    double scale = qMin(1.0, qMin(scaleX, scaleY));
+    return center + offset * scale;
+}
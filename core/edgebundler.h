@@ -0,0 +1,42 @@
+﻿#ifndef EDGEBUNDLER_H
+#define EDGEBUNDLER_H
+
+#include <QPainterPath>
+#include <QRectF>
+#include <QVector>
+
+#include "diagrammodel.h"
+
+// 扇入连线捆绑：入边很多的图形，其入边先按方向分组汇合到分组汇合点，
+// 再汇合到主汇合点，最后以一条主干和一个箭头连到图形（两级层次捆绑）
+// 每个捆绑生成一条路径，绘制一次代替逐条绘制连线和箭头
+class EdgeBundler
+{
+public:
+    struct Options
+    {
+        int minFanIn = 8;                                           // 入边达到该数量才捆绑
+        int sectors = 8;                                            // 按方向分组的扇区数
+        double trunkLength = 60;                                    // 主干长度（主汇合点到图形边框）
+        double branchRatio = 0.35;                                  // 分组汇合点位于主汇合点到分组重心的比例处
+        double arrowSize = 10;                                      // 箭头大小
+    };
+
+    struct Bundle
+    {
+        int target;                                                 // 目标图形
+        QVector<int> edges;                                         // 捆绑的连线
+        QPointF junction;                                           // 主汇合点
+        QPainterPath path;                                          // 所有分支、主干和箭头
+    };
+
+    // bounds 为图形边界，starts/ends 为连线两端图形的下标
+    static QVector<Bundle> bundle(const QVector<QRectF>& bounds, const QVector<int>& starts, const QVector<int>& ends,
+                                  const Options& options = Options());
+    static QVector<Bundle> bundle(const DiagramModel& model, const Options& options = Options());
+
+private:
+    static QPointF boundaryPoint(const QRectF& rect, QPointF toward);   // 从矩形中心指向 toward 的射线与边框的交点
+};
+
+#endif // EDGEBUNDLER_H
@@ -0,0 +1,346 @@
+﻿#include "graphanalysis.h"
+
+static const int startOrEndType = 1;                // 开始或结束，与 FlowEnumItem 一致
+static const int judgeType = 4;                     // 判定
+static const int remarkType = 9;                    // 备注，不参与流程
+static const int annotationType = 10;               // 注释，不参与流程
+
+// 压缩稀疏行（CSR）邻接表：offsets[v] 到 offsets[v + 1] 之间是 v 的相邻顶点
+struct Adjacency
+{
+    QVector<int> offsets;
+    QVector<int> targets;
+
+    Adjacency(int vertexCount, const QVector<int>& from, const QVector<int>& to)
+        : offsets(vertexCount + 1, 0), targets(from.size())
+    {
+        for (int v : from)
+        {
+            ++offsets[v + 1];
+        }
+        for (int v = 0; v < vertexCount; ++v)
+        {
+            offsets[v + 1] += offsets[v];
+        }
+        QVector<int> next = offsets;
+        for (int e = 0; e < from.size(); ++e)
+        {
+            targets[next[from.at(e)]++] = to.at(e);
+        }
+    }
+
+    int degree(int v) const { return offsets.at(v + 1) - offsets.at(v); }
+};
+
+// 从 sources 出发沿邻接表能到达的顶点
+static QVector<bool> reach(const Adjacency& adjacency, const QVector<int>& sources)
+{
+    QVector<bool> reached(adjacency.offsets.size() - 1, false);
+    QVector<int> queue = sources;
+    for (int v : sources)
+    {
+        reached[v] = true;
+    }
+    for (int head = 0; head < queue.size(); ++head)
+    {
+        int v = queue.at(head);
+        for (int i = adjacency.offsets.at(v); i < adjacency.offsets.at(v + 1); ++i)
+        {
+            int w = adjacency.targets.at(i);
+            if (!reached.at(w))
+            {
+                reached[w] = true;
+                queue.append(w);
+            }
+        }
+    }
+    return reached;
+}
+
+GraphAnalysis::GraphAnalysis()
+    : dirty(false)
+{}
+
+void GraphAnalysis::setNode(quintptr key, int type)
+{
+    QHash<quintptr, int>::const_iterator it = nodeSlots.constFind(key);
+    if (it != nodeSlots.constEnd())
+    {
+        if (nodeTypes.at(it.value()) != type)
+        {
+            nodeTypes[it.value()] = type;
+            dirty = true;
+        }
+        return;
+    }
+    int slot;
+    if (!freeNodes.isEmpty())
+    {
+        slot = freeNodes.takeLast();
+        nodeKeys[slot] = key;
+        nodeTypes[slot] = type;
+        nodeWarnings[slot] = NoWarning;
+    }
+    else
+    {
+        slot = nodeKeys.size();
+        nodeKeys.append(key);
+        nodeTypes.append(type);
+        nodeWarnings.append(NoWarning);
+    }
+    nodeSlots.insert(key, slot);
+    dirty = true;
+}
+
+void GraphAnalysis::removeNode(quintptr key)
+{
+    QHash<quintptr, int>::iterator it = nodeSlots.find(key);
+    if (it == nodeSlots.end())
+    {
+        return;
+    }
+    nodeKeys[it.value()] = 0;
+    freeNodes.append(it.value());
+    nodeSlots.erase(it);
+    dirty = true;
+}
+
+void GraphAnalysis::setEdge(quintptr key, quintptr start, quintptr end)
+{
+    QHash<quintptr, int>::const_iterator it = edgeSlots.constFind(key);
+    int slot;
+    if (it != edgeSlots.constEnd())
+    {
+        slot = it.value();
+        if (edgeStarts.at(slot) == start && edgeEnds.at(slot) == end)
+        {
+            return;
+        }
+    }
+    else if (!freeEdges.isEmpty())
+    {
+        slot = freeEdges.takeLast();
+        edgeSlots.insert(key, slot);
+    }
+    else
+    {
+        slot = edgeStarts.size();
+        edgeStarts.append(0);
+        edgeEnds.append(0);
+        edgeSlots.insert(key, slot);
+    }
+    edgeStarts[slot] = start;
+    edgeEnds[slot] = end;
+    dirty = true;
+}
+
+void GraphAnalysis::removeEdge(quintptr key)
+{
+    QHash<quintptr, int>::iterator it = edgeSlots.find(key);
+    if (it == edgeSlots.end())
+    {
+        return;
+    }
+    edgeStarts[it.value()] = 0;
+    edgeEnds[it.value()] = 0;
+    freeEdges.append(it.value());
+    edgeSlots.erase(it);
+    dirty = true;
+}
+
+void GraphAnalysis::clear()
+{
+    *this = GraphAnalysis();
+}
+
+int GraphAnalysis::warnings(quintptr node) const
+{
+    QHash<quintptr, int>::const_iterator it = nodeSlots.constFind(node);
+    return it == nodeSlots.constEnd() ? NoWarning : nodeWarnings.at(it.value());
+}
+
+QList<quintptr> GraphAnalysis::analyze()
+{
+    QList<quintptr> changed;
+    if (!dirty)
+    {
+        return changed;
+    }
+    dirty = false;
+
+    // 压缩为连续下标，跳过空槽和端点已删除的连线
+    QVector<int> compact(nodeKeys.size(), -1);
+    QVector<int> slots;
+    QVector<int> types;
+    slots.reserve(nodeSlots.size());
+    types.reserve(nodeSlots.size());
+    for (int slot = 0; slot < nodeKeys.size(); ++slot)
+    {
+        if (nodeKeys.at(slot) != 0)
+        {
+            compact[slot] = slots.size();
+            slots.append(slot);
+            types.append(nodeTypes.at(slot));
+        }
+    }
+    QVector<int> starts;
+    QVector<int> ends;
+    starts.reserve(edgeSlots.size());
+    ends.reserve(edgeSlots.size());
+    for (int slot : qAsConst(edgeSlots))
+    {
+        int start = nodeSlots.value(edgeStarts.at(slot), -1);
+        int end = nodeSlots.value(edgeEnds.at(slot), -1);
+        if (start >= 0 && end >= 0)
+        {
+            starts.append(compact.at(start));
+            ends.append(compact.at(end));
+        }
+    }
+
+    QVector<quint8> result = analyze(types, starts, ends);
+    for (int i = 0; i < slots.size(); ++i)
+    {
+        int slot = slots.at(i);
+        if (nodeWarnings.at(slot) != result.at(i))
+        {
+            nodeWarnings[slot] = result.at(i);
+            changed.append(nodeKeys.at(slot));
+        }
+    }
+    return changed;
+}
+
+QVector<quint8> GraphAnalysis::analyze(const QVector<int>& types, const QVector<int>& starts, const QVector<int>& ends)
+{
+    int n = types.size();
+    QVector<quint8> result(n, NoWarning);
+    Adjacency out(n, starts, ends);
+    Adjacency in(n, ends, starts);
+    auto inFlow = [&](int v) { return types.at(v) != remarkType && types.at(v) != annotationType; };
+
+    // 没有入边的开始/结束图形为开始，没有出边的为结束
+    QVector<int> beginnings;
+    QVector<int> endings;
+    for (int v = 0; v < n; ++v)
+    {
+        if (types.at(v) == startOrEndType)
+        {
+            if (in.degree(v) == 0)
+            {
+                beginnings.append(v);
+            }
+            if (out.degree(v) == 0)
+            {
+                endings.append(v);
+            }
+        }
+        if (types.at(v) == judgeType && out.degree(v) < 2)
+        {
+            result[v] |= JudgeBranches;
+        }
+    }
+    // 页面上还没有开始或结束图形时不检查可达性
+    if (!beginnings.isEmpty())
+    {
+        QVector<bool> reached = reach(out, beginnings);
+        for (int v = 0; v < n; ++v)
+        {
+            if (!reached.at(v) && inFlow(v))
+            {
+                result[v] |= Unreachable;
+            }
+        }
+    }
+    if (!endings.isEmpty())
+    {
+        QVector<bool> reached = reach(in, endings);
+        for (int v = 0; v < n; ++v)
+        {
+            if (!reached.at(v) && inFlow(v))
+            {
+                result[v] |= DeadEnd;
+            }
+        }
+    }
+
+    // 强连通分量（非递归 Tarjan），多于一个顶点或有自环的分量即为环路
+    QVector<int> index(n, -1);
+    QVector<int> low(n, 0);
+    QVector<bool> onStack(n, false);
+    QVector<int> stack;
+    QVector<QPair<int, int>> calls;                                 // （顶点，下一条出边）
+    int counter = 0;
+    for (int root = 0; root < n; ++root)
+    {
+        if (index.at(root) >= 0)
+        {
+            continue;
+        }
+        calls.append(qMakePair(root, out.offsets.at(root)));
+        index[root] = low[root] = counter++;
+        stack.append(root);
+        onStack[root] = true;
+        while (!calls.isEmpty())
+        {
+            int v = calls.last().first;
+            int& edge = calls.last().second;
+            if (edge < out.offsets.at(v + 1))
+            {
+                int w = out.targets.at(edge++);
+                if (index.at(w) < 0)
+                {
+                    index[w] = low[w] = counter++;
+                    stack.append(w);
+                    onStack[w] = true;
+                    calls.append(qMakePair(w, out.offsets.at(w)));
+                }
+                else if (onStack.at(w))
+                {
+                    low[v] = qMin(low.at(v), index.at(w));
+                }
+                continue;
+            }
+            calls.removeLast();
+            if (!calls.isEmpty())
+            {
+                int parent = calls.last().first;
+                low[parent] = qMin(low.at(parent), low.at(v));
+            }
+            if (low.at(v) != index.at(v))
+            {
+                continue;
+            }
+            // v 是分量的根
+            int size = stack.size() - stack.lastIndexOf(v);
+            bool cycle = size > 1;
+            if (!cycle)
+            {
+                for (int i = out.offsets.at(v); i < out.offsets.at(v + 1); ++i)
+                {
+                    cycle = cycle || out.targets.at(i) == v;
+                }
+            }
+            for (int i = 0; i < size; ++i)
+            {
+                int w = stack.takeLast();
+                onStack[w] = false;
+                if (cycle)
+                {
+                    result[w] |= InCycle;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+QVector<quint8> GraphAnalysis::analyze(const DiagramModel& model)
+{
+    QVector<int> types(model.nodeCount());
+    for (int i = 0; i < model.nodeCount(); ++i)
+    {
+        types[i] = model.nodeTypes.at(i);
+    }
+    return analyze(types, model.edgeStarts, model.edgeEnds);
+}
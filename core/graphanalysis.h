@@ -0,0 +1,57 @@
+﻿#ifndef GRAPHANALYSIS_H
+#define GRAPHANALYSIS_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include "diagrammodel.h"
+
+// 流程图的语义检查：从开始图形无法到达的图形、环路、分支少于两个的判定、无法到达结束的图形
+// 图形和连线以键（通常是图元指针）增量登记，分析时压缩为 CSR 邻接表，在线性时间内完成，
+// 只返回警告发生变化的图形，界面只需要更新这些图形
+class GraphAnalysis
+{
+public:
+    enum Warning
+    {
+        NoWarning = 0,
+        Unreachable = 1,                                            // 从开始图形无法到达
+        InCycle = 2,                                                // 位于环路中
+        JudgeBranches = 4,                                          // 判定的出边少于两条
+        DeadEnd = 8                                                 // 无法到达结束图形
+    };
+
+    GraphAnalysis();
+
+    // 增量编辑，键已存在时更新
+    void setNode(quintptr key, int type);
+    void removeNode(quintptr key);                                  // 相关的连线在分析时忽略
+    void setEdge(quintptr key, quintptr start, quintptr end);
+    void removeEdge(quintptr key);
+    void clear();
+
+    bool isDirty() const { return dirty; }
+    int nodeCount() const { return nodeSlots.size(); }
+    int edgeCount() const { return edgeSlots.size(); }
+    int warnings(quintptr node) const;                              // 图形当前的警告
+    QList<quintptr> analyze();                                      // 有修改时重新分析，返回警告发生变化的图形
+
+    // 对按下标给出的图：types 为图形类型，starts/ends 为连线两端的下标，返回每个图形的警告
+    static QVector<quint8> analyze(const QVector<int>& types, const QVector<int>& starts, const QVector<int>& ends);
+    static QVector<quint8> analyze(const DiagramModel& model);
+
+private:
+    QHash<quintptr, int> nodeSlots;                                 // 图形键到槽位
+    QVector<quintptr> nodeKeys;                                     // 槽位中的图形键，空槽为0
+    QVector<int> nodeTypes;
+    QVector<quint8> nodeWarnings;                                   // 上一次分析的结果
+    QVector<int> freeNodes;                                         // 可复用的空槽
+    QHash<quintptr, int> edgeSlots;
+    QVector<quintptr> edgeStarts;                                   // 起点图形的键
+    QVector<quintptr> edgeEnds;                                     // 终点图形的键
+    QVector<int> freeEdges;
+    bool dirty;                                                     // 上次分析后是否有修改
+};
+
+#endif // GRAPHANALYSIS_H
@@ -0,0 +1,58 @@
+﻿#include "iconcache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+IconCache::IconCache(const QString& directory)
+    : dir(directory)
+{
+}
+
+QString IconCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/icons";
+}
+
+QString IconCache::fileName(const QString& resource, const QSize& size) const
+{
+    // 资源在程序中（qrc）时读取很快，比光栅化便宜得多
+    QFile file(resource);
+    QByteArray content = file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(version));
+    hash.addData(resource.toUtf8());
+    hash.addData(QByteArray::number(size.width()) + 'x' + QByteArray::number(size.height()));
+    hash.addData(QCryptographicHash::hash(content, QCryptographicHash::Sha1));
+    return dir + "/" + QString::fromLatin1(hash.result().toHex()) + ".png";
+}
+
+QImage IconCache::image(const QString& resource, const QSize& size, const std::function<QImage()>& render)
+{
+    QString path = fileName(resource, size);
+    QImage cached(path);
+    if (!cached.isNull())
+    {
+        ++hitCount;
+        return cached;
+    }
+    ++missCount;
+    QImage rendered = render();
+    if (!rendered.isNull() && QDir().mkpath(dir))
+    {
+        // 先写临时文件再替换，多个进程同时启动也不会读到不完整的文件
+        QSaveFile file(path);
+        if (file.open(QIODevice::WriteOnly) && rendered.save(&file, "png"))
+        {
+            file.commit();
+        }
+    }
+    return rendered;
+}
+
+bool IconCache::clear()
+{
+    return QDir(dir).removeRecursively();
+}
@@ -0,0 +1,34 @@
+﻿#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QImage>
+#include <QString>
+#include <functional>
+
+// 图标的磁盘缓存：把由SVG等资源渲染出的图标保存为PNG，下次启动时直接读取，不再光栅化
+// 文件名由缓存版本、资源路径、像素大小和资源内容的哈希组成，资源或渲染方式改变后自动失效
+class IconCache
+{
+public:
+    static const int version = 1;                                       // 渲染方式改变时加1，旧的缓存文件不再使用
+
+    explicit IconCache(const QString& directory = defaultDirectory());
+
+    static QString defaultDirectory();                                  // QStandardPaths::CacheLocation 下的 icons 目录
+    QString directory() const { return dir; }
+
+    // 读取缓存的图标，没有时调用 render 渲染并写入缓存
+    QImage image(const QString& resource, const QSize& size, const std::function<QImage()>& render);
+    bool clear();                                                       // 删除所有缓存文件
+    int hits() const { return hitCount; }
+    int misses() const { return missCount; }
+
+private:
+    QString dir;
+    int hitCount = 0;
+    int missCount = 0;
+
+    QString fileName(const QString& resource, const QSize& size) const;
+};
+
+#endif // ICONCACHE_H
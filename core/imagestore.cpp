@@ -0,0 +1,91 @@
+﻿#include "imagestore.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QImageReader>
+#include <QImageWriter>
+
+QString ImageStore::insert(const QByteArray& encoded)
+{
+    QString key = hash(encoded);
+    if (entries.contains(key))
+    {
+        return key;                                 // 已有相同的图片，共享同一份数据
+    }
+    QBuffer buffer;
+    buffer.setData(encoded);
+    buffer.open(QIODevice::ReadOnly);
+    if (!QImageReader(&buffer).canRead())
+    {
+        return QString();
+    }
+    entries.insert(key, encoded);
+    bytes += encoded.size();
+    return key;
+}
+
+QString ImageStore::insert(const QImage& image)
+{
+    if (image.isNull())
+    {
+        return QString();
+    }
+    QByteArray encoded;
+    QBuffer buffer(&encoded);
+    buffer.open(QIODevice::WriteOnly);
+    QImageWriter writer(&buffer, "png");
+    if (!writer.write(image))
+    {
+        return QString();
+    }
+    buffer.close();
+    return insert(encoded);
+}
+
+QSize ImageStore::imageSize(const QString& key) const
+{
+    return imageSize(entries.value(key));
+}
+
+QImage ImageStore::image(const QString& key, const QSize& size) const
+{
+    return decode(entries.value(key), size);
+}
+
+void ImageStore::clear()
+{
+    entries.clear();
+    bytes = 0;
+}
+
+QString ImageStore::hash(const QByteArray& encoded)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(encoded, QCryptographicHash::Sha1).toHex());
+}
+
+QSize ImageStore::imageSize(const QByteArray& encoded)
+{
+    QBuffer buffer;
+    buffer.setData(encoded);
+    buffer.open(QIODevice::ReadOnly);
+    return QImageReader(&buffer).size();
+}
+
+QImage ImageStore::decode(const QByteArray& encoded, const QSize& size)
+{
+    if (encoded.isEmpty())
+    {
+        return QImage();
+    }
+    QBuffer buffer;
+    buffer.setData(encoded);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+    QSize full = reader.size();
+    // JPEG 等格式在解码时直接缩小，不会先生成原图大小的图像
+    if (size.isValid() && full.isValid() && (full.width() > size.width() || full.height() > size.height()))
+    {
+        reader.setScaledSize(full.scaled(size, Qt::KeepAspectRatio).expandedTo(QSize(1, 1)));
+    }
+    return reader.read();
+}
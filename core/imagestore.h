@@ -0,0 +1,34 @@
+﻿#ifndef IMAGESTORE_H
+#define IMAGESTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QString>
+
+// 文档的图片仓库：按内容哈希保存压缩的图片数据（原始文件或PNG），相同的图片只保存一份
+// 图片项只记录哈希，按显示大小从压缩数据解码，复制、粘贴和保存都不会复制像素
+// 数据用 QByteArray 隐式共享，解码可以在工作线程中进行
+class ImageStore
+{
+public:
+    QString insert(const QByteArray& encoded);                          // 保存压缩的图片数据，返回内容哈希，无法识别的数据返回空
+    QString insert(const QImage& image);                                // 编码为PNG后保存
+    bool contains(const QString& key) const { return entries.contains(key); }
+    QByteArray data(const QString& key) const { return entries.value(key); }
+    QSize imageSize(const QString& key) const;                          // 原图大小，只读取文件头
+    QImage image(const QString& key, const QSize& size = QSize()) const; // 见 decode
+    int count() const { return entries.size(); }
+    qint64 byteCount() const { return bytes; }                          // 所有压缩数据的字节数
+    void clear();
+
+    static QString hash(const QByteArray& encoded);                     // 内容哈希（SHA-1的十六进制）
+    static QSize imageSize(const QByteArray& encoded);
+    static QImage decode(const QByteArray& encoded, const QSize& size = QSize()); // 解码，size 有效时按比例缩小到不超过 size，不放大
+
+private:
+    QHash<QString, QByteArray> entries;                                 // 哈希到压缩数据
+    qint64 bytes = 0;
+};
+
+#endif // IMAGESTORE_H
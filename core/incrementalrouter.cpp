@@ -0,0 +1,279 @@
+﻿#include "incrementalrouter.h"
+
+#include <QCoreApplication>
+#include <QMetaType>
+#include <QRunnable>
+
+// 在障碍物快照上重新计算一批连线
+class IncrementalRouter::Job : public QRunnable
+{
+public:
+    struct Request
+    {
+        quintptr edge;
+        quintptr sourceKey;
+        quintptr targetKey;
+    };
+
+    Job(IncrementalRouter* owner, const OrthogonalRouter& snapshot, const QVector<Request>& requests, int generation)
+        : owner(owner), snapshot(snapshot), requests(requests), generation(generation) {}
+
+    void run() override
+    {
+        QVector<quintptr> edges;
+        QVector<QPolygonF> paths;
+        edges.reserve(requests.size());
+        paths.reserve(requests.size());
+        for (const Request& request : qAsConst(requests))
+        {
+            if (!snapshot.hasObstacle(request.sourceKey) || !snapshot.hasObstacle(request.targetKey))
+            {
+                continue;                                               // 端点已被删除
+            }
+            edges.append(request.edge);
+            paths.append(snapshot.route(snapshot.obstacle(request.sourceKey), snapshot.obstacle(request.targetKey),
+                                        request.sourceKey, request.targetKey));
+        }
+        // owner 析构时会等待任务结束，此处一定有效
+        QMetaObject::invokeMethod(owner, "deliver", Qt::QueuedConnection, Q_ARG(int, generation),
+                                  Q_ARG(QVector<quintptr>, edges), Q_ARG(QVector<QPolygonF>, paths));
+    }
+
+private:
+    IncrementalRouter* owner;
+    OrthogonalRouter snapshot;
+    QVector<Request> requests;
+    int generation;
+};
+
+IncrementalRouter::IncrementalRouter(const OrthogonalRouter::Options& options, QObject* parent)
+    : QObject(parent), router(options), routeGrid(256), flushPending(false), generation(0)
+{
+    qRegisterMetaType<QVector<quintptr>>("QVector<quintptr>");
+    qRegisterMetaType<QVector<QPolygonF>>("QVector<QPolygonF>");
+    pool.setMaxThreadCount(1);                                          // 批次按顺序完成，拖动时不会堆积
+}
+
+IncrementalRouter::~IncrementalRouter()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void IncrementalRouter::setObstacle(quintptr key, const QRectF& rect)
+{
+    if (router.hasObstacle(key) && router.obstacle(key) == rect)
+    {
+        return;
+    }
+    // 贴近旧位置的连线可能可以走得更短，穿过新位置的连线必须绕开
+    QList<quintptr> affected = dependentRoutes(key);
+    double margin = router.getMargin();
+    QRectF footprint = rect.adjusted(-margin, -margin, margin, margin);
+    QList<quintptr> candidates = routeGrid.query(footprint);
+    for (quintptr edge : qAsConst(candidates))
+    {
+        if (crosses(routes.value(edge).path, footprint))
+        {
+            affected.append(edge);
+        }
+    }
+    router.setObstacle(key, rect);
+    for (quintptr edge : qAsConst(affected))
+    {
+        markDirty(edge);
+    }
+}
+
+void IncrementalRouter::removeObstacle(quintptr key)
+{
+    if (!router.hasObstacle(key))
+    {
+        return;
+    }
+    QList<quintptr> affected = dependentRoutes(key);
+    router.removeObstacle(key);
+    for (quintptr edge : qAsConst(affected))
+    {
+        markDirty(edge);
+    }
+}
+
+void IncrementalRouter::clear()
+{
+    router.clear();
+    routes.clear();
+    dependents.clear();
+    routeGrid.clear();
+    dirty.clear();
+    ++generation;                                                       // 丢弃正在计算的结果
+}
+
+QPolygonF IncrementalRouter::route(quintptr edge, const QRectF& source, const QRectF& target, quintptr sourceKey, quintptr targetKey)
+{
+    QHash<quintptr, Route>::iterator it = routes.find(edge);
+    if (it != routes.end() && it->sourceKey == sourceKey && it->targetKey == targetKey)
+    {
+        return it->path;
+    }
+    if (it == routes.end())
+    {
+        it = routes.insert(edge, Route{ QPolygonF(), sourceKey, targetKey, QVector<quintptr>(), synchronousGeneration });
+    }
+    else
+    {
+        it->sourceKey = sourceKey;                                      // 连线换了端点
+        it->targetKey = targetKey;
+        it->generation = synchronousGeneration;
+    }
+    dirty.remove(edge);
+    store(edge, *it, router.route(source, target, sourceKey, targetKey));
+    return it->path;
+}
+
+void IncrementalRouter::removeRoute(quintptr edge)
+{
+    QHash<quintptr, Route>::iterator it = routes.find(edge);
+    if (it == routes.end())
+    {
+        return;
+    }
+    unlink(edge, *it);
+    routes.erase(it);
+    dirty.remove(edge);
+}
+
+QList<quintptr> IncrementalRouter::dependentRoutes(quintptr obstacle) const
+{
+    return dependents.value(obstacle).values();
+}
+
+QList<quintptr> IncrementalRouter::pendingRoutes() const
+{
+    return dirty.values();
+}
+
+void IncrementalRouter::waitForDone()
+{
+    flush();
+    pool.waitForDone();
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+}
+
+void IncrementalRouter::flush()
+{
+    flushPending = false;
+    if (dirty.isEmpty())
+    {
+        return;
+    }
+    ++generation;
+    QVector<Job::Request> requests;
+    requests.reserve(dirty.size());
+    for (quintptr edge : qAsConst(dirty))
+    {
+        Route& route = routes[edge];
+        route.generation = generation;
+        requests.append(Job::Request{ edge, route.sourceKey, route.targetKey });
+    }
+    dirty.clear();
+    pool.start(new Job(this, router, requests, generation));
+}
+
+void IncrementalRouter::deliver(int generation, const QVector<quintptr>& edges, const QVector<QPolygonF>& paths)
+{
+    QList<quintptr> changed;
+    for (int i = 0; i < edges.size(); ++i)
+    {
+        QHash<quintptr, Route>::iterator it = routes.find(edges.at(i));
+        // 连线已删除或之后又被安排了新的批次
+        if (it == routes.end() || it->generation != generation)
+        {
+            continue;
+        }
+        if (it->path != paths.at(i))
+        {
+            store(edges.at(i), *it, paths.at(i));
+            changed.append(edges.at(i));
+        }
+    }
+    if (!changed.isEmpty())
+    {
+        emit routesChanged(changed);
+    }
+}
+
+void IncrementalRouter::store(quintptr edge, Route& route, const QPolygonF& path)
+{
+    unlink(edge, route);
+    route.path = path;
+
+    // 依赖两端的障碍物和每一段在保留距离内经过的障碍物
+    QSet<quintptr> near;
+    near.insert(route.sourceKey);
+    near.insert(route.targetKey);
+    double reach = router.getMargin() + 1;
+    for (int i = 1; i < path.size(); ++i)
+    {
+        QRectF segment = QRectF(path.at(i - 1), path.at(i)).normalized().adjusted(-reach, -reach, reach, reach);
+        QList<quintptr> keys = router.obstaclesIn(segment);
+        for (quintptr key : qAsConst(keys))
+        {
+            near.insert(key);
+        }
+    }
+    route.obstacles = near.values().toVector();
+    for (quintptr key : qAsConst(route.obstacles))
+    {
+        dependents[key].insert(edge);
+    }
+    if (!path.isEmpty())
+    {
+        routeGrid.insert(edge, path.boundingRect());
+    }
+}
+
+void IncrementalRouter::unlink(quintptr edge, const Route& route)
+{
+    for (quintptr key : qAsConst(route.obstacles))
+    {
+        QHash<quintptr, QSet<quintptr>>::iterator it = dependents.find(key);
+        if (it != dependents.end())
+        {
+            it->remove(edge);
+            if (it->isEmpty())
+            {
+                dependents.erase(it);
+            }
+        }
+    }
+    routeGrid.remove(edge);
+}
+
+void IncrementalRouter::markDirty(quintptr edge)
+{
+    if (!routes.contains(edge))
+    {
+        return;
+    }
+    dirty.insert(edge);
+    if (!flushPending)
+    {
+        flushPending = true;
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);    // 同一帧内的多次移动合并为一批
+    }
+}
+
+bool IncrementalRouter::crosses(const QPolygonF& path, const QRectF& rect) const
+{
+    // 折线只有水平和竖直的线段，外接矩形相交即为穿过
+    for (int i = 1; i < path.size(); ++i)
+    {
+        QRectF segment = QRectF(path.at(i - 1), path.at(i)).normalized();
+        if (segment.left() <= rect.right() && rect.left() <= segment.right() && segment.top() <= rect.bottom() && rect.top() <= segment.bottom())
+        {
+            return true;
+        }
+    }
+    return false;
+}
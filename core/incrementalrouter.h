@@ -0,0 +1,71 @@
+﻿#ifndef INCREMENTALROUTER_H
+#define INCREMENTALROUTER_H
+
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+
+#include "orthogonalrouter.h"
+
+// 增量布线：缓存每条连线的折线，并记录折线贴近（在保留距离内）的障碍物
+// 障碍物移动时只有依赖它的连线和穿过其新位置的连线需要重新布线，
+// 这些连线在线程池中按障碍物的快照重新计算，结果回到所属线程后通过 routesChanged 通知
+class IncrementalRouter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IncrementalRouter(const OrthogonalRouter::Options& options = OrthogonalRouter::Options(), QObject* parent = nullptr);
+    ~IncrementalRouter() override;                                      // 等待后台布线结束
+
+    void setObstacle(quintptr key, const QRectF& rect);                 // 登记或移动障碍物，并标记受影响的连线
+    void removeObstacle(quintptr key);
+    void clear();                                                       // 清除障碍物和所有缓存的折线
+    const OrthogonalRouter& obstacles() const { return router; }
+
+    // 连线的折线：有缓存时直接返回（可能正在后台更新），否则立即计算并缓存
+    QPolygonF route(quintptr edge, const QRectF& source, const QRectF& target, quintptr sourceKey, quintptr targetKey);
+    void removeRoute(quintptr edge);
+    bool hasRoute(quintptr edge) const { return routes.contains(edge); }
+    int routeCount() const { return routes.size(); }
+    QList<quintptr> dependentRoutes(quintptr obstacle) const;           // 依赖该障碍物的连线
+    QList<quintptr> pendingRoutes() const;                              // 等待重新布线的连线
+    void waitForDone();                                                 // 等待后台布线并应用结果，用于测试和保存
+
+public slots:
+    void flush();                                                       // 在后台重新计算所有等待的连线
+
+signals:
+    void routesChanged(const QList<quintptr>& edges);                   // 这些连线的折线已更新
+
+private slots:
+    void deliver(int generation, const QVector<quintptr>& edges, const QVector<QPolygonF>& paths); // 接收后台结果
+
+private:
+    struct Route
+    {
+        QPolygonF path;                                                 // 折线
+        quintptr sourceKey;                                             // 起点障碍物
+        quintptr targetKey;                                             // 终点障碍物
+        QVector<quintptr> obstacles;                                    // 依赖的障碍物，包括两端
+        int generation;                                                 // 最近一次安排布线的批次，旧批次的结果被丢弃
+    };
+    // 立即计算的折线使用的批次编号，任何批次都不会使用，正在计算的旧结果不会覆盖它
+    enum { synchronousGeneration = -1 };
+    class Job;
+
+    OrthogonalRouter router;                                            // 障碍物
+    QHash<quintptr, Route> routes;                                      // 缓存的折线
+    QHash<quintptr, QSet<quintptr>> dependents;                         // 障碍物到依赖它的连线
+    SpatialGrid<quintptr> routeGrid;                                    // 折线外接矩形的空间索引
+    QSet<quintptr> dirty;                                               // 等待重新布线的连线
+    bool flushPending;                                                  // 是否已安排 flush
+    int generation;                                                     // 批次编号
+    QThreadPool pool;
+
+    void store(quintptr edge, Route& route, const QPolygonF& path);     // 更新折线、依赖和索引
+    void unlink(quintptr edge, const Route& route);                     // 移除依赖和索引
+    void markDirty(quintptr edge);
+    bool crosses(const QPolygonF& path, const QRectF& rect) const;      // 折线是否穿过或贴近矩形
+};
+
+#endif // INCREMENTALROUTER_H
@@ -0,0 +1,272 @@
+﻿#include "labelindex.h"
+
+#include <QRegularExpression>
+#include <iterator>
+#include <algorithm>
+
+void LabelIndex::setLabel(quintptr key, const QString& text)
+{
+    int slot;
+    QHash<quintptr, int>::const_iterator it = slotOf.constFind(key);
+    if (it != slotOf.constEnd())
+    {
+        slot = it.value();
+        if (texts.at(slot) == text)
+        {
+            return;
+        }
+        unlink(slot);
+    }
+    else if (!freeSlots.isEmpty())
+    {
+        slot = freeSlots.takeLast();
+        slotOf.insert(key, slot);
+    }
+    else
+    {
+        slot = keys.size();
+        keys.append(0);
+        texts.append(QString());
+        folded.append(QString());
+        slotOf.insert(key, slot);
+    }
+    keys[slot] = key;
+    texts[slot] = text;
+    folded[slot] = text.toCaseFolded();
+    QVector<quint64> grams = trigrams(folded.at(slot));
+    for (quint64 gram : qAsConst(grams))
+    {
+        QVector<int>& list = postings[gram];
+        list.insert(std::lower_bound(list.begin(), list.end(), slot), slot);
+    }
+}
+
+void LabelIndex::removeLabel(quintptr key)
+{
+    QHash<quintptr, int>::iterator it = slotOf.find(key);
+    if (it == slotOf.end())
+    {
+        return;
+    }
+    int slot = it.value();
+    unlink(slot);
+    keys[slot] = 0;
+    texts[slot].clear();
+    folded[slot].clear();
+    freeSlots.append(slot);
+    slotOf.erase(it);
+}
+
+void LabelIndex::clear()
+{
+    *this = LabelIndex();
+}
+
+QString LabelIndex::text(quintptr key) const
+{
+    QHash<quintptr, int>::const_iterator it = slotOf.constFind(key);
+    return it == slotOf.constEnd() ? QString() : texts.at(it.value());
+}
+
+QList<quintptr> LabelIndex::search(const QString& query, MatchMode mode, Qt::CaseSensitivity sensitivity) const
+{
+    QList<quintptr> result;
+    if (query.isEmpty())
+    {
+        return result;
+    }
+    QRegularExpression expression;
+    QString literal = query;
+    if (mode == Regex)
+    {
+        expression = QRegularExpression(query, sensitivity == Qt::CaseInsensitive ? QRegularExpression::CaseInsensitiveOption
+                                                                                  : QRegularExpression::NoPatternOption);
+        if (!expression.isValid())
+        {
+            return result;
+        }
+        literal = literalRun(query);
+    }
+
+    // 字面量不足三个字符时无法用索引缩小范围，逐个核对
+    QString foldedLiteral = literal.toCaseFolded();
+    bool indexed = foldedLiteral.size() >= 3;
+    QVector<int> candidateSlots = indexed ? candidates(foldedLiteral) : QVector<int>();
+    int total = indexed ? candidateSlots.size() : keys.size();
+    for (int i = 0; i < total; ++i)
+    {
+        int slot = indexed ? candidateSlots.at(i) : i;
+        if (keys.at(slot) == 0)
+        {
+            continue;
+        }
+        bool matched;
+        if (mode == Regex)
+        {
+            matched = expression.match(texts.at(slot)).hasMatch();
+        }
+        else if (sensitivity == Qt::CaseInsensitive)
+        {
+            // 折叠后的文本已缓存，不必每次转换
+            const QString& text = folded.at(slot);
+            matched = mode == Exact ? text == foldedLiteral : mode == Prefix ? text.startsWith(foldedLiteral) : text.contains(foldedLiteral);
+        }
+        else
+        {
+            matched = matches(texts.at(slot), query, mode, sensitivity);
+        }
+        if (matched)
+        {
+            result.append(keys.at(slot));
+        }
+    }
+    return result;
+}
+
+bool LabelIndex::matches(const QString& text, const QString& query, MatchMode mode, Qt::CaseSensitivity sensitivity)
+{
+    if (query.isEmpty())
+    {
+        return false;
+    }
+    switch (mode)
+    {
+        case Exact:
+            return text.compare(query, sensitivity) == 0;
+        case Prefix:
+            return text.startsWith(query, sensitivity);
+        case Substring:
+            return text.contains(query, sensitivity);
+        case Regex:
+            return QRegularExpression(query, sensitivity == Qt::CaseInsensitive ? QRegularExpression::CaseInsensitiveOption
+                                                                                : QRegularExpression::NoPatternOption).match(text).hasMatch();
+    }
+    return false;
+}
+
+QVector<quint64> LabelIndex::trigrams(const QString& text)
+{
+    QVector<quint64> grams;
+    grams.reserve(qMax(0, text.size() - 2));
+    for (int i = 0; i + 2 < text.size(); ++i)
+    {
+        grams.append(quint64(text.at(i).unicode()) << 32 | quint64(text.at(i + 1).unicode()) << 16 | text.at(i + 2).unicode());
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+QString LabelIndex::literalRun(const QString& pattern)
+{
+    // 含有分支时任何字面量都不是必须的
+    if (pattern.contains(QLatin1Char('|')))
+    {
+        return QString();
+    }
+    // 按元字符切分，跳过转义、字符类和可以重复零次的字符
+    // 分组可能带量词或是断言，其中的字面量不一定出现，遇到分组时放弃索引
+    QString best;
+    QString current;
+    auto finish = [&]() {
+        if (current.size() > best.size())
+        {
+            best = current;
+        }
+        current.clear();
+    };
+    const QString special = QStringLiteral("\\.[](){}*+?^$");
+    for (int i = 0; i < pattern.size(); ++i)
+    {
+        QChar c = pattern.at(i);
+        if (c == QLatin1Char('\\') || c == QLatin1Char('['))
+        {
+            finish();
+            if (c == QLatin1Char('\\'))
+            {
+                ++i;                                                    // 转义序列整体跳过
+            }
+            else
+            {
+                while (i < pattern.size() && pattern.at(i) != QLatin1Char(']'))
+                {
+                    ++i;
+                }
+            }
+            continue;
+        }
+        if (c == QLatin1Char('('))
+        {
+            return QString();
+        }
+        if (special.contains(c))
+        {
+            // 量词作用于前一个字符，它可能不出现
+            if ((c == QLatin1Char('*') || c == QLatin1Char('?') || c == QLatin1Char('{')) && !current.isEmpty())
+            {
+                current.chop(1);
+            }
+            finish();
+            if (c == QLatin1Char('{'))
+            {
+                // 重复次数不是文本中的字符，整体跳过
+                while (i < pattern.size() && pattern.at(i) != QLatin1Char('}'))
+                {
+                    ++i;
+                }
+            }
+            continue;
+        }
+        current.append(c);
+    }
+    finish();
+    return best;
+}
+
+QVector<int> LabelIndex::candidates(const QString& foldedQuery) const
+{
+    QVector<quint64> grams = trigrams(foldedQuery);
+    QVector<const QVector<int>*> lists;
+    for (quint64 gram : qAsConst(grams))
+    {
+        QHash<quint64, QVector<int>>::const_iterator it = postings.constFind(gram);
+        if (it == postings.constEnd())
+        {
+            return QVector<int>();                                      // 有三字组从未出现
+        }
+        lists.append(&it.value());
+    }
+    // 从最短的倒排表开始求交集
+    std::sort(lists.begin(), lists.end(), [](const QVector<int>* a, const QVector<int>* b) { return a->size() < b->size(); });
+    QVector<int> result = *lists.first();
+    QVector<int> merged;
+    for (int i = 1; i < lists.size() && !result.isEmpty(); ++i)
+    {
+        merged.clear();
+        std::set_intersection(result.begin(), result.end(), lists.at(i)->begin(), lists.at(i)->end(), std::back_inserter(merged));
+        result.swap(merged);
+    }
+    return result;
+}
+
+void LabelIndex::unlink(int slot)
+{
+    QVector<quint64> grams = trigrams(folded.at(slot));
+    for (quint64 gram : qAsConst(grams))
+    {
+        QHash<quint64, QVector<int>>::iterator it = postings.find(gram);
+        if (it == postings.end())
+        {
+            continue;
+        }
+        QVector<int>::iterator position = std::lower_bound(it->begin(), it->end(), slot);
+        if (position != it->end() && *position == slot)
+        {
+            it->erase(position);
+        }
+        if (it->isEmpty())
+        {
+            postings.erase(it);
+        }
+    }
+}
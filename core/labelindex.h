@@ -0,0 +1,42 @@
+﻿#ifndef LABELINDEX_H
+#define LABELINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+// 文本的倒排索引：按不区分大小写的三字组（连续三个字符）登记每个文本，
+// 长度不少于三的查询先取各三字组倒排表的交集，再逐个核对候选，支持精确、前缀、包含和正则匹配
+// 文本以键（通常是图元指针）增量登记，修改一个文本只更新它自己的倒排项
+class LabelIndex
+{
+public:
+    enum MatchMode { Exact, Prefix, Substring, Regex };                // 匹配方式
+
+    void setLabel(quintptr key, const QString& text);                   // 登记或更新文本
+    void removeLabel(quintptr key);
+    void clear();
+    int count() const { return slotOf.size(); }
+    bool contains(quintptr key) const { return slotOf.contains(key); }
+    QString text(quintptr key) const;
+
+    // 按登记顺序返回匹配的文本，查询为空或正则表达式无效时返回空
+    QList<quintptr> search(const QString& query, MatchMode mode, Qt::CaseSensitivity sensitivity = Qt::CaseInsensitive) const;
+    static bool matches(const QString& text, const QString& query, MatchMode mode, Qt::CaseSensitivity sensitivity = Qt::CaseInsensitive);
+
+private:
+    QHash<quintptr, int> slotOf;                                        // 键到槽位
+    QVector<quintptr> keys;                                             // 槽位中的键，空槽为0
+    QVector<QString> texts;                                             // 原文
+    QVector<QString> folded;                                            // 折叠大小写后的文本
+    QVector<int> freeSlots;                                             // 可复用的空槽
+    QHash<quint64, QVector<int>> postings;                              // 三字组到槽位，槽位升序
+
+    static QVector<quint64> trigrams(const QString& text);             // 文本中不重复的三字组
+    static QString literalRun(const QString& pattern);                  // 正则表达式中必须出现的最长字面量，无法确定时为空
+    QVector<int> candidates(const QString& foldedQuery) const;          // 包含查询所有三字组的槽位
+    void unlink(int slot);                                              // 从倒排表中移除槽位
+};
+
+#endif // LABELINDEX_H
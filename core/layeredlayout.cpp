@@ -0,0 +1,523 @@
+﻿#include "layeredlayout.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <random>
+
+static const int startOrEndType = 1;                // 开始或结束，与 FlowEnumItem 一致
+static const int judgeType = 4;                     // 判定
+static const double branchBias = 0.25;              // 判定分支之间的排序偏移，小于相邻序号之差
+
+LayeredLayout::LayeredLayout(const DiagramModel& model, const Options& options)
+    : model(model), options(options), nodeCount(model.nodeCount())
+{}
+
+QVector<QPointF> LayeredLayout::layout(const DiagramModel& model, const Options& options)
+{
+    LayeredLayout layout(model, options);
+    return layout.run();
+}
+
+QVector<QPointF> LayeredLayout::run()
+{
+    if (nodeCount == 0)
+    {
+        return QVector<QPointF>();
+    }
+    breakCycles();
+    assignLayers();
+    buildLayers();
+    reduceCrossings();
+    if (isCancelled())
+    {
+        return QVector<QPointF>();
+    }
+    assignCoordinates();
+    if (isCancelled())
+    {
+        return QVector<QPointF>();
+    }
+    return positions();
+}
+
+bool LayeredLayout::isCancelled() const
+{
+    return options.cancel != nullptr && options.cancel->loadAcquire() != 0;
+}
+
+void LayeredLayout::breakCycles()
+{
+    // 按出边顺序建立邻接表，忽略自环
+    QVector<QVector<int>> outEdges(nodeCount);
+    QVector<int> inDegree(nodeCount, 0);
+    for (int e = 0; e < model.edgeCount(); ++e)
+    {
+        int from = model.edgeStarts.at(e);
+        int to = model.edgeEnds.at(e);
+        if (from != to)
+        {
+            outEdges[from].append(e);
+            inDegree[to]++;
+        }
+    }
+
+    // 从没有入边的开始图形出发，其次是其他没有入边的图形，保证流程方向自上而下
+    QVector<int> roots;
+    roots.reserve(nodeCount);
+    for (int v = 0; v < nodeCount; ++v)
+    {
+        if (inDegree.at(v) == 0 && model.nodeTypes.at(v) == startOrEndType)
+        {
+            roots.append(v);
+        }
+    }
+    for (int v = 0; v < nodeCount; ++v)
+    {
+        if (inDegree.at(v) == 0 && model.nodeTypes.at(v) != startOrEndType)
+        {
+            roots.append(v);
+        }
+    }
+    for (int v = 0; v < nodeCount; ++v)
+    {
+        if (inDegree.at(v) != 0)
+        {
+            roots.append(v);
+        }
+    }
+
+    // 非递归的深度优先搜索，指向栈中顶点的边为回边，反转后得到无环图
+    QVector<quint8> state(nodeCount, 0);            // 0 未访问，1 在栈中，2 已完成
+    QVector<QPair<int, int>> stack;                 // 顶点和下一条待处理出边的序号
+    QVector<bool> reversed(model.edgeCount(), false);
+    for (int root : qAsConst(roots))
+    {
+        if (state.at(root) != 0)
+        {
+            continue;
+        }
+        state[root] = 1;
+        stack.append(qMakePair(root, 0));
+        while (!stack.isEmpty())
+        {
+            QPair<int, int>& top = stack.last();
+            int v = top.first;
+            if (top.second == outEdges.at(v).size())
+            {
+                state[v] = 2;
+                stack.removeLast();
+                continue;
+            }
+            int e = outEdges.at(v).at(top.second++);
+            int to = model.edgeEnds.at(e);
+            if (state.at(to) == 1)
+            {
+                reversed[e] = true;
+            }
+            else if (state.at(to) == 0)
+            {
+                state[to] = 1;
+                stack.append(qMakePair(to, 0));
+            }
+        }
+    }
+
+    // 生成无环图的边，判定图形的各分支按出边顺序对称地偏移
+    dagEdges.clear();
+    dagBias.clear();
+    for (int v = 0; v < nodeCount; ++v)
+    {
+        const QVector<int>& edges = outEdges.at(v);
+        int branches = 0;
+        for (int e : edges)
+        {
+            branches += reversed.at(e) ? 0 : 1;
+        }
+        int branch = 0;
+        for (int e : edges)
+        {
+            if (reversed.at(e))
+            {
+                continue;
+            }
+            dagEdges.append(qMakePair(v, model.edgeEnds.at(e)));
+            bool judge = model.nodeTypes.at(v) == judgeType && branches > 1;
+            dagBias.append(judge ? (branch - (branches - 1) / 2.0) * branchBias / branches : 0.0);
+            branch++;
+        }
+        for (int e : edges)
+        {
+            if (reversed.at(e))
+            {
+                dagEdges.append(qMakePair(model.edgeEnds.at(e), v));
+                dagBias.append(0.0);
+            }
+        }
+    }
+}
+
+void LayeredLayout::assignLayers()
+{
+    // 拓扑排序后按最长路径分层
+    QVector<QVector<int>> successors(nodeCount);
+    QVector<int> inDegree(nodeCount, 0);
+    QVector<int> outDegree(nodeCount, 0);
+    for (const QPair<int, int>& edge : qAsConst(dagEdges))
+    {
+        successors[edge.first].append(edge.second);
+        inDegree[edge.second]++;
+        outDegree[edge.first]++;
+    }
+    QVector<int> queue;
+    queue.reserve(nodeCount);
+    for (int v = 0; v < nodeCount; ++v)
+    {
+        if (inDegree.at(v) == 0)
+        {
+            queue.append(v);
+        }
+    }
+    vertexLayer.fill(0, nodeCount);
+    int maxLayer = 0;
+    for (int i = 0; i < queue.size(); ++i)
+    {
+        int v = queue.at(i);
+        for (int to : successors.at(v))
+        {
+            vertexLayer[to] = qMax(vertexLayer.at(to), vertexLayer.at(v) + 1);
+            maxLayer = qMax(maxLayer, vertexLayer.at(to));
+            if (--inDegree[to] == 0)
+            {
+                queue.append(to);
+            }
+        }
+    }
+
+    // 有入边、没有出边的开始/结束图形是流程的终点，统一放在最后一层
+    for (int v = 0; v < nodeCount; ++v)
+    {
+        if (model.nodeTypes.at(v) == startOrEndType && outDegree.at(v) == 0 && vertexLayer.at(v) > 0)
+        {
+            vertexLayer[v] = maxLayer;
+        }
+    }
+}
+
+void LayeredLayout::buildLayers()
+{
+    // 跨越多层的边拆成经过虚拟顶点的短边
+    upper = QVector<QVector<int>>(nodeCount);
+    lower = QVector<QVector<int>>(nodeCount);
+    upperBias = QVector<QVector<double>>(nodeCount);
+    lowerBias = QVector<QVector<double>>(nodeCount);
+    for (int i = 0; i < dagEdges.size(); ++i)
+    {
+        int from = dagEdges.at(i).first;
+        int to = dagEdges.at(i).second;
+        double bias = dagBias.at(i);
+        while (vertexLayer.at(to) - vertexLayer.at(from) > 1)
+        {
+            int dummy = vertexLayer.size();
+            vertexLayer.append(vertexLayer.at(from) + 1);
+            upper.append(QVector<int>() << from);
+            upperBias.append(QVector<double>() << bias);
+            lower.append(QVector<int>());
+            lowerBias.append(QVector<double>());
+            lower[from].append(dummy);
+            lowerBias[from].append(bias);
+            from = dummy;
+            bias = 0;
+        }
+        lower[from].append(to);
+        lowerBias[from].append(bias);
+        upper[to].append(from);
+        upperBias[to].append(bias);
+    }
+
+    int vertexCount = vertexLayer.size();
+    sizes.resize(vertexCount);
+    for (int v = 0; v < vertexCount; ++v)
+    {
+        sizes[v] = v < nodeCount ? model.nodeBounds(v).size() : QSizeF(0, 0);
+    }
+
+    // 初始顺序：按深度优先的访问顺序放入各层，使同一分支的顶点相邻；指定种子时随机选择访问顺序
+    int layerCount = 0;
+    for (int layer : qAsConst(vertexLayer))
+    {
+        layerCount = qMax(layerCount, layer + 1);
+    }
+    layers = QVector<QVector<int>>(layerCount);
+    order.fill(0, vertexCount);
+    QVector<bool> visited(vertexCount, false);
+    QVector<int> roots;
+    for (int v = 0; v < vertexCount; ++v)
+    {
+        if (upper.at(v).isEmpty())
+        {
+            roots.append(v);
+        }
+    }
+    std::mt19937 random(options.seed);
+    if (options.seed != 0)
+    {
+        std::shuffle(roots.begin(), roots.end(), random);
+    }
+    QVector<int> stack;
+    QVector<int> children;
+    for (int root : qAsConst(roots))
+    {
+        if (visited.at(root))
+        {
+            continue;
+        }
+        stack.append(root);
+        while (!stack.isEmpty())
+        {
+            int v = stack.takeLast();
+            if (visited.at(v))
+            {
+                continue;
+            }
+            visited[v] = true;
+            order[v] = layers.at(vertexLayer.at(v)).size();
+            layers[vertexLayer.at(v)].append(v);
+            children = lower.at(v);
+            if (options.seed != 0)
+            {
+                std::shuffle(children.begin(), children.end(), random);
+            }
+            for (int i = children.size() - 1; i >= 0; --i)
+            {
+                stack.append(children.at(i));
+            }
+        }
+    }
+}
+
+void LayeredLayout::reduceCrossings()
+{
+    // 保留扫描过程中交叉最少的排列
+    QVector<QVector<int>> bestLayers = layers;
+    qint64 best = crossings();
+    for (int sweep = 0; sweep < options.sweeps && best > 0 && !isCancelled(); ++sweep)
+    {
+        for (int layer = 1; layer < layers.size(); ++layer)
+        {
+            sweepLayer(layer, true);
+        }
+        for (int layer = layers.size() - 2; layer >= 0; --layer)
+        {
+            sweepLayer(layer, false);
+        }
+        qint64 current = crossings();
+        if (current < best)
+        {
+            best = current;
+            bestLayers = layers;
+        }
+    }
+    layers = bestLayers;
+    for (const QVector<int>& layer : qAsConst(layers))
+    {
+        for (int i = 0; i < layer.size(); ++i)
+        {
+            order[layer.at(i)] = i;
+        }
+    }
+}
+
+void LayeredLayout::sweepLayer(int layer, bool downward)
+{
+    QVector<int>& vertices = layers[layer];
+    QVector<double> keys(vertices.size());
+    QVector<double> values;
+    for (int i = 0; i < vertices.size(); ++i)
+    {
+        int v = vertices.at(i);
+        const QVector<int>& neighbours = downward ? upper.at(v) : lower.at(v);
+        const QVector<double>& bias = downward ? upperBias.at(v) : lowerBias.at(v);
+        if (neighbours.isEmpty())
+        {
+            keys[i] = order.at(v);          // 没有相邻顶点时保持原位
+            continue;
+        }
+        // 向下扫描时分支顶点排在判定图形偏左或偏右的位置；向上时判定图形回到各分支的中间
+        values.resize(neighbours.size());
+        for (int j = 0; j < neighbours.size(); ++j)
+        {
+            values[j] = order.at(neighbours.at(j)) + (downward ? bias.at(j) : -bias.at(j));
+        }
+        if (options.median)
+        {
+            std::sort(values.begin(), values.end());
+            int middle = values.size() / 2;
+            keys[i] = values.size() % 2 == 1 ? values.at(middle) : (values.at(middle - 1) + values.at(middle)) / 2;
+        }
+        else
+        {
+            keys[i] = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+        }
+    }
+
+    QVector<int> index(vertices.size());
+    for (int i = 0; i < index.size(); ++i)
+    {
+        index[i] = i;
+    }
+    std::stable_sort(index.begin(), index.end(), [&keys](int a, int b) { return keys.at(a) < keys.at(b); });
+    QVector<int> sorted(vertices.size());
+    for (int i = 0; i < index.size(); ++i)
+    {
+        sorted[i] = vertices.at(index.at(i));
+        order[sorted.at(i)] = i;
+    }
+    vertices = sorted;
+}
+
+qint64 LayeredLayout::crossings() const
+{
+    qint64 total = 0;
+    for (int layer = 0; layer + 1 < layers.size(); ++layer)
+    {
+        total += layerCrossings(layer);
+    }
+    return total;
+}
+
+qint64 LayeredLayout::layerCrossings(int layer) const
+{
+    // 按上端序号排序后，下端序号的逆序对数即为交叉数，用树状数组统计
+    const QVector<int>& vertices = layers.at(layer);
+    QVector<int> lowerOrders;
+    for (int v : vertices)
+    {
+        QVector<int> ends;
+        for (int to : lower.at(v))
+        {
+            ends.append(order.at(to));
+        }
+        std::sort(ends.begin(), ends.end());
+        lowerOrders += ends;
+    }
+    int size = layers.at(layer + 1).size();
+    QVector<int> tree(size + 1, 0);
+    qint64 count = 0;
+    for (int i = 0; i < lowerOrders.size(); ++i)
+    {
+        // 已插入的、下端序号大于当前的边与当前边交叉
+        int greater = i;
+        for (int k = lowerOrders.at(i) + 1; k > 0; k -= k & -k)
+        {
+            greater -= tree.at(k);
+        }
+        count += greater;
+        for (int k = lowerOrders.at(i) + 1; k <= size; k += k & -k)
+        {
+            tree[k]++;
+        }
+    }
+    return count;
+}
+
+void LayeredLayout::assignCoordinates()
+{
+    int vertexCount = vertexLayer.size();
+    x.fill(0, vertexCount);
+    // 相邻顶点之间的最小中心距离
+    auto separation = [this](int a, int b) {
+        return (sizes.at(a).width() + sizes.at(b).width()) / 2 + ((a < nodeCount && b < nodeCount) ? options.nodeGap : options.nodeGap / 2);
+    };
+
+    // 初始时每层从左向右紧密排列
+    for (const QVector<int>& layer : qAsConst(layers))
+    {
+        for (int i = 1; i < layer.size(); ++i)
+        {
+            x[layer.at(i)] = x.at(layer.at(i - 1)) + separation(layer.at(i - 1), layer.at(i));
+        }
+    }
+
+    // 交替向下、向上调整：每个顶点靠向相邻层顶点的平均位置，
+    // 分别从左、从右满足最小间距后取平均，结果仍满足间距且不偏向一侧
+    QVector<double> desired;
+    QVector<double> left;
+    QVector<double> right;
+    for (int pass = 0; pass < options.refinements && !isCancelled(); ++pass)
+    {
+        bool downward = pass % 2 == 0;
+        for (int step = 0; step < layers.size(); ++step)
+        {
+            const QVector<int>& layer = layers.at(downward ? step : layers.size() - 1 - step);
+            int count = layer.size();
+            desired.resize(count);
+            for (int i = 0; i < count; ++i)
+            {
+                int v = layer.at(i);
+                const QVector<int>& neighbours = downward ? upper.at(v) : lower.at(v);
+                if (neighbours.isEmpty())
+                {
+                    desired[i] = x.at(v);
+                    continue;
+                }
+                double sum = 0;
+                for (int n : neighbours)
+                {
+                    sum += x.at(n);
+                }
+                desired[i] = sum / neighbours.size();
+            }
+            left = desired;
+            for (int i = 1; i < count; ++i)
+            {
+                left[i] = qMax(left.at(i), left.at(i - 1) + separation(layer.at(i - 1), layer.at(i)));
+            }
+            right = desired;
+            for (int i = count - 2; i >= 0; --i)
+            {
+                right[i] = qMin(right.at(i), right.at(i + 1) - separation(layer.at(i), layer.at(i + 1)));
+            }
+            for (int i = 0; i < count; ++i)
+            {
+                x[layer.at(i)] = (left.at(i) + right.at(i)) / 2;
+            }
+        }
+    }
+}
+
+QVector<QPointF> LayeredLayout::positions() const
+{
+    // 每层的高度取该层最高的图形，图形在层内垂直居中
+    QVector<double> layerTop(layers.size(), 0);
+    QVector<double> layerHeight(layers.size(), 0);
+    for (int v = 0; v < nodeCount; ++v)
+    {
+        layerHeight[vertexLayer.at(v)] = qMax(layerHeight.at(vertexLayer.at(v)), sizes.at(v).height());
+    }
+    for (int layer = 1; layer < layers.size(); ++layer)
+    {
+        layerTop[layer] = layerTop.at(layer - 1) + layerHeight.at(layer - 1) + options.layerGap;
+    }
+
+    // 图形的位置是其左上角（缩放前），由中心位置减去边界相对位置的偏移得到
+    QVector<QPointF> result(nodeCount);
+    QPointF oldTopLeft(std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    QPointF newTopLeft(std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    for (int v = 0; v < nodeCount; ++v)
+    {
+        QRectF bounds = model.nodeBounds(v);
+        QPointF center(x.at(v), layerTop.at(vertexLayer.at(v)) + layerHeight.at(vertexLayer.at(v)) / 2);
+        result[v] = center - (bounds.center() - model.nodePositions.at(v));
+        oldTopLeft = QPointF(qMin(oldTopLeft.x(), bounds.left()), qMin(oldTopLeft.y(), bounds.top()));
+        newTopLeft = QPointF(qMin(newTopLeft.x(), center.x() - bounds.width() / 2), qMin(newTopLeft.y(), center.y() - bounds.height() / 2));
+    }
+
+    // 布局结果放在原来图形所在区域的左上角
+    QPointF offset = oldTopLeft - newTopLeft;
+    for (QPointF& position : result)
+    {
+        position += offset;
+    }
+    return result;
+}
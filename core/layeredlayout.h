@@ -0,0 +1,65 @@
+﻿#ifndef LAYEREDLAYOUT_H
+#define LAYEREDLAYOUT_H
+
+#include <QAtomicInt>
+#include <QPointF>
+#include <QSizeF>
+#include <QVector>
+
+#include "diagrammodel.h"
+
+// 分层自动布局（Sugiyama）：去环、分层、减少交叉、坐标分配
+// 开始/结束图形中没有入边的放在第一层，没有出边的放在最后一层；
+// 判定图形的各个分支按连线顺序从左到右排在判定图形下方
+// 只读取模型，不修改场景，可以在工作线程中运行
+class LayeredLayout
+{
+public:
+    struct Options
+    {
+        double nodeGap = 90;                                        // 同一层相邻图形之间的空隙
+        double layerGap = 90;                                       // 相邻两层之间的空隙
+        int sweeps = 8;                                             // 减少交叉时上下扫描的次数
+        int refinements = 8;                                        // 坐标分配时向相邻顶点靠拢的次数
+        bool median = false;                                        // 按相邻顶点的中位数而不是重心排序
+        quint32 seed = 0;                                           // 非0时随机打乱初始顺序，用于多次重新开始
+        const QAtomicInt* cancel = nullptr;                         // 取消标志，非0时尽快返回
+    };
+
+    explicit LayeredLayout(const DiagramModel& model, const Options& options = Options());
+
+    QVector<QPointF> run();                                         // 计算每个图形的新位置，与 nodePositions 同下标，取消时返回空
+    qint64 crossings() const;                                       // 当前排列下连线的交叉数
+    int layerCount() const { return layers.size(); }
+
+    static QVector<QPointF> layout(const DiagramModel& model, const Options& options = Options()); // 一次完成布局
+
+private:
+    const DiagramModel& model;
+    Options options;
+    int nodeCount;                                                  // 真实图形数，之后的顶点为长连线拆出的虚拟顶点
+
+    QVector<QPair<int, int>> dagEdges;                              // 去环后的有向边
+    QVector<double> dagBias;                                        // 判定分支的排序偏移，与 dagEdges 同下标
+    QVector<int> vertexLayer;                                       // 每个顶点所在的层
+    QVector<QVector<int>> upper;                                    // 上一层的相邻顶点
+    QVector<QVector<int>> lower;                                    // 下一层的相邻顶点
+    QVector<QVector<double>> upperBias;                             // 与 upper 对应的偏移
+    QVector<QVector<double>> lowerBias;                             // 与 lower 对应的偏移
+    QVector<QVector<int>> layers;                                   // 每层从左到右的顶点
+    QVector<int> order;                                             // 顶点在本层中的序号
+    QVector<QSizeF> sizes;                                          // 顶点的大小，虚拟顶点为0
+    QVector<double> x;                                              // 顶点中心的横坐标
+
+    void breakCycles();                                             // 深度优先搜索，反转回边
+    void assignLayers();                                            // 最长路径分层，并固定开始和结束图形
+    void buildLayers();                                             // 拆分跨层连线并生成初始顺序
+    bool isCancelled() const;
+    void reduceCrossings();                                         // 重心法上下扫描
+    void sweepLayer(int layer, bool downward);                      // 按相邻层的重心重新排列一层
+    qint64 layerCrossings(int layer) const;                         // 第layer层与下一层之间的交叉数
+    void assignCoordinates();                                       // 在保持顺序和间距的前提下向相邻顶点的平均位置靠拢
+    QVector<QPointF> positions() const;                             // 转换为图形的位置
+};
+
+#endif // LAYEREDLAYOUT_H
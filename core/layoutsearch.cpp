@@ -0,0 +1,105 @@
+﻿#include "layoutsearch.h"
+
+#include <QMetaType>
+#include <QRunnable>
+
+// 一次重新开始：种子为0的任务与同步布局的结果相同，保证搜索结果不会更差
+class LayoutSearch::Task : public QRunnable
+{
+public:
+    Task(LayoutSearch* search, int index) : search(search), index(index) {}
+
+    void run() override
+    {
+        LayeredLayout::Options options;
+        if (index > 0)
+        {
+            options.seed = quint32(index);
+            options.median = index % 2 == 1;                            // 重心法与中位数法交替使用
+            options.sweeps = 24;
+            options.refinements = 16;
+        }
+        options.cancel = &search->cancelled;
+        LayeredLayout layout(search->model, options);
+        QVector<QPointF> positions = layout.run();
+        search->report(positions, positions.isEmpty() ? -1 : layout.crossings());
+    }
+
+private:
+    LayoutSearch* search;
+    int index;
+};
+
+LayoutSearch::LayoutSearch(const DiagramModel& model, int restarts, QObject* parent)
+    : QObject(parent), model(model), restarts(restarts), crossings(-1)
+{
+    qRegisterMetaType<QVector<QPointF>>("QVector<QPointF>");
+    if (this->restarts <= 0)
+    {
+        this->restarts = qMax(4, pool.maxThreadCount() * 2);
+    }
+}
+
+LayoutSearch::~LayoutSearch()
+{
+    cancel();
+    pool.waitForDone();
+}
+
+void LayoutSearch::start()
+{
+    cancelled.storeRelease(0);
+    finishedCount.storeRelease(0);
+    for (int i = 0; i < restarts; ++i)
+    {
+        pool.start(new Task(this, i));
+    }
+}
+
+void LayoutSearch::cancel()
+{
+    cancelled.storeRelease(1);
+    pool.clear();                                                       // 丢弃尚未开始的任务
+}
+
+bool LayoutSearch::isRunning() const
+{
+    return finishedCount.loadAcquire() < restarts && cancelled.loadAcquire() == 0;
+}
+
+QVector<QPointF> LayoutSearch::bestPositions() const
+{
+    QMutexLocker locker(&mutex);
+    return best;
+}
+
+qint64 LayoutSearch::bestCrossings() const
+{
+    QMutexLocker locker(&mutex);
+    return crossings;
+}
+
+void LayoutSearch::report(const QVector<QPointF>& positions, qint64 crossings)
+{
+    bool better = false;
+    if (!positions.isEmpty())
+    {
+        QMutexLocker locker(&mutex);
+        if (this->crossings < 0 || crossings < this->crossings)
+        {
+            this->crossings = crossings;
+            best = positions;
+            better = true;
+        }
+    }
+    if (better)
+    {
+        emit improved(positions, crossings);
+    }
+    int done = finishedCount.fetchAndAddOrdered(1) + 1;
+    emit progress(done, restarts);
+    if (done == restarts)
+    {
+        emit finished();
+    }
+}
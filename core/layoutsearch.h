@@ -0,0 +1,47 @@
+﻿#ifndef LAYOUTSEARCH_H
+#define LAYOUTSEARCH_H
+
+#include <QObject>
+#include <QMutex>
+#include <QThreadPool>
+
+#include "layeredlayout.h"
+
+// 并行布局搜索：在线程池中运行多次分层布局，每次使用不同的随机初始顺序和排序方式，
+// 找到交叉更少的布局时发出 improved，界面可以随时显示目前最好的结果或取消搜索
+class LayoutSearch : public QObject
+{
+    Q_OBJECT
+public:
+    // restarts 为0时按线程数决定重新开始的次数
+    explicit LayoutSearch(const DiagramModel& model, int restarts = 0, QObject* parent = nullptr);
+    ~LayoutSearch() override;                                           // 取消并等待所有任务结束
+
+    void start();                                                       // 开始搜索
+    void cancel();                                                      // 取消，正在运行的任务尽快返回
+    bool isRunning() const;
+    QVector<QPointF> bestPositions() const;                             // 目前最好的布局，尚无结果时为空
+    qint64 bestCrossings() const;                                       // 目前最好布局的交叉数，尚无结果时为-1
+    int getRestarts() const { return restarts; }
+
+signals:
+    void improved(const QVector<QPointF>& positions, qint64 crossings); // 找到交叉更少的布局，在工作线程中发出
+    void progress(int finished, int total);                             // 完成一次布局
+    void finished();                                                    // 全部完成或已取消
+
+private:
+    class Task;
+
+    const DiagramModel model;                                           // 各任务只读共享
+    int restarts;                                                       // 重新开始的次数
+    QThreadPool pool;                                                   // 独立的线程池，析构时只等待自己的任务
+    QAtomicInt cancelled;                                               // 取消标志
+    QAtomicInt finishedCount;                                           // 已完成的任务数
+    mutable QMutex mutex;                                               // 保护最好的结果
+    QVector<QPointF> best;
+    qint64 crossings;
+
+    void report(const QVector<QPointF>& positions, qint64 crossings);  // 任务完成时提交结果
+};
+
+#endif // LAYOUTSEARCH_H
@@ -0,0 +1,42 @@
+﻿#include "mippyramid.h"
+
+MipPyramid::MipPyramid(const QImage& image)
+{
+    if (image.isNull())
+    {
+        return;
+    }
+    levels.append(image);
+    // 每级由上一级缩小一半，累计的工作量不超过原图的三分之一
+    while (qMax(levels.last().width(), levels.last().height()) > minimumSize)
+    {
+        const QImage& previous = levels.last();
+        QSize half(qMax(1, previous.width() / 2), qMax(1, previous.height() / 2));
+        levels.append(previous.scaled(half, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    }
+}
+
+const QImage& MipPyramid::levelFor(const QSize& size) const
+{
+    // 级别从大到小排列，找到最后一个不小于 size 的
+    int index = 0;
+    while (index + 1 < levels.size() && levels.at(index + 1).width() >= size.width() && levels.at(index + 1).height() >= size.height())
+    {
+        ++index;
+    }
+    return levels.at(index);
+}
+
+QImage MipPyramid::scaled(const QSize& size, Qt::TransformationMode mode) const
+{
+    if (levels.isEmpty() || size.isEmpty())
+    {
+        return QImage();
+    }
+    const QImage& source = levelFor(size);
+    if (source.size() == size)
+    {
+        return source;
+    }
+    return source.scaled(size, Qt::IgnoreAspectRatio, mode);
+}
@@ -0,0 +1,29 @@
+﻿#ifndef MIPPYRAMID_H
+#define MIPPYRAMID_H
+
+#include <QImage>
+#include <QVector>
+
+// 图片的多级缩小版本（mip金字塔）：第0级为原图，之后每级的宽高为上一级的一半，直到不超过 minimumSize
+// 缩放到某个尺寸时取不小于该尺寸的最小一级，再做一次不超过2倍的缩放，快速变换的效果也足够平滑
+// 只使用 QImage，可以在工作线程中生成，复制时共享图片数据
+class MipPyramid
+{
+public:
+    static const int minimumSize = 32;                                  // 最小一级的长边
+
+    MipPyramid() {}
+    explicit MipPyramid(const QImage& image);                           // 逐级平滑缩小生成所有级别，耗时与原图大小成正比
+
+    bool isEmpty() const { return levels.isEmpty(); }
+    int levelCount() const { return levels.size(); }
+    const QImage& level(int index) const { return levels.at(index); }
+    QSize originalSize() const { return levels.isEmpty() ? QSize() : levels.first().size(); }
+    const QImage& levelFor(const QSize& size) const;                    // 不小于 size 的最小一级，都小于 size 时为原图
+    QImage scaled(const QSize& size, Qt::TransformationMode mode) const; // 从合适的一级缩放到 size，不保持比例
+
+private:
+    QVector<QImage> levels;
+};
+
+#endif // MIPPYRAMID_H
@@ -1,5 +1,9 @@
 ﻿#include "operationstack.h"
 
+Operation::Operation(QObject* parent)
+    : QObject(parent)
+{}
+
 OperationStack::OperationStack(QObject* parent)
     : QObject(parent)
 {}
@@ -17,7 +21,7 @@ void OperationStack::undo()
 {
     if (undoStack->count() == 0)                // 检查撤销栈是否为空
     {
-        QMessageBox::information(dynamic_cast<QWidget*>(this->parent()), tr("提示"), tr("无可撤销项!"));  // 提示用户无可撤销项
+        emit stackIsEmpty(tr("无可撤销项!"));  // 提示用户无可撤销项
         return;
     }
     Operation* operation = undoStack->pop();    // 从撤销栈中弹出操作
@@ -31,7 +35,7 @@ void OperationStack:: redo()
 {
     if (redoStack->count() == 0)                // 检查重做栈是否为空
     {
-        QMessageBox::information(dynamic_cast<QWidget*>(this->parent()), tr("提示"), tr("无可执行项!"));  // 提示用户无可执行项
+        emit stackIsEmpty(tr("无可执行项!"));  // 提示用户无可执行项
         return;
     }
     Operation* com = redoStack->pop();          // 从重做栈中弹出操作
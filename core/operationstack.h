@@ -1,11 +1,21 @@
 ﻿#ifndef OPERATIONSTACK_H
 #define OPERATIONSTACK_H
 
+#include <QObject>
 #include <QStack>
-#include <QMessageBox>
 
-#include "operation.h"
+// 可撤销操作的基类，具体的图形操作在应用中实现
+class Operation : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Operation(QObject* parent = nullptr);
+
+    virtual void undo() const = 0;  // 撤销操作
+    virtual void redo() const = 0;  // 重做操作
+};
 
+// 撤销栈和重做栈，不依赖界面；栈为空时发出 stackIsEmpty 信号，由视图决定是否提示
 class OperationStack:public QObject
 {
     Q_OBJECT
@@ -23,6 +33,7 @@ public:
     int getRedoCount() const { return redoStack->count(); }
 signals:
     void countChange(int undoCount,int redoCount);              // 栈中数量发生改变时发送信号
+    void stackIsEmpty(const QString& message);                  // 撤销或重做时栈为空
 };
 
 #endif // OPERATIONSTACK_H
@@ -0,0 +1,304 @@
+﻿#include "orthogonalrouter.h"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+// 方向：0 向右，1 向左，2 向下，3 向上
+static const int directionCount = 4;
+
+// 排序并去掉重复的坐标
+static void uniqueCoordinates(QVector<double>& values)
+{
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end(), [](double a, double b) { return qFuzzyCompare(a + 1, b + 1); }), values.end());
+}
+
+// 坐标在数组中的下标，数组中必须存在该坐标
+static int coordinateIndex(const QVector<double>& values, double value)
+{
+    int index = int(std::lower_bound(values.begin(), values.end(), value - 1e-6) - values.begin());
+    return qMin(index, values.size() - 1);
+}
+
+OrthogonalRouter::OrthogonalRouter(const Options& options)
+    : options(options), grid(256)
+{}
+
+void OrthogonalRouter::setObstacle(quintptr key, const QRectF& rect)
+{
+    rects.insert(key, rect);
+    grid.insert(key, rect);
+}
+
+void OrthogonalRouter::removeObstacle(quintptr key)
+{
+    rects.remove(key);
+    grid.remove(key);
+}
+
+void OrthogonalRouter::clear()
+{
+    rects.clear();
+    grid.clear();
+}
+
+QList<quintptr> OrthogonalRouter::obstaclesIn(const QRectF& rect) const
+{
+    return grid.query(rect);
+}
+
+QPolygonF OrthogonalRouter::route(const QRectF& source, const QRectF& target, quintptr sourceKey, quintptr targetKey) const
+{
+    QPointF start = source.center();
+    QPointF end = target.center();
+    QPolygonF path;
+    // 两端图形重叠时不需要绕行
+    if (!source.adjusted(-options.margin, -options.margin, options.margin, options.margin).intersects(target))
+    {
+        // 从包含两端图形的区域开始，找不到路径时逐步扩大
+        double pad = options.margin * 2 + qMax(qMax(source.width(), source.height()), qMax(target.width(), target.height()));
+        QRectF region = source.united(target).adjusted(-pad, -pad, pad, pad);
+        for (int attempt = 0; attempt <= options.expansions; ++attempt)
+        {
+            if (search(region, source, target, sourceKey, targetKey, &path))
+            {
+                return clip(path, source, target);
+            }
+            region.adjust(-region.width() / 2, -region.height() / 2, region.width() / 2, region.height() / 2);
+        }
+    }
+    // 退化为先水平后竖直的折线
+    path.clear();
+    path << start << QPointF(end.x(), start.y()) << end;
+    return clip(path, source, target);
+}
+
+bool OrthogonalRouter::search(const QRectF& region, const QRectF& source, const QRectF& target,
+                              quintptr sourceKey, quintptr targetKey, QPolygonF* path) const
+{
+    QPointF start = source.center();
+    QPointF end = target.center();
+
+    // 区域内的障碍物按保留距离扩大，包含端点的障碍物（与两端图形重叠）不参与
+    QVector<QRectF> blocks;
+    QList<quintptr> keys = grid.query(region);
+    for (quintptr key : qAsConst(keys))
+    {
+        if (key == sourceKey || key == targetKey)
+        {
+            continue;
+        }
+        QRectF rect = rects.value(key).adjusted(-options.margin, -options.margin, options.margin, options.margin);
+        if (rect.contains(start) || rect.contains(end))
+        {
+            continue;
+        }
+        blocks.append(rect);
+    }
+
+    // 可见性网格：区域边界、两端中心和每个障碍物的四条边所在的直线
+    QVector<double> xs;
+    QVector<double> ys;
+    xs.reserve(blocks.size() * 2 + 4);
+    ys.reserve(blocks.size() * 2 + 4);
+    xs << region.left() << region.right() << start.x() << end.x();
+    ys << region.top() << region.bottom() << start.y() << end.y();
+    for (const QRectF& rect : qAsConst(blocks))
+    {
+        xs << qBound(region.left(), rect.left(), region.right()) << qBound(region.left(), rect.right(), region.right());
+        ys << qBound(region.top(), rect.top(), region.bottom()) << qBound(region.top(), rect.bottom(), region.bottom());
+    }
+    uniqueCoordinates(xs);
+    uniqueCoordinates(ys);
+    int columns = xs.size();
+    int rows = ys.size();
+    if (qint64(columns) * rows > options.maxGridPoints)
+    {
+        return false;
+    }
+
+    // 标记落在障碍物内部的顶点和线段，障碍物边上的可以通行
+    int pointCount = columns * rows;
+    QVector<bool> pointBlocked(pointCount, false);
+    QVector<bool> horizontalBlocked(pointCount, false);                 // 顶点 (i, j) 到 (i + 1, j)
+    QVector<bool> verticalBlocked(pointCount, false);                   // 顶点 (i, j) 到 (i, j + 1)
+    for (const QRectF& rect : qAsConst(blocks))
+    {
+        int left = coordinateIndex(xs, qMax(rect.left(), region.left()));
+        int right = coordinateIndex(xs, qMin(rect.right(), region.right()));
+        int top = coordinateIndex(ys, qMax(rect.top(), region.top()));
+        int bottom = coordinateIndex(ys, qMin(rect.bottom(), region.bottom()));
+        for (int j = top; j <= bottom; ++j)
+        {
+            bool rowInside = ys.at(j) > rect.top() && ys.at(j) < rect.bottom();
+            for (int i = left; i <= right; ++i)
+            {
+                bool columnInside = xs.at(i) > rect.left() && xs.at(i) < rect.right();
+                int point = j * columns + i;
+                if (rowInside && columnInside)
+                {
+                    pointBlocked[point] = true;
+                }
+                if (rowInside && i < right)
+                {
+                    horizontalBlocked[point] = true;
+                }
+                if (columnInside && j < bottom)
+                {
+                    verticalBlocked[point] = true;
+                }
+            }
+        }
+    }
+
+    // A*：状态为（顶点，进入方向），代价为长度加拐弯惩罚，曼哈顿距离作为启发值
+    int startPoint = coordinateIndex(ys, start.y()) * columns + coordinateIndex(xs, start.x());
+    int endPoint = coordinateIndex(ys, end.y()) * columns + coordinateIndex(xs, end.x());
+    const double infinity = std::numeric_limits<double>::infinity();
+    QVector<double> cost(pointCount * directionCount, infinity);
+    QVector<int> previous(pointCount * directionCount, -1);
+    typedef QPair<double, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    auto heuristic = [&](int point) {
+        return qAbs(xs.at(point % columns) - end.x()) + qAbs(ys.at(point / columns) - end.y());
+    };
+    for (int direction = 0; direction < directionCount; ++direction)
+    {
+        cost[startPoint * directionCount + direction] = 0;              // 第一段不算拐弯
+        open.push(Entry(heuristic(startPoint), startPoint * directionCount + direction));
+    }
+    int reached = -1;
+    while (!open.empty())
+    {
+        Entry entry = open.top();
+        open.pop();
+        int state = entry.second;
+        int point = state / directionCount;
+        int direction = state % directionCount;
+        double current = cost.at(state);
+        if (entry.first > current + heuristic(point) + 1e-9)
+        {
+            continue;                                                   // 已有更优的路径
+        }
+        if (point == endPoint)
+        {
+            reached = state;
+            break;
+        }
+        int i = point % columns;
+        int j = point / columns;
+        for (int next = 0; next < directionCount; ++next)
+        {
+            if ((next ^ 1) == direction && current > 0)
+            {
+                continue;                                               // 不折返
+            }
+            int neighbour;
+            if (next == 0)
+            {
+                if (i + 1 >= columns || horizontalBlocked.at(point)) continue;
+                neighbour = point + 1;
+            }
+            else if (next == 1)
+            {
+                if (i == 0 || horizontalBlocked.at(point - 1)) continue;
+                neighbour = point - 1;
+            }
+            else if (next == 2)
+            {
+                if (j + 1 >= rows || verticalBlocked.at(point)) continue;
+                neighbour = point + columns;
+            }
+            else
+            {
+                if (j == 0 || verticalBlocked.at(point - columns)) continue;
+                neighbour = point - columns;
+            }
+            if (pointBlocked.at(neighbour))
+            {
+                continue;
+            }
+            double length = qAbs(xs.at(neighbour % columns) - xs.at(i)) + qAbs(ys.at(neighbour / columns) - ys.at(j));
+            double value = current + length + (next != direction && current > 0 ? options.bendPenalty : 0);
+            int nextState = neighbour * directionCount + next;
+            if (value < cost.at(nextState))
+            {
+                cost[nextState] = value;
+                previous[nextState] = state;
+                open.push(Entry(value + heuristic(neighbour), nextState));
+            }
+        }
+    }
+    if (reached < 0)
+    {
+        return false;
+    }
+
+    // 回溯路径，只保留拐点
+    QVector<int> points;
+    for (int state = reached; state >= 0; state = previous.at(state))
+    {
+        points.append(state / directionCount);
+    }
+    std::reverse(points.begin(), points.end());
+    path->clear();
+    for (int k = 0; k < points.size(); ++k)
+    {
+        QPointF point(xs.at(points.at(k) % columns), ys.at(points.at(k) / columns));
+        if (path->size() >= 2)
+        {
+            QPointF a = path->at(path->size() - 2);
+            QPointF b = path->last();
+            if ((a.x() == b.x() && b.x() == point.x()) || (a.y() == b.y() && b.y() == point.y()))
+            {
+                path->last() = point;                                   // 与上一段共线
+                continue;
+            }
+        }
+        if (path->isEmpty() || path->last() != point)
+        {
+            path->append(point);
+        }
+    }
+    path->first() = start;
+    path->last() = end;
+    return path->size() >= 2;
+}
+
+QPolygonF OrthogonalRouter::clip(const QPolygonF& path, const QRectF& source, const QRectF& target)
+{
+    if (path.size() < 2)
+    {
+        return path;
+    }
+    // 找到离开起点图形的线段和进入终点图形的线段
+    int first = 0;
+    while (first + 1 < path.size() - 1 && source.contains(path.at(first + 1)))
+    {
+        ++first;
+    }
+    int last = path.size() - 1;
+    while (last - 1 > first && target.contains(path.at(last - 1)))
+    {
+        --last;
+    }
+    QPolygonF result = path.mid(first, last - first + 1);
+    auto boundary = [](QPointF inside, QPointF outside, const QRectF& rect) {
+        if (inside.y() == outside.y())
+        {
+            return QPointF(outside.x() > inside.x() ? rect.right() : rect.left(), inside.y());
+        }
+        return QPointF(inside.x(), outside.y() > inside.y() ? rect.bottom() : rect.top());
+    };
+    if (source.contains(result.at(0)) && !source.contains(result.at(1)))
+    {
+        result[0] = boundary(result.at(0), result.at(1), source);
+    }
+    int end = result.size() - 1;
+    if (target.contains(result.at(end)) && !target.contains(result.at(end - 1)))
+    {
+        result[end] = boundary(result.at(end), result.at(end - 1), target);
+    }
+    return result;
+}
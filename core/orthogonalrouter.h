@@ -0,0 +1,50 @@
+﻿#ifndef ORTHOGONALROUTER_H
+#define ORTHOGONALROUTER_H
+
+#include <QHash>
+#include <QPolygonF>
+#include <QRectF>
+
+#include "spatialgrid.h"
+
+// 正交连线路由：在起点与终点附近的障碍物（图形外接矩形）上建立稀疏可见性网格，
+// 用 A* 搜索长度加拐弯惩罚最小的折线
+// 障碍物登记在网格索引中，每次只取出搜索区域内的少量障碍物，与图形总数无关
+// 复制的开销很小（隐式共享），复制一份快照后可以在工作线程中布线
+class OrthogonalRouter
+{
+public:
+    struct Options
+    {
+        double margin = 12;                                         // 连线与障碍物之间保留的距离
+        double bendPenalty = 40;                                    // 每次拐弯折算的长度
+        int expansions = 3;                                         // 找不到路径时扩大搜索区域的次数
+        int maxGridPoints = 1 << 18;                                // 可见性网格的最大顶点数，超过时放弃搜索
+    };
+
+    explicit OrthogonalRouter(const Options& options = Options());
+
+    void setObstacle(quintptr key, const QRectF& rect);             // 登记或更新障碍物
+    void removeObstacle(quintptr key);
+    void clear();
+    int obstacleCount() const { return rects.size(); }
+    bool hasObstacle(quintptr key) const { return rects.contains(key); }
+    QRectF obstacle(quintptr key) const { return rects.value(key); }    // 障碍物的外接矩形，不存在时为空
+    double getMargin() const { return options.margin; }
+    QList<quintptr> obstaclesIn(const QRectF& rect) const;          // 与区域相交的障碍物
+
+    // 从 source 中心到 target 中心布线，两端图形本身不算障碍物；
+    // 返回的折线从 source 的边框开始，到 target 的边框结束，只有水平和竖直线段
+    QPolygonF route(const QRectF& source, const QRectF& target, quintptr sourceKey = 0, quintptr targetKey = 0) const;
+
+private:
+    Options options;
+    SpatialGrid<quintptr> grid;                                     // 障碍物的空间索引
+    QHash<quintptr, QRectF> rects;                                  // 障碍物的外接矩形
+
+    bool search(const QRectF& region, const QRectF& source, const QRectF& target,
+                quintptr sourceKey, quintptr targetKey, QPolygonF* path) const; // 在区域内搜索，失败时返回false
+    static QPolygonF clip(const QPolygonF& path, const QRectF& source, const QRectF& target); // 去掉两端图形内部的部分
+};
+
+#endif // ORTHOGONALROUTER_H
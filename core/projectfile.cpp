@@ -0,0 +1,273 @@
+﻿#include "projectfile.h"
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+
+static const char projectMagic[8] = { 'F', 'L', 'O', 'W', 'P', 'R', 'O', 'J' };
+
+static void setError(QString* errorString, const QString& message)
+{
+    if (errorString != nullptr)
+    {
+        *errorString = message;
+    }
+}
+
+bool ProjectFile::open(const QString& path, QString* errorString)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        setError(errorString, file.errorString());
+        return false;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    char magic[8];
+    quint32 fileVersion = 0;
+    quint64 tocOffset = 0;
+    if (stream.readRawData(magic, 8) != 8 || memcmp(magic, projectMagic, 8) != 0)
+    {
+        setError(errorString, QStringLiteral("不是项目文件"));
+        return false;
+    }
+    stream >> fileVersion >> tocOffset;
+    if (fileVersion != version || tocOffset < quint64(headerSize) || tocOffset >= quint64(file.size()) || !file.seek(qint64(tocOffset)))
+    {
+        setError(errorString, QStringLiteral("项目文件的目录无效"));
+        return false;
+    }
+    quint32 count = 0;
+    stream >> count;
+    QVector<Page> pages;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i)
+    {
+        Page page;
+        quint64 offset;
+        quint64 length;
+        stream >> page.guid >> page.name >> offset >> length;
+        page.offset = qint64(offset);
+        page.length = qint64(length);
+        if (page.offset < headerSize || page.offset + page.length > qint64(tocOffset))
+        {
+            setError(errorString, QStringLiteral("项目文件的目录无效"));
+            return false;
+        }
+        pages.append(page);
+    }
+    if (stream.status() != QDataStream::Ok)
+    {
+        setError(errorString, QStringLiteral("项目文件的目录不完整"));
+        return false;
+    }
+    this->path = path;
+    toc = pages;
+    return true;
+}
+
+int ProjectFile::indexOf(const QString& guid) const
+{
+    for (int i = 0; i < toc.size(); ++i)
+    {
+        if (toc.at(i).guid == guid)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool ProjectFile::readPage(const QString& guid, DiagramModel* model, QString* errorString) const
+{
+    int index = indexOf(guid);
+    if (index < 0)
+    {
+        setError(errorString, QStringLiteral("项目中没有该页面"));
+        return false;
+    }
+    QByteArray data = readBytes(toc.at(index), errorString);
+    if (data.isNull())
+    {
+        return false;
+    }
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    return model->readXml(&buffer, errorString);
+}
+
+QByteArray ProjectFile::readBytes(const Page& page, QString* errorString) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(page.offset))
+    {
+        setError(errorString, file.errorString());
+        return QByteArray();
+    }
+    QByteArray data = file.read(page.length);
+    if (data.size() != page.length)
+    {
+        setError(errorString, QStringLiteral("项目文件被截断"));
+        return QByteArray();
+    }
+    return data;
+}
+
+bool ProjectFile::save(const QString& path, const QVector<SavedPage>& pages, QString* errorString)
+{
+    // 未修改的页面必须在当前目录中
+    qint64 liveBytes = 0;
+    for (const SavedPage& page : pages)
+    {
+        if (!page.dirty)
+        {
+            int index = indexOf(page.guid);
+            if (index < 0)
+            {
+                setError(errorString, QStringLiteral("未修改的页面不在项目中"));
+                return false;
+            }
+            liveBytes += toc.at(index).length;
+        }
+    }
+    QVector<QByteArray> dirtyBytes(pages.size());
+    for (int i = 0; i < pages.size(); ++i)
+    {
+        if (pages.at(i).dirty)
+        {
+            dirtyBytes[i] = pageBytes(pages.at(i));
+            liveBytes += dirtyBytes.at(i).size();
+        }
+    }
+
+    QVector<Page> newToc(pages.size());
+    bool sameFile = path == this->path && QFile::exists(path);
+    if (sameFile && QFileInfo(path).size() - liveBytes <= liveBytes)
+    {
+        // 追加修改过的页面和目录，最后改写文件头
+        QFile file(path);
+        if (!file.open(QIODevice::ReadWrite))
+        {
+            setError(errorString, file.errorString());
+            return false;
+        }
+        qint64 position = file.size();
+        file.seek(position);
+        for (int i = 0; i < pages.size(); ++i)
+        {
+            newToc[i].guid = pages.at(i).guid;
+            newToc[i].name = pages.at(i).name;
+            if (pages.at(i).dirty)
+            {
+                newToc[i].offset = position;
+                newToc[i].length = dirtyBytes.at(i).size();
+                if (file.write(dirtyBytes.at(i)) != dirtyBytes.at(i).size())
+                {
+                    setError(errorString, file.errorString());
+                    return false;
+                }
+                position += newToc[i].length;
+            }
+            else
+            {
+                const Page& old = toc.at(indexOf(pages.at(i).guid));
+                newToc[i].offset = old.offset;
+                newToc[i].length = old.length;
+            }
+        }
+        QByteArray tocData = tocBytes(newToc);
+        if (file.write(tocData) != tocData.size() || !file.flush())
+        {
+            setError(errorString, file.errorString());
+            return false;
+        }
+        QByteArray head = header(position);
+        if (!file.seek(0) || file.write(head) != head.size() || !file.flush())
+        {
+            setError(errorString, file.errorString());
+            return false;
+        }
+    }
+    else
+    {
+        // 新文件或旧数据过多：整体写到临时文件，完成后替换
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+        {
+            setError(errorString, file.errorString());
+            return false;
+        }
+        qint64 position = headerSize;
+        file.write(header(0));
+        for (int i = 0; i < pages.size(); ++i)
+        {
+            QByteArray data = pages.at(i).dirty ? dirtyBytes.at(i) : readBytes(toc.at(indexOf(pages.at(i).guid)), errorString);
+            if (!pages.at(i).dirty && data.isNull())
+            {
+                file.cancelWriting();
+                return false;
+            }
+            newToc[i].guid = pages.at(i).guid;
+            newToc[i].name = pages.at(i).name;
+            newToc[i].offset = position;
+            newToc[i].length = data.size();
+            file.write(data);
+            position += data.size();
+        }
+        file.write(tocBytes(newToc));
+        file.seek(0);
+        file.write(header(position));
+        if (!file.commit())
+        {
+            setError(errorString, file.errorString());
+            return false;
+        }
+    }
+    this->path = path;
+    toc = newToc;
+    return true;
+}
+
+bool ProjectFile::isProjectFile(const QString& path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) && file.read(8) == QByteArray(projectMagic, 8);
+}
+
+QByteArray ProjectFile::pageBytes(const SavedPage& page)
+{
+    DiagramModel model = page.model;
+    model.guid = page.guid;
+    model.tabName = page.name;
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    model.writeXml(&buffer);
+    return data;
+}
+
+QByteArray ProjectFile::tocBytes(const QVector<Page>& pages)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << quint32(pages.size());
+    for (const Page& page : pages)
+    {
+        stream << page.guid << page.name << quint64(page.offset) << quint64(page.length);
+    }
+    return data;
+}
+
+QByteArray ProjectFile::header(qint64 tocOffset)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream.writeRawData(projectMagic, 8);
+    stream << version << quint64(tocOffset);
+    return data;
+}
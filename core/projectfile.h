@@ -0,0 +1,54 @@
+﻿#ifndef PROJECTFILE_H
+#define PROJECTFILE_H
+
+#include <QString>
+#include <QVector>
+
+#include "diagrammodel.h"
+
+// 项目文件：多个页面保存在一个文件中，每页是一份完整的流程图XML
+// 文件头记录目录的位置，目录在文件末尾，列出每页的 guid、名称、偏移和长度；
+// 打开时只读取目录，每页在需要时单独定位和解析
+// 保存到同一文件时只追加修改过的页面和新的目录，最后改写文件头，中途失败时旧目录仍然有效；
+// 失效的旧数据超过有效数据时整体重写一次
+class ProjectFile
+{
+public:
+    struct Page
+    {
+        QString guid;                                                   // 页面的唯一识别id
+        QString name;                                                   // 页面名称
+        qint64 offset;                                                  // 页面XML在文件中的位置
+        qint64 length;                                                  // 页面XML的字节数
+    };
+
+    struct SavedPage
+    {
+        QString guid;
+        QString name;
+        bool dirty;                                                     // 为false时沿用文件中已有的内容
+        DiagramModel model;                                             // dirty 时写入的内容
+    };
+
+    bool open(const QString& path, QString* errorString = nullptr);     // 只读取目录
+    QString fileName() const { return path; }
+    const QVector<Page>& pages() const { return toc; }
+    int indexOf(const QString& guid) const;
+    bool readPage(const QString& guid, DiagramModel* model, QString* errorString = nullptr) const; // 读取并解析一页
+    bool save(const QString& path, const QVector<SavedPage>& pages, QString* errorString = nullptr); // 按 pages 的顺序保存
+    static bool isProjectFile(const QString& path);                     // 按文件头判断
+
+private:
+    static const int headerSize = 20;                                   // 标识8字节、版本4字节、目录位置8字节
+    static const quint32 version = 1;
+
+    QString path;                                                       // 已打开或最近保存的文件
+    QVector<Page> toc;                                                  // 目录
+
+    QByteArray readBytes(const Page& page, QString* errorString) const; // 读取一页的原始内容
+    static QByteArray pageBytes(const SavedPage& page);                 // 将页面写成XML
+    static QByteArray tocBytes(const QVector<Page>& pages);
+    static QByteArray header(qint64 tocOffset);
+};
+
+#endif // PROJECTFILE_H
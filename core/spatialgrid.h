@@ -0,0 +1,243 @@
+#ifndef SPATIALGRID_H
+#define SPATIALGRID_H
+
+#include <QHash>
+#include <QList>
+#include <QRect>
+#include <QRectF>
+#include <QVector>
+#include <QtMath>
+
+// 均匀网格空间索引：按固定大小的单元格登记对象的外接矩形
+// 流程图中的图形尺寸相近且频繁移动，网格的插入和更新只涉及少量单元格，不需要重建或平衡
+template <typename T>
+class SpatialGrid
+{
+public:
+    explicit SpatialGrid(qreal cellSize = 256) : cellSize(cellSize) {}
+
+    // 登记对象，已登记的对象只更新位置，登记顺序保持不变
+    void insert(const T& value, const QRectF& rect)
+    {
+        QRect range = cellRange(rect);
+        typename QHash<T, Entry>::iterator it = entries.find(value);
+        if (it != entries.end())
+        {
+            it->rect = rect;
+            if (it->range == range)
+            {
+                return;     // 仍在原来的单元格中
+            }
+            unlink(value, it->range);
+            it->range = range;
+        }
+        else
+        {
+            entries.insert(value, Entry{ rect, range, nextSequence++ });
+        }
+        link(value, range);
+    }
+
+    // 移除对象
+    void remove(const T& value)
+    {
+        typename QHash<T, Entry>::iterator it = entries.find(value);
+        if (it == entries.end())
+        {
+            return;
+        }
+        unlink(value, it->range);
+        entries.erase(it);
+    }
+
+    bool contains(const T& value) const
+    {
+        return entries.contains(value);
+    }
+
+    // 对象的登记序号，后登记的更大，未登记时为0
+    quint64 sequence(const T& value) const
+    {
+        typename QHash<T, Entry>::const_iterator it = entries.constFind(value);
+        return it == entries.constEnd() ? 0 : it->sequence;
+    }
+
+    // 返回外接矩形与 rect 相交的对象
+    QList<T> query(const QRectF& rect) const
+    {
+        QList<T> result;
+        QRect range = cellRange(rect);
+        // 查询范围比已占用的单元格还多时直接遍历所有对象
+        if (qint64(range.width()) * range.height() > buckets.size())
+        {
+            for (typename QHash<T, Entry>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it)
+            {
+                if (overlaps(it->rect, rect))
+                {
+                    result.append(it.key());
+                }
+            }
+            return result;
+        }
+        for (int y = range.top(); y <= range.bottom(); ++y)
+        {
+            for (int x = range.left(); x <= range.right(); ++x)
+            {
+                typename QHash<quint64, QVector<T>>::const_iterator bucket = buckets.constFind(cellKey(x, y));
+                if (bucket == buckets.constEnd())
+                {
+                    continue;
+                }
+                for (const T& value : *bucket)
+                {
+                    const Entry& entry = entries[value];
+                    // 跨越多个单元格的对象只在与查询范围重叠的左上角单元格中返回一次
+                    if (qMax(entry.range.left(), range.left()) != x || qMax(entry.range.top(), range.top()) != y)
+                    {
+                        continue;
+                    }
+                    if (overlaps(entry.rect, rect))
+                    {
+                        result.append(value);
+                    }
+                }
+            }
+        }
+        for (const T& value : oversized)
+        {
+            const Entry& entry = entries[value];
+            if (overlaps(entry.rect, rect))
+            {
+                result.append(value);
+            }
+        }
+        return result;
+    }
+
+    // 返回外接矩形包含 point 的对象
+    QList<T> query(const QPointF& point) const
+    {
+        QList<T> result;
+        typename QHash<quint64, QVector<T>>::const_iterator bucket = buckets.constFind(cellKey(qFloor(point.x() / cellSize), qFloor(point.y() / cellSize)));
+        if (bucket != buckets.constEnd())
+        {
+            for (const T& value : *bucket)
+            {
+                if (overlaps(entries[value].rect, QRectF(point, QSizeF(0, 0))))
+                {
+                    result.append(value);
+                }
+            }
+        }
+        for (const T& value : oversized)
+        {
+            if (overlaps(entries[value].rect, QRectF(point, QSizeF(0, 0))))
+            {
+                result.append(value);
+            }
+        }
+        return result;
+    }
+
+    void clear()
+    {
+        entries.clear();
+        buckets.clear();
+        oversized.clear();
+        nextSequence = 1;
+    }
+
+    int count() const
+    {
+        return entries.size();
+    }
+
+    qreal getCellSize() const
+    {
+        return cellSize;
+    }
+
+private:
+    struct Entry
+    {
+        QRectF rect;                                    // 外接矩形
+        QRect range;                                    // 占用的单元格范围
+        quint64 sequence;                               // 登记序号
+    };
+
+    static const int maxCellsPerValue = 256;            // 超过该数量的对象放入 oversized，避免登记过多单元格
+
+    qreal cellSize;                                     // 单元格边长
+    QHash<T, Entry> entries;                            // 所有登记的对象
+    QHash<quint64, QVector<T>> buckets;                 // 单元格中的对象
+    QVector<T> oversized;                               // 过大的对象，每次查询都检查
+    quint64 nextSequence = 1;                           // 下一个登记序号
+
+    // 闭区间相交判断，宽或高为0的矩形（如水平、竖直的线）也能命中
+    static bool overlaps(const QRectF& a, const QRectF& b)
+    {
+        QRectF r1 = a.normalized();
+        QRectF r2 = b.normalized();
+        return r1.left() <= r2.right() && r2.left() <= r1.right() && r1.top() <= r2.bottom() && r2.top() <= r1.bottom();
+    }
+
+    static quint64 cellKey(int x, int y)
+    {
+        return (quint64(quint32(x)) << 32) | quint32(y);
+    }
+
+    QRect cellRange(const QRectF& rect) const
+    {
+        QRectF normalized = rect.normalized();
+        return QRect(QPoint(qFloor(normalized.left() / cellSize), qFloor(normalized.top() / cellSize)),
+                     QPoint(qFloor(normalized.right() / cellSize), qFloor(normalized.bottom() / cellSize)));
+    }
+
+    bool isOversized(const QRect& range) const
+    {
+        return qint64(range.width()) * range.height() > maxCellsPerValue;
+    }
+
+    void link(const T& value, const QRect& range)
+    {
+        if (isOversized(range))
+        {
+            oversized.append(value);
+            return;
+        }
+        for (int y = range.top(); y <= range.bottom(); ++y)
+        {
+            for (int x = range.left(); x <= range.right(); ++x)
+            {
+                buckets[cellKey(x, y)].append(value);
+            }
+        }
+    }
+
+    void unlink(const T& value, const QRect& range)
+    {
+        if (isOversized(range))
+        {
+            oversized.removeOne(value);
+            return;
+        }
+        for (int y = range.top(); y <= range.bottom(); ++y)
+        {
+            for (int x = range.left(); x <= range.right(); ++x)
+            {
+                typename QHash<quint64, QVector<T>>::iterator bucket = buckets.find(cellKey(x, y));
+                if (bucket == buckets.end())
+                {
+                    continue;
+                }
+                bucket->removeOne(value);
+                if (bucket->isEmpty())
+                {
+                    buckets.erase(bucket);
+                }
+            }
+        }
+    }
+};
+
+#endif // SPATIALGRID_H
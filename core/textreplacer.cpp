@@ -0,0 +1,148 @@
+﻿#include "textreplacer.h"
+
+#include <QCoreApplication>
+#include <QMetaType>
+#include <QRegularExpression>
+#include <QRunnable>
+
+// 计算一块文本的替换结果，文本按值捕获，不访问所属对象的数据
+class TextReplacer::Job : public QRunnable
+{
+public:
+    Job(TextReplacer* owner, const QVector<QString>& texts, int chunk, const QString& query,
+        LabelIndex::MatchMode mode, const QString& replacement, Qt::CaseSensitivity sensitivity, int generation)
+        : owner(owner), texts(texts), chunk(chunk), query(query), mode(mode), replacement(replacement),
+          sensitivity(sensitivity), generation(generation) {}
+
+    void run() override
+    {
+        QVector<int> changed;
+        QVector<QString> newTexts;
+        for (int i = 0; i < texts.size(); ++i)
+        {
+            QString text = TextReplacer::replace(texts.at(i), query, mode, replacement, sensitivity);
+            if (text != texts.at(i))
+            {
+                changed.append(i);
+                newTexts.append(text);
+            }
+        }
+        // owner 析构时会等待任务结束，此处一定有效
+        QMetaObject::invokeMethod(owner, "deliver", Qt::QueuedConnection, Q_ARG(int, generation), Q_ARG(int, chunk),
+                                  Q_ARG(QVector<int>, changed), Q_ARG(QVector<QString>, newTexts));
+    }
+
+private:
+    TextReplacer* owner;
+    QVector<QString> texts;
+    int chunk;
+    QString query;
+    LabelIndex::MatchMode mode;
+    QString replacement;
+    Qt::CaseSensitivity sensitivity;
+    int generation;
+};
+
+TextReplacer::TextReplacer(QObject* parent)
+    : QObject(parent), remaining(0), generation(0)
+{
+    qRegisterMetaType<QVector<int>>("QVector<int>");
+    qRegisterMetaType<QVector<QString>>("QVector<QString>");
+    qRegisterMetaType<QVector<quintptr>>("QVector<quintptr>");
+}
+
+TextReplacer::~TextReplacer()
+{
+    pool.clear();
+    pool.waitForDone();
+}
+
+void TextReplacer::start(const QVector<quintptr>& keys, const QVector<QString>& texts, const QString& query,
+                         LabelIndex::MatchMode mode, const QString& replacement, Qt::CaseSensitivity sensitivity)
+{
+    cancel();
+    this->keys = keys;
+    this->texts = texts;
+    int chunks = (texts.size() + chunkSize - 1) / chunkSize;
+    chunkChanged = QVector<QVector<int>>(chunks);
+    chunkTexts = QVector<QVector<QString>>(chunks);
+    remaining = chunks;
+    if (chunks == 0)
+    {
+        emit finished(QVector<quintptr>(), QVector<QString>(), QVector<QString>());
+        return;
+    }
+    for (int chunk = 0; chunk < chunks; ++chunk)
+    {
+        pool.start(new Job(this, texts.mid(chunk * chunkSize, chunkSize), chunk, query, mode, replacement, sensitivity, generation));
+    }
+}
+
+void TextReplacer::cancel()
+{
+    ++generation;                                                       // 已排队的结果到达时被丢弃
+    pool.clear();
+    remaining = 0;
+}
+
+void TextReplacer::waitForDone()
+{
+    pool.waitForDone();
+    QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);         // 交回已完成的结果
+}
+
+void TextReplacer::deliver(int generation, int chunk, const QVector<int>& changed, const QVector<QString>& newTexts)
+{
+    if (generation != this->generation || remaining == 0)
+    {
+        return;
+    }
+    chunkChanged[chunk] = changed;
+    chunkTexts[chunk] = newTexts;
+    if (--remaining > 0)
+    {
+        return;
+    }
+    // 按原顺序合并各块
+    QVector<quintptr> changedKeys;
+    QVector<QString> oldTexts;
+    QVector<QString> replaced;
+    for (int c = 0; c < chunkChanged.size(); ++c)
+    {
+        for (int i = 0; i < chunkChanged.at(c).size(); ++i)
+        {
+            int index = c * chunkSize + chunkChanged.at(c).at(i);
+            changedKeys.append(keys.at(index));
+            oldTexts.append(texts.at(index));
+            replaced.append(chunkTexts.at(c).at(i));
+        }
+    }
+    keys.clear();
+    texts.clear();
+    chunkChanged.clear();
+    chunkTexts.clear();
+    emit finished(changedKeys, oldTexts, replaced);
+}
+
+QString TextReplacer::replace(const QString& text, const QString& query, LabelIndex::MatchMode mode,
+                              const QString& replacement, Qt::CaseSensitivity sensitivity)
+{
+    // 正则表达式不先判断是否匹配，避免编译两次
+    if (query.isEmpty() || (mode != LabelIndex::Regex && !LabelIndex::matches(text, query, mode, sensitivity)))
+    {
+        return text;
+    }
+    switch (mode)
+    {
+        case LabelIndex::Exact:
+            return replacement;
+        case LabelIndex::Prefix:
+            return replacement + text.mid(query.size());
+        case LabelIndex::Substring:
+            return QString(text).replace(query, replacement, sensitivity);
+        case LabelIndex::Regex:
+            return QString(text).replace(QRegularExpression(query, sensitivity == Qt::CaseInsensitive ? QRegularExpression::CaseInsensitiveOption
+                                                                                                      : QRegularExpression::NoPatternOption), replacement);
+    }
+    return text;
+}
@@ -0,0 +1,50 @@
+﻿#ifndef TEXTREPLACER_H
+#define TEXTREPLACER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+
+#include "labelindex.h"
+
+// 批量替换：在线程池中按块计算替换后的文本，全部完成后通过 finished 一次性交回所属线程
+// 只交回内容确实变化的文本，由调用者作为一次操作应用，重新布局也只在应用后进行一次
+class TextReplacer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TextReplacer(QObject* parent = nullptr);
+    ~TextReplacer() override;                                           // 等待后台计算结束
+
+    // 开始替换 texts 中匹配 query 的部分，keys 与 texts 同下标；之前未完成的替换被丢弃
+    void start(const QVector<quintptr>& keys, const QVector<QString>& texts, const QString& query,
+               LabelIndex::MatchMode mode, const QString& replacement, Qt::CaseSensitivity sensitivity = Qt::CaseInsensitive);
+    void cancel();                                                      // 丢弃正在进行的替换
+    bool isRunning() const { return remaining > 0; }
+    void waitForDone();                                                 // 等待后台计算并交回结果，用于测试
+
+    // 精确和前缀匹配替换匹配的部分，包含匹配替换所有出现，正则匹配支持 \1 形式的反向引用
+    static QString replace(const QString& text, const QString& query, LabelIndex::MatchMode mode,
+                           const QString& replacement, Qt::CaseSensitivity sensitivity = Qt::CaseInsensitive);
+
+signals:
+    void finished(const QVector<quintptr>& keys, const QVector<QString>& oldTexts, const QVector<QString>& newTexts);
+
+private slots:
+    void deliver(int generation, int chunk, const QVector<int>& changed, const QVector<QString>& newTexts); // 接收一块的结果
+
+private:
+    class Job;
+
+    static const int chunkSize = 4096;                                  // 每个任务处理的文本数
+
+    QVector<quintptr> keys;
+    QVector<QString> texts;
+    QVector<QVector<int>> chunkChanged;                                 // 每块中变化的下标
+    QVector<QVector<QString>> chunkTexts;                               // 每块中变化后的文本
+    int remaining;                                                      // 尚未完成的块数
+    int generation;                                                     // 批次编号，旧批次的结果被丢弃
+    QThreadPool pool;
+};
+
+#endif // TEXTREPLACER_H
@@ -0,0 +1,39 @@
+# 场景、视图和图形项的源码，应用、测试和基准测试共用；数据模型和撤销栈在核心库中
+QT       += core gui widgets
+QT       += svg
+QT       += xml
+
+CONFIG += c++11
+DEFINES += QT_DEPRECATED_WARNINGS
+INCLUDEPATH += $$PWD
+
+include($$PWD/core/core.pri)
+
+SOURCES += \
+    $$PWD/operation.cpp \
+    $$PWD/view.cpp \
+    $$PWD/scene.cpp \
+    $$PWD/pixmapitem.cpp \
+    $$PWD/chartitem.cpp \
+    $$PWD/lineitem.cpp \
+    $$PWD/textitem.cpp \
+    $$PWD/controlpoint.cpp \
+    $$PWD/profiler.cpp \
+    $$PWD/startuptrace.cpp \
+    $$PWD/tabcache.cpp
+
+HEADERS += \
+    $$PWD/operation.h \
+    $$PWD/view.h \
+    $$PWD/scene.h \
+    $$PWD/pixmapitem.h \
+    $$PWD/chartitem.h \
+    $$PWD/lineitem.h \
+    $$PWD/textitem.h \
+    $$PWD/controlpoint.h \
+    $$PWD/profiler.h \
+    $$PWD/startuptrace.h \
+    $$PWD/tabcache.h
+
+RESOURCES += \
+    $$PWD/sources.qrc
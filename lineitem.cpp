@@ -1,6 +1,9 @@
 ﻿#include "lineitem.h"
+#include "scene.h"
+#include "profiler.h"
 
 #include <QDebug>
+#include <QPainterPath>
 
 LineItem::LineItem(ChartItem* startItem, ChartItem* endItem, QGraphicsItem* parent)
     : QGraphicsLineItem(parent), startItem(startItem), endItem(endItem)
@@ -11,11 +14,15 @@ LineItem::LineItem(ChartItem* startItem, ChartItem* endItem, QGraphicsItem* pare
     Uid = QUuid::createUuid().toString(QUuid::WithoutBraces);                               // 生成唯一ID
     color = Qt::black;                                                                      // 设置颜色
     setPen(QPen(color, 2));                                                                 // 设置画笔
-    connect(startItem, &ChartItem::itemPositionHasChanged, this, [&](){ this->update(); }); // 更新图形项
-    connect(endItem, &ChartItem::itemPositionHasChanged, this, [&](){ this->update(); });   // 更新图形项
+    connect(startItem, &ChartItem::itemPositionHasChanged, this, &LineItem::updatePosition); // 更新线段
+    connect(endItem, &ChartItem::itemPositionHasChanged, this, &LineItem::updatePosition);   // 更新线段
     setZValue(99);                                                                          // 设置Z值
-    QLineF line(mapFromItem(startItem, 0, 0), mapFromItem(endItem, 0, 0));                  // 计算初始线段
-    setLine(line);                                                                          // 设置线段
+    updatePosition();                                                                       // 计算初始线段
+}
+
+LineItem::~LineItem()
+{
+    Scene::removeItemIndex(this);                                                           // 析构时不会收到场景变更事件
 }
 
 int LineItem::type() const
@@ -54,58 +61,173 @@ QPointF LineItem::getBoundedIntersection(ChartItem* chartItem, QLineF centerline
     }
 }
 
+QPolygonF LineItem::getPath() const
+{
+    return path;
+}
+
+QPointF LineItem::pathCenter() const
+{
+    if (path.size() <= 2)
+    {
+        return line().center();
+    }
+    qreal half = 0;
+    for (int i = 1; i < path.size(); ++i)
+    {
+        half += QLineF(path.at(i - 1), path.at(i)).length();
+    }
+    half /= 2;
+    for (int i = 1; i < path.size(); ++i)
+    {
+        QLineF segment(path.at(i - 1), path.at(i));
+        if (half <= segment.length())
+        {
+            return segment.pointAt(segment.length() > 0 ? half / segment.length() : 0);
+        }
+        half -= segment.length();
+    }
+    return path.last();
+}
+
+void LineItem::setBundled(bool bundled)
+{
+    if (this->bundled != bundled)
+    {
+        this->bundled = bundled;
+        update();
+    }
+}
+
 QRectF LineItem::boundingRect() const
 {
-    return shape().boundingRect();
+    return fullShape().boundingRect();
 }
 
 QPainterPath LineItem::shape() const
 {
-    QPainterPath path = QGraphicsLineItem::shape(); // 获取基类形状
-    path.addPolygon(arrowHead);                     // 添加箭头形状
-    return path;
+    if (bundled && !isSelected())
+    {
+        return QPainterPath();                      // 未绘制的线不能被点中
+    }
+    return fullShape();
+}
+
+QPainterPath LineItem::fullShape() const
+{
+    QPainterPath shapePath;
+    if (path.size() > 2)
+    {
+        // 折线按画笔宽度描边
+        QPainterPath polyline;
+        polyline.addPolygon(path);
+        QPainterPathStroker stroker;
+        stroker.setWidth(pen().widthF());
+        shapePath = stroker.createStroke(polyline);
+    }
+    else
+    {
+        shapePath = QGraphicsLineItem::shape();     // 获取基类形状
+    }
+    shapePath.addPolygon(arrowHead);                // 添加箭头形状
+    return shapePath;
 }
 
 void LineItem::paint(QPainter *painter, const QStyleOptionGraphicsItem*, QWidget*)
 {
-    if (startItem->collidesWithItem(endItem))
+    PROFILE_PAINT(LinePaint);
+    if (bundled && !isSelected())
+    {
+        return;     // 由捆绑路径绘制
+    }
+    // 先比较外接矩形，绝大多数线的两端图形并不相交
+    if (startItem->sceneBoundingRect().intersects(endItem->sceneBoundingRect()) && startItem->collidesWithItem(endItem))
     {
         return;
     }
     QPen myPen = pen();
     myPen.setColor(color);
-    qreal arrowSize = 10;
     painter->setPen(myPen);
     painter->setBrush(color);
 
-    QLineF centerLine(QPoint(80, 80) + startItem->pos(), QPoint(80, 80) + endItem->pos());
+    painter->drawPolygon(arrowHead);
+    if (isSelected())
+    {
+        painter->setPen(QPen(color, 3, Qt::DotLine));
+    }
+    if (path.size() > 2)
+    {
+        painter->drawPolyline(path);
+    }
+    else
+    {
+        painter->drawLine(line());
+    }
+}
 
-    QPointF startpoint = getBoundedIntersection(startItem, centerLine);
-    QPointF endpoint = getBoundedIntersection(endItem, centerLine);
+void LineItem::updatePosition()
+{
+    qreal arrowSize = 10;
+    QPolygonF newPath;
+    Scene* flowScene = qobject_cast<Scene*>(scene());
+    if (flowScene != nullptr && flowScene->getEdgeRouting() == OrthogonalRouting)
+    {
+        newPath = flowScene->routeEdge(this);                               // 绕开其他图形的正交折线，图形移动后在后台更新
+    }
+    else
+    {
+        QLineF centerLine(QPoint(80, 80) + startItem->pos(), QPoint(80, 80) + endItem->pos());
+        newPath << getBoundedIntersection(startItem, centerLine) << getBoundedIntersection(endItem, centerLine);
+    }
 
-    if (lines != QLineF(startpoint, endpoint))
+    if (path == newPath && lines == QLineF(newPath.first(), newPath.last()) && line() == lines)
     {
-        lines = QLineF(startpoint, endpoint);
-        emit itemPositionHasChanged();
+        return;     // 端点未变，无需重算
     }
-    setLine(lines);
+    path = newPath;
+    lines = QLineF(path.first(), path.last());
 
-    double angle = std::atan2(-line().dy(), line().dx());
+    // 箭头沿最后一段的方向
+    QLineF tail(path.at(path.size() - 2), path.last());
+    double angle = std::atan2(-tail.dy(), tail.dx());
 
-    QPointF arrowP1 = line().p2() + QPointF(sin(angle - M_PI / 3) * arrowSize,
-                                            cos(angle - M_PI / 3) * arrowSize);
-    QPointF arrowP2 = line().p2() + QPointF(sin(angle - M_PI + M_PI / 3) * arrowSize,
-                                            cos(angle - M_PI + M_PI / 3) * arrowSize);
+    QPointF arrowP1 = tail.p2() + QPointF(sin(angle - M_PI / 3) * arrowSize,
+                                          cos(angle - M_PI / 3) * arrowSize);
+    QPointF arrowP2 = tail.p2() + QPointF(sin(angle - M_PI + M_PI / 3) * arrowSize,
+                                          cos(angle - M_PI + M_PI / 3) * arrowSize);
 
+    prepareGeometryChange();                            // 箭头属于形状的一部分
     arrowHead.clear();
-    arrowHead << line().p2() << arrowP1 << arrowP2;
+    arrowHead << tail.p2() << arrowP1 << arrowP2;
+    setLine(lines);
+    Scene::updateItemIndex(this);                       // 更新网格索引
+    if (flowScene != nullptr)
+    {
+        flowScene->invalidateBundles();                 // 捆绑路径随之更新
+    }
+    emit itemPositionHasChanged();                      // 通知关联文本
+}
 
-    painter->drawPolygon(arrowHead);
-    if (isSelected())
+QVariant LineItem::itemChange(GraphicsItemChange change, const QVariant& value)
+{
+    if (change == QGraphicsItem::ItemSceneChange)
     {
-        painter->setPen(QPen(color, 3, Qt::DotLine));
+        Scene::removeItemIndex(this);                   // 从原场景的索引中移除
+    }
+    else if (change == QGraphicsItem::ItemSceneHasChanged)
+    {
+        if (value.value<QGraphicsScene*>() != nullptr)
+        {
+            updatePosition();                           // 加入场景后按场景的连线方式重新布线
+            Scene::updateGraphItem(this);               // 登记到流程检查
+        }
+        Scene::updateItemIndex(this);                   // 更新网格索引
+    }
+    else if (change == QGraphicsItem::ItemPositionHasChanged)
+    {
+        Scene::updateItemIndex(this);                   // 更新网格索引
     }
-    painter->drawLine(line());
+    return QGraphicsLineItem::itemChange(change, value);
 }
 
 void LineItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
@@ -11,6 +11,7 @@ class LineItem : public QObject , public QGraphicsLineItem
       Q_OBJECT
 public:
     LineItem(ChartItem* startItem, ChartItem* endItem, QGraphicsItem* parent = nullptr);
+    ~LineItem() override;
 
     QString Uid="";                                                                                     // 唯一识别id
     QColor color;                                                                                       // 颜色
@@ -21,16 +22,28 @@ public:
 
     int type() const override;
     QPointF getBoundedIntersection(ChartItem * _startitem,QLineF line);                                 // 获取中心对线的相交线
+    QPolygonF getPath() const;                                                                          // 连线经过的折线，直连时只有两个点
+    QPointF pathCenter() const;                                                                         // 折线长度一半处的点
+    bool isBundled() const { return bundled; }
+    void setBundled(bool bundled);                                                                      // 被捆绑时由捆绑路径代为绘制，只在选中时绘制自身
+
+public slots:
+    void updatePosition();                                                                              // 根据两端图形重新计算线和箭头
 
 protected:
     QRectF boundingRect() const override;                                                               // 返回边界矩形
     QPainterPath shape() const override;                                                                // 返回图形的形状，用于碰撞检测
     void paint(QPainter *painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;    // 绘制图形
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value) override;                     // 图形更改事件
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override;                               // 处理鼠标双击事件
 
 private:
+    QPainterPath fullShape() const;                                                                     // 折线和箭头的形状，不考虑是否被捆绑
+
     QPolygonF arrowHead;                                                                                // 箭头
     QLineF lines;                                                                                       // 线
+    QPolygonF path;                                                                                     // 折线，正交布线时经过各个拐点
+    bool bundled = false;                                                                               // 是否被捆绑
 
 signals:
     void doubleClickItem();                                                                             // 双击事件
@@ -1,4 +1,5 @@
 ﻿#include "mainwindow.h"
+#include "startuptrace.h"
 
 #include <QApplication>
 #include <QFont>
@@ -8,8 +9,14 @@
 // 主函数，应用程序的入口点
 int main(int argc, char *argv[])
 {
+    StartupTrace::start();
     QApplication a(argc, argv);
     QApplication::setStyle("Fusion");
+    StartupTrace::mark("application");
+    if (QApplication::arguments().contains("--startup-trace"))
+    {
+        StartupTrace::setEnabled(true);     // 首帧后输出各启动阶段的耗时
+    }
 
     MainWindow w;
     w.showMaximized();
@@ -2,24 +2,35 @@
 #include "ui_mainwindow.h"
 
 #include <QDebug>
+#include <QTimer>
+#include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
 {
     ui->setupUi(this);                  // 设置UI
+    StartupTrace::mark("setupUi");
+    tabCache = new TabCache(ui->tabWidget, [this](QWidget* page) { return createView(page); }, this);   // 不活动的页面按预算卸载
     setWindowTitle("flyhigh v1.1.1");   // 设置窗口标题为"flyhigh"和版本
     setAcceptDrops(true);               // 启用拖放操作
     loadChartView();                    // 加载流程图视图
+    StartupTrace::mark("loadChartView");
     createActions();                    // 创建动作（菜单项和工具栏按钮）
+    StartupTrace::mark("createActions");
     createMenus();                      // 创建菜单
+    StartupTrace::mark("createMenus");
     createToolBar();                    // 创建工具栏
+    StartupTrace::mark("createToolBar");
 
     connect(ui->insertLineAction, &QAction::triggered, this, &MainWindow::insertLine);
     connect(ui->insertTextAction, &QAction::triggered, this, &MainWindow::insertText);
     connect(ui->setColorAction, &QAction::triggered, this, &MainWindow::setFontColor);
     connect(ui->setFontAction, &QAction::triggered, this, &MainWindow::setFont);
     connect(ui->tabWidget, &QTabWidget::tabCloseRequested, this, &MainWindow::closeTab);
+
+    // 窗口最小化、隐藏或被子控件完全覆盖时收不到绘制事件，到时仍未完成就直接创建
+    QTimer::singleShot(startupFallbackMsecs, this, &MainWindow::finishStartup);
 }
 
 MainWindow::~MainWindow()
@@ -27,6 +38,31 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+bool MainWindow::event(QEvent* event)
+{
+    bool result = QMainWindow::event(event);
+    if (event->type() == QEvent::Paint && !firstFrame)
+    {
+        // 第一帧画完后再创建其余界面，不推迟窗口的显示
+        firstFrame = true;
+        StartupTrace::mark("firstFrame");
+        QMetaObject::invokeMethod(this, "finishStartup", Qt::QueuedConnection);
+    }
+    return result;
+}
+
+void MainWindow::finishStartup()
+{
+    if (startupFinished)
+    {
+        return;                                                         // 首帧和超时只处理先到的一次
+    }
+    createToolBarMenus();
+    startupFinished = true;
+    StartupTrace::mark("interactive");
+    StartupTrace::report();
+}
+
 void MainWindow:: loadChartView()
 {
     // 创建存放按钮的控件
@@ -35,6 +71,11 @@ void MainWindow:: loadChartView()
     flowLayout->setMargin(3);
     flowLayout->setSpacing(3);
 
+    // 图标按屏幕像素大小渲染后缓存在磁盘上，再次启动时直接读取，不再光栅化SVG
+    IconCache iconCache;
+    const QSize iconSize(234, 132);
+    const qreal ratio = devicePixelRatioF();
+
     // 遍历每个字符串
     for (int i = 0; i < FlowTypeStrings.count(); i++)
     {
@@ -44,8 +85,14 @@ void MainWindow:: loadChartView()
         button->setCheckable(false);                                            // 设置按钮为不可选中状态
         button->setToolTip(FlowTypeStrings[i]);                                 // 设置按钮提示
         button->setToolButtonStyle(Qt::ToolButtonTextUnderIcon);                // 设置按钮格式为图标在文本下方
-        button->setIcon(QIcon(QString(":/image/flowchart/icon/fc-%1-bw.svg").arg(i + 1)));
-        button->setIconSize(QSize(234, 132));
+        QString resource = QString(":/image/flowchart/icon/fc-%1-bw.svg").arg(i + 1);
+        QPixmap icon = QPixmap::fromImage(iconCache.image(resource, iconSize * ratio, [&resource, &iconSize, ratio]()
+        {
+            return QIcon(resource).pixmap(iconSize * ratio).toImage();
+        }));
+        icon.setDevicePixelRatio(ratio);
+        button->setIcon(QIcon(icon));
+        button->setIconSize(iconSize);
         connect(button, &ChartButton::hasSelectChart, this, &MainWindow::insertChart);
         flowLayout->addWidget(button);
     }
@@ -55,7 +102,7 @@ void MainWindow:: loadChartView()
 
 void MainWindow::insertChart(FlowEnumItem type)
 {
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view)
     {
         view->graphicsScene->setMode(Mode::InsertChart);
@@ -86,6 +133,20 @@ void MainWindow::createActions()
     saveAsAction->setObjectName("saveAsAction");  // 设置 objectName
     connect(saveAsAction, &QAction::triggered, this, &MainWindow::saveAsXMLFile);
 
+    // 打开项目文件
+    openProjectAction = new QAction(QIcon(":/image/XML.png"), tr("打开项目"), this);
+    openProjectAction->setShortcut(tr("Ctrl+Shift+O"));
+    openProjectAction->setStatusTip(tr("Open a project with several pages"));
+    openProjectAction->setObjectName("openProjectAction");
+    connect(openProjectAction, &QAction::triggered, this, &MainWindow::openProject);
+
+    // 保存项目文件
+    saveProjectAction = new QAction(QIcon(":/image/save.png"), tr("保存项目"), this);
+    saveProjectAction->setShortcut(tr("Ctrl+Shift+S"));
+    saveProjectAction->setStatusTip(tr("Save all pages to a project"));
+    saveProjectAction->setObjectName("saveProjectAction");
+    connect(saveProjectAction, &QAction::triggered, this, &MainWindow::saveProject);
+
     // 新建页
     newAction = new QAction(QIcon(":/image/addpng.png"), tr("新建"), this);
     newAction->setShortcut(tr("Ctrl+N"));
@@ -170,6 +231,27 @@ void MainWindow::createActions()
     addAction->setObjectName("addAction");
     connect(addAction, &QAction::triggered, this,&MainWindow::addPixmapItem);
 
+    // 自动布局
+    autoLayoutAction = new QAction(tr("自动布局"), this);
+    autoLayoutAction->setShortcut(tr("Ctrl+L"));
+    autoLayoutAction->setStatusTip(tr("按流程方向分层排列所有图形，再次触发时停止并保留目前最好的结果"));
+    autoLayoutAction->setObjectName("autoLayoutAction");
+    connect(autoLayoutAction, &QAction::triggered, this, &MainWindow::autoLayout);
+
+    // 正交连线
+    orthogonalRoutingAction = new QAction(tr("正交连线"), this);
+    orthogonalRoutingAction->setCheckable(true);
+    orthogonalRoutingAction->setStatusTip(tr("连线只走水平和竖直方向，并绕开其他图形"));
+    orthogonalRoutingAction->setObjectName("orthogonalRoutingAction");
+    connect(orthogonalRoutingAction, &QAction::toggled, this, &MainWindow::setOrthogonalRouting);
+
+    // 捆绑连线
+    edgeBundlingAction = new QAction(tr("捆绑连线"), this);
+    edgeBundlingAction->setCheckable(true);
+    edgeBundlingAction->setStatusTip(tr("入边很多的图形的入边合并为一束绘制"));
+    edgeBundlingAction->setObjectName("edgeBundlingAction");
+    connect(edgeBundlingAction, &QAction::toggled, this, &MainWindow::setEdgeBundling);
+
 }
 
 void MainWindow::addPixmapItem() {
@@ -177,13 +259,23 @@ void MainWindow::addPixmapItem() {
     QString fileName = QFileDialog::getOpenFileName(this, tr("导入图片作为元素"), ".", tr("Image Files (*.png *.jpg *.bmp *.jpeg)"));
     if (!fileName.isEmpty())                                                                    // 如果文件路径不为空，则继续处理
     {
-        View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");          // 获取当前的 QGraphicsView 对象
+        View* view = currentView();                                                             // 获取当前的 QGraphicsView 对象
         if (view != nullptr)
         {
-            QPixmap pixmap(fileName);                                                           // 加载图片
-            if (!pixmap.isNull())                                                               // 检查图片是否成功加载
+            // 压缩数据按内容哈希存入本页的图片仓库，相同的图片只保存一份
+            QFile file(fileName);
+            QString key = file.open(QIODevice::ReadOnly) ? view->graphicsScene->getImageStore().insert(file.readAll()) : QString();
+            // 比可见区域大的图片缩小到可见区域内显示，并只按显示大小和当前缩放比例解码，放大视图时再在后台提高分辨率
+            QSizeF display = view->graphicsScene->getImageStore().imageSize(key);
+            QSizeF visible = view->mapToScene(view->viewport()->rect()).boundingRect().size();
+            if (display.width() > visible.width() || display.height() > visible.height())
+            {
+                display.scale(visible, Qt::KeepAspectRatio);
+            }
+            qreal scale = view->transform().m11() * view->devicePixelRatioF();
+            PixmapItem* pixmapItem = key.isEmpty() ? nullptr : view->graphicsScene->createPixmapItem(key, display, scale);
+            if (pixmapItem != nullptr)                                                          // 检查图片是否成功加载
             {
-                PixmapItem* pixmapItem = new PixmapItem(pixmap);                                // 创建一个新的 CustomPixmapItem 对象
                 view->graphicsScene->addItem(pixmapItem);                                       // 添加图片项到场景中
                 view->operationStack->addOperation(new AppendOperation(QList<QGraphicsItem*>() << pixmapItem, view));
             }
@@ -206,18 +298,19 @@ void MainWindow::bg()
     QString fileName = QFileDialog::getOpenFileName(this, tr("导入图片作为背景"), ".", tr("Image Files (*.png *.jpg *.bmp *.jpeg)"));
     if (!fileName.isEmpty())                                                                                        // 如果文件路径不为空，则设置背景
     {
-        View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");                              // 获取当前的 QGraphicsView 对象
+        View* view = currentView();                                                                                 // 获取当前的 QGraphicsView 对象
         if (view != nullptr)
         {
-            QPixmap pixmap(fileName);                                                                               // 加载图片
-            if (!pixmap.isNull())                                                                                   // 检查图片是否成功加载
+            Scene* scene = view->graphicsScene;
+            QFile file(fileName);
+            QString key = file.open(QIODevice::ReadOnly) ? scene->getImageStore().insert(file.readAll()) : QString();  // 加载图片
+            if (!key.isEmpty())                                                                                     // 检查图片是否成功加载
             {
-                QBrush oldBackground = view->graphicsScene->backgroundBrush();
-                QPixmap scaledPixmap = pixmap.scaled(view->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);  // 将图片调整为与视图大小相同
-                view->graphicsScene->setBackgroundBrush(QBrush(scaledPixmap));                                      // 设置背景为缩放后的图片
-                view->graphicsScene->update();
+                QString oldImage = scene->getBackgroundImage();
+                QSize oldSize = scene->getBackgroundSize();
+                scene->setBackgroundImage(key, view->size());                                                       // 按与视图相同的大小解码作为背景
                 view->update();                                                                                     // 更新视图以适应新背景
-                view->operationStack->addOperation(new AppendBackgroundOperation(oldBackground, view->graphicsScene->backgroundBrush(), view));
+                view->operationStack->addOperation(new AppendBackgroundOperation(oldImage, oldSize, key, view->size(), view));
             }
             else
             {
@@ -257,123 +350,15 @@ void MainWindow::openXMLFile()
 void MainWindow::readXMLFile(QString filePath, int tabIndex)
 {
     QWidget* widget = ui->tabWidget->widget(tabIndex);
-    QMap<QString, ChartItem*> chartMap;
-    QMap<QString, LineItem*> lineMap;
-    QMap<QString, TextItem*> textMap;
-
     if (widget != nullptr)
     {
-        View* view = widget->findChild<View*>("graphicsView");
+        View* view = tabCache->view(widget);
         if (view != nullptr)
         {
             QFile file(filePath);
             if (file.open(QIODevice::ReadOnly | QIODevice::Text))
             {
-                QXmlStreamReader reader(&file);
-                while (!reader.atEnd())
-                {
-                    if (reader.isStartElement())
-                    {
-                        if (reader.name() == "ChartItem")
-                        {
-                            QXmlStreamAttributes attributes = reader.attributes();
-                            FlowEnumItem _flowtype = static_cast<FlowEnumItem>(attributes.value("FlowType").toInt());
-                            QStringList tranlist = attributes.value("QTransform").toString().split(" ");
-                            QTransform tran = QTransform(tranlist[0].toDouble(), tranlist[1].toDouble(), tranlist[2].toDouble(),
-                                                         tranlist[3].toDouble(), tranlist[4].toDouble(), tranlist[5].toDouble(),
-                                                         tranlist[6].toDouble(), tranlist[7].toDouble(), tranlist[8].toDouble());
-                            ChartItem* chartitem = new ChartItem(_flowtype);
-                            chartitem->Uid = attributes.value("Uid").toString();
-                            chartitem->setTransform(tran);
-                            chartitem->setPos(QPointF(attributes.value("X").toDouble(), attributes.value("Y").toDouble()));
-
-                            // 读取并设置颜色属性
-                            chartitem->setCurrentFillColor(attributes.value("FillColor").toString());
-                            chartitem->setCurrentBorderColor(attributes.value("BorderColor").toString());
-
-                            // 读取并设置图元路径
-                            QString svgPath = attributes.value("SvgPath").toString();
-                            chartitem->setCurrentPath(svgPath);
-                            chartitem->svgRender->load(svgPath);
-                            chartitem->setSharedRenderer(chartitem->svgRender);
-
-                            view->graphicsScene->addItem(chartitem);
-                            chartMap.insert(chartitem->Uid, chartitem);
-                        }
-                        else if (reader.name() == "LineItem")
-                        {
-                            QXmlStreamAttributes attributes = reader.attributes();
-                            QString myStartItemUid = attributes.value("myStartItem").toString();
-                            QString myEndItemUid = attributes.value("myEndItem").toString();
-                            if (chartMap.contains(myStartItemUid) && chartMap.contains(myEndItemUid))
-                            {
-                                LineItem* lineItem = new LineItem(chartMap[myStartItemUid], chartMap[myEndItemUid]);
-                                lineItem->setLine(QLineF(attributes.value("x1").toDouble(), attributes.value("y1").toDouble(),
-                                                         attributes.value("x2").toDouble(), attributes.value("y2").toDouble()));
-                                lineItem->color = QColor(attributes.value("myColor").toString());
-                                lineItem->Uid = attributes.value("Uid").toString();
-                                view->graphicsScene->addItem(lineItem);
-                                lineMap.insert(lineItem->Uid, lineItem);
-                            }
-                        }
-                        else if (reader.name() == "TextItem")
-                        {
-                            QXmlStreamAttributes attributes = reader.attributes();
-                            TextItem* textItem = new TextItem();
-                            view->graphicsScene->addItem(textItem);
-                            textItem->Uid = attributes.value("Uid").toString();
-                            textItem->setPlainText(attributes.value("HtmlText").toString());
-                            textItem->text = attributes.value("HtmlText").toString();
-                            textItem->setDefaultTextColor(QColor(attributes.value("defaultTextColor").toString()));
-                            QFont font = QFont();
-                            font.fromString(attributes.value("Font").toString());
-                            textItem->setFont(font);
-                            textItem->setPos(QPointF(attributes.value("X").toDouble(), attributes.value("Y").toDouble()));
-                            textItem->update();
-                            textMap.insert(textItem->Uid, textItem);
-                        }
-                        else if (reader.name() == "ConnectItem")
-                        {
-                            QXmlStreamAttributes attributes = reader.attributes();
-                            TextItem* textItem = nullptr;
-                            QGraphicsItem* connectItem = nullptr;
-                            // 找到关联文本项
-                            QString textUid = attributes.value("TextItemUid").toString();
-                            if (textMap.contains(textUid))
-                            {
-                                textItem = textMap[textUid];
-                            }
-                            // 找到关联图形项
-                            QString connectUid = attributes.value("ConnectItemUid").toString();
-                            if (chartMap.contains(connectUid))
-                            {
-                                connectItem = chartMap[connectUid];
-                            }
-                            else if (lineMap.contains(connectUid))
-                            {
-                                connectItem = lineMap[connectUid];
-                            }
-                            if (textItem && connectItem)
-                            {
-                                textItem->setConnectItem(connectItem);
-                                // 设置文本项的属性
-                                textItem->setFlag(QGraphicsItem::ItemIsMovable, false);                 // 禁用移动
-                                textItem->setFlag(QGraphicsItem::ItemIsSelectable, true);               // 启用选择
-                                textItem->setFlag(QGraphicsRectItem::ItemSendsGeometryChanges, false);  // 禁用几何变更信号
-                                // 连接图形项位置变化信号
-                                if (connectItem->type() == ChartItem::Type)
-                                {
-                                    connect(qgraphicsitem_cast<ChartItem*>(connectItem), &ChartItem::itemPositionHasChanged, textItem, &TextItem::parentPositionHasChanged);
-                                }
-                                else
-                                {
-                                    connect(qgraphicsitem_cast<LineItem*>(connectItem), &LineItem::itemPositionHasChanged, textItem, &TextItem::parentPositionHasChanged);
-                                }
-                            }
-                        }
-                    }
-                    reader.readNext();
-                }
+                view->graphicsScene->loadFromXml(&file);
                 file.close();
             }
             view->graphicsScene->update();
@@ -383,116 +368,20 @@ void MainWindow::readXMLFile(QString filePath, int tabIndex)
 
 void MainWindow::saveXMLFile()
 {
-    ui->tabWidget->currentWidget()->findChild<View*>("graphicsView")->operationStack->clearall();   // 清空操纵栈
+    currentView()->operationStack->clearall();   // 清空操纵栈
 }
 
 void MainWindow::writeXMLFile(QString filePath, QString tabName, QString guid, Scene* scene)
 {
-    QList<QGraphicsItem*> allItems = scene->items();
-    QList<ChartItem*> chartItems;
-    QList<TextItem*> textItems;
-    QList<LineItem*> lineItems;
-    QList<QPair<TextItem*, QGraphicsItem*>> connectItems;
-
-    for (QGraphicsItem* item : qAsConst(allItems))
-    {
-        switch (item->type())
-        {
-            case ChartItem::Type :
-                chartItems.append(qgraphicsitem_cast<ChartItem*>(item));
-                break;
-            case LineItem::Type :
-                lineItems.append(qgraphicsitem_cast<LineItem*>(item));
-                break;
-            case TextItem::Type :
-                textItems.append(qgraphicsitem_cast<TextItem*>(item));
-                break;
-        }
-    }
-
     QFile file(filePath);
     if (file.open(QIODevice::WriteOnly | QIODevice::Text))
     {
-        QXmlStreamWriter xml(&file);
-        xml.setAutoFormatting(true);
-        xml.writeStartDocument();
-        xml.writeStartElement("FlowCharts");
-        xml.writeAttribute("guid", guid);
-        xml.writeAttribute("Tabname", tabName);
-
-        for (ChartItem* chartItem : qAsConst(chartItems))
-        {
-            xml.writeStartElement("ChartItem");
-            xml.writeAttribute("Uid", chartItem->Uid);
-            xml.writeAttribute("FlowType", QString::number(static_cast<int>(chartItem->getChartType())));
-            xml.writeAttribute("FillColor", chartItem->getCurrentFillColor());
-            xml.writeAttribute("BorderColor", chartItem->getCurrentBorderColor());
-            xml.writeAttribute("SvgPath", chartItem->getCurrentPath());  // 保存图元路径
-
-            QStringList transform;
-            transform << QString::number(chartItem->transform().m11()) << QString::number(chartItem->transform().m12()) << QString::number(chartItem->transform().m13());
-            transform << QString::number(chartItem->transform().m21()) << QString::number(chartItem->transform().m22()) << QString::number(chartItem->transform().m23());
-            transform << QString::number(chartItem->transform().m31()) << QString::number(chartItem->transform().m32()) << QString::number(chartItem->transform().m33());
-            xml.writeAttribute("QTransform", transform.join(" "));
-            xml.writeAttribute("X", QString::number(chartItem->pos().x()));
-            xml.writeAttribute("Y", QString::number(chartItem->pos().y()));
-            xml.writeEndElement();
-        }
-
-        for (LineItem* lineItem : qAsConst(lineItems))
-        {
-            xml.writeStartElement("LineItem");
-            xml.writeAttribute("Uid", lineItem->Uid);
-            xml.writeAttribute("myStartItem", lineItem->startItem->Uid);
-            xml.writeAttribute("myEndItem", lineItem->endItem->Uid);
-            xml.writeAttribute("myColor", lineItem->color.name());
-            xml.writeAttribute("x1", QString::number(lineItem->line().x1()));
-            xml.writeAttribute("y1", QString::number(lineItem->line().y1()));
-            xml.writeAttribute("x2", QString::number(lineItem->line().x2()));
-            xml.writeAttribute("y2", QString::number(lineItem->line().y2()));
-            xml.writeEndElement();
-        }
-
-        for (TextItem* textItem : qAsConst(textItems))
-        {
-            xml.writeStartElement("TextItem");
-            xml.writeAttribute("Uid", textItem->Uid);
-            xml.writeAttribute("HtmlText", textItem->text);
-            xml.writeAttribute("defaultTextColor", textItem->defaultTextColor().name());
-            xml.writeAttribute("Font", textItem->font().toString());
-            xml.writeAttribute("X", QString::number(textItem->pos().x()));
-            xml.writeAttribute("Y", QString::number(textItem->pos().y()));
-            xml.writeEndElement();
-            // 检查关联图形
-            QGraphicsItem* connectItem = qgraphicsitem_cast<TextItem*>(textItem)->connectItem;
-            if (connectItem)
-            {
-                if ((connectItem->type() == ChartItem::Type && chartItems.contains(qgraphicsitem_cast<ChartItem*>(connectItem))) ||
-                        (connectItem->type() == LineItem::Type && lineItems.contains(qgraphicsitem_cast<LineItem*>(connectItem))))
-                {
-                    connectItems.append(qMakePair(qgraphicsitem_cast<TextItem*>(textItem), connectItem));
-                }
-            }
-        }
-
-        for (const auto& connectPair : connectItems)
+        scene->saveToXml(&file, tabName, guid);
+        file.close();
+        if (View::showPrompts)
         {
-            xml.writeStartElement("ConnectItem");
-            xml.writeAttribute("TextItemUid", connectPair.first->Uid);
-            if (connectPair.second->type() == ChartItem::Type) {
-                xml.writeAttribute("ConnectItemUid", qgraphicsitem_cast<ChartItem*>(connectPair.second)->Uid);
-            }
-            else
-            {
-                xml.writeAttribute("ConnectItemUid", qgraphicsitem_cast<LineItem*>(connectPair.second)->Uid);
-            }
-            xml.writeEndElement();
+            QMessageBox::information(this, "提示", "已保存到：" + filePath + "!");
         }
-
-        xml.writeEndElement();
-        xml.writeEndDocument();
-        file.close();
-        QMessageBox::information(this, "提示", "已保存到：" + filePath + "!");
     }
 }
 
@@ -508,7 +397,7 @@ void MainWindow::saveAsXMLFile()
         }
 
         QWidget* tabwidget = ui->tabWidget->currentWidget();
-        View* view = tabwidget->findChild<View*>("graphicsView");
+        View* view = currentView();
 
         QString tabName = ui->tabWidget->tabText(ui->tabWidget->indexOf(tabwidget));
 
@@ -521,6 +410,104 @@ void MainWindow::saveAsXMLFile()
     }
 }
 
+void MainWindow::openProject()
+{
+    QString filePath = QFileDialog::getOpenFileName(this, tr("打开项目"), ".", tr("Project Files (*.fcproj)"));
+    if (!filePath.isEmpty())
+    {
+        openProjectFile(filePath);
+    }
+}
+
+void MainWindow::saveProject()
+{
+    QString filePath = project.isNull() ? QString() : project->fileName();
+    if (filePath.isEmpty())
+    {
+        filePath = QFileDialog::getSaveFileName(this, tr("保存项目"), ".", tr("Project Files (*.fcproj)"));
+        if (filePath.isEmpty())
+        {
+            return;
+        }
+        if (!filePath.endsWith(".fcproj", Qt::CaseInsensitive))
+        {
+            filePath += ".fcproj";
+        }
+    }
+    saveProjectFile(filePath);
+}
+
+bool MainWindow::openProjectFile(const QString& filePath)
+{
+    QSharedPointer<ProjectFile> opened(new ProjectFile());
+    QString errorString;
+    if (!opened->open(filePath, &errorString))
+    {
+        if (View::showPrompts)
+        {
+            QMessageBox::warning(this, tr("错误"), tr("无法打开项目：") + errorString);
+        }
+        return false;
+    }
+    // 只读取了目录，页面在首次激活时才创建图形项
+    int first = -1;
+    for (const ProjectFile::Page& page : opened->pages())
+    {
+        int index = addTabWidgetPage(page.name, false);
+        QWidget* widget = ui->tabWidget->widget(index);
+        widget->setObjectName(page.guid);
+        tabCache->addProjectPage(widget, opened);
+        if (first < 0)
+        {
+            first = index;
+        }
+    }
+    project = opened;
+    if (first >= 0)
+    {
+        ui->tabWidget->setCurrentIndex(first);
+        tabCache->touch(first);                                         // 第一页可能本来就是当前页，不会发出 currentChanged
+    }
+    return true;
+}
+
+bool MainWindow::saveProjectFile(const QString& filePath)
+{
+    ProjectFile* target = project.isNull() ? new ProjectFile() : project.data();
+    QSharedPointer<ProjectFile> saved = project.isNull() ? QSharedPointer<ProjectFile>(target) : project;
+    QVector<ProjectFile::SavedPage> pages;
+    for (int i = 0; i < ui->tabWidget->count(); ++i)
+    {
+        QWidget* widget = ui->tabWidget->widget(i);
+        ProjectFile::SavedPage page;
+        page.guid = widget->objectName();
+        page.name = ui->tabWidget->tabText(i);
+        // 来自该项目且未修改的页面沿用文件中的内容，不需要加载
+        page.dirty = tabCache->isModified(widget) || tabCache->sourceProject(widget) != saved || target->indexOf(page.guid) < 0;
+        if (page.dirty)
+        {
+            page.model = tabCache->model(widget);
+        }
+        pages.append(page);
+    }
+    QString errorString;
+    if (!target->save(filePath, pages, &errorString))
+    {
+        if (View::showPrompts)
+        {
+            QMessageBox::warning(this, tr("错误"), tr("无法保存项目：") + errorString);
+        }
+        return false;
+    }
+    project = saved;
+    for (int i = 0; i < ui->tabWidget->count(); ++i)
+    {
+        tabCache->setModified(ui->tabWidget->widget(i), false);
+        tabCache->setSourceProject(ui->tabWidget->widget(i), saved);
+    }
+    return true;
+}
+
 void MainWindow::createNewPage()
 {
     bool ok = false;
@@ -532,7 +519,7 @@ void MainWindow::createNewPage()
     }
 }
 
-int MainWindow::addTabWidgetPage(QString pageName)
+int MainWindow::addTabWidgetPage(QString pageName, bool withView)
 {
     // 新增页的图标
     QIcon pageIcon;
@@ -549,13 +536,10 @@ int MainWindow::addTabWidgetPage(QString pageName)
     verticalLayout->setContentsMargins(0, 0, 0, 0);                                             // 内边距为0
 
     // 设置视图
-    View* graphicsView = new View(newPage);
-    graphicsView->setObjectName("graphicsView");
-    graphicsView->setStyleSheet("border:0px;");                                                 // 无边框
-    graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);                           // 禁用垂直滚动条
-    graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);                         // 禁用水平滚动条
-    graphicsView->setDragMode(QGraphicsView::RubberBandDrag);                                   // 拖动模式设置为橡皮带拖动
-    verticalLayout->addWidget(graphicsView);                                                    // 视图垂直排列在布局管理器上
+    if (withView)
+    {
+        createView(newPage);
+    }
 
     // 设置水平线
     QFrame* horizontalLine = new QFrame(newPage);
@@ -599,7 +583,6 @@ int MainWindow::addTabWidgetPage(QString pageName)
     scaleDoubleSpinBox->setMinimum(-9999.000000000000000);                                      // 设置最小值
     scaleDoubleSpinBox->setMaximum(9999.989999999999782);                                       // 设置最大值
     scaleDoubleSpinBox->setValue(100.000000000000000);                                          // 设置初始值
-    connect(graphicsView, &View::scaleMultipleChanged, this, &MainWindow::scaleValueChanged);   // 缩放程度改变时发出信号调用槽函数修改控件显示的值
     horizontalLayout->addWidget(scaleDoubleSpinBox);
 
     // 设置垂直的分割线1
@@ -617,6 +600,16 @@ int MainWindow::addTabWidgetPage(QString pageName)
     searchEdit->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);                             // 隐藏垂直滚动条
     horizontalLayout->addWidget(searchEdit);
 
+    // 设置匹配方式
+    QComboBox* searchModeBox = new QComboBox(toolBox);
+    searchModeBox->setFont(Font);
+    searchModeBox->setObjectName(QString::fromUtf8("searchModeBox"));
+    searchModeBox->addItem("精确", int(LabelIndex::Exact));
+    searchModeBox->addItem("前缀", int(LabelIndex::Prefix));
+    searchModeBox->addItem("包含", int(LabelIndex::Substring));
+    searchModeBox->addItem("正则", int(LabelIndex::Regex));
+    horizontalLayout->addWidget(searchModeBox);
+
     // 设置搜索按钮
     QPushButton* searchButton = new QPushButton(toolBox);
     searchButton->setFont(Font);
@@ -646,6 +639,15 @@ int MainWindow::addTabWidgetPage(QString pageName)
     horizontalLayout->addWidget(replaceButton);
     connect(replaceButton, &QPushButton::pressed, this, &MainWindow::replaceText);
 
+    // 设置全部替换按钮
+    QPushButton* replaceAllButton = new QPushButton(toolBox);
+    replaceAllButton->setFont(Font);
+    replaceAllButton->setObjectName(QString::fromUtf8("replaceAllButton"));
+    replaceAllButton->setText("全部替换");
+    replaceAllButton->setFlat(true);
+    horizontalLayout->addWidget(replaceAllButton);
+    connect(replaceAllButton, &QPushButton::pressed, this, &MainWindow::replaceAllText);
+
     // 设置上一个按钮
     QPushButton* lastButton = new QPushButton(toolBox);
     lastButton->setFont(Font);
@@ -722,11 +724,38 @@ int MainWindow::addTabWidgetPage(QString pageName)
     horizontalLayout->addWidget(saveSVGButton);
     verticalLayout->addWidget(toolBox);
 
+    if (withView)
+    {
+        tabCache->addPage(newPage);
+    }
+    return ui->tabWidget->addTab(newPage, pageIcon, pageName);
+}
+
+View* MainWindow::createView(QWidget* page)
+{
+    View* graphicsView = new View(page);
+    graphicsView->setObjectName("graphicsView");
+    graphicsView->setStyleSheet("border:0px;");                                                 // 无边框
+    graphicsView->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);                           // 禁用垂直滚动条
+    graphicsView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);                         // 禁用水平滚动条
+    graphicsView->setDragMode(QGraphicsView::RubberBandDrag);                                   // 拖动模式设置为橡皮带拖动
+    if (orthogonalRoutingAction->isChecked())
+    {
+        graphicsView->graphicsScene->setEdgeRouting(OrthogonalRouting);                        // 新页面沿用当前的连线方式
+    }
+    graphicsView->graphicsScene->setEdgeBundling(edgeBundlingAction->isChecked());
+    qobject_cast<QVBoxLayout*>(page->layout())->insertWidget(0, graphicsView);                 // 视图在工具栏上方
+    connect(graphicsView, &View::scaleMultipleChanged, this, &MainWindow::scaleValueChanged);   // 缩放程度改变时发出信号调用槽函数修改控件显示的值
+
     // 添加右键菜单
     graphicsView->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(graphicsView, &QGraphicsView::customContextMenuRequested, this, &MainWindow::showMenu);
+    return graphicsView;
+}
 
-    return ui->tabWidget->addTab(newPage, pageIcon, pageName);
+View* MainWindow::currentView()
+{
+    return tabCache->view(ui->tabWidget->currentWidget());                                     // 已卸载时重新创建
 }
 
 void MainWindow::scaleValueChanged(double scaleMultiple)
@@ -737,95 +766,94 @@ void MainWindow::scaleValueChanged(double scaleMultiple)
 
 void MainWindow::searchText()
 {
-    View* view = sender()->parent()->parent()->findChild<View*>("graphicsView");
-    // 重置
-    view->graphicsScene->containTexts.clear();
-    view->graphicsScene->currentIndex = 0;
+    View* view = tabCache->view(qobject_cast<QWidget*>(sender()->parent()->parent()));
     QTextEdit* searchEdit = sender()->parent()->findChild<QTextEdit*>("searchEdit");
+    QComboBox* searchModeBox = sender()->parent()->findChild<QComboBox*>("searchModeBox");
     QString text = searchEdit->toPlainText();
-    view->graphicsScene->currentText = text;
-    for (TextItem* textItem : view->graphicsScene->allTexts)
+    LabelIndex::MatchMode mode = LabelIndex::MatchMode(searchModeBox->currentData().toInt());
+    view->graphicsScene->searchText(text, mode);
+    if (!view->graphicsScene->containTexts.isEmpty())
     {
-        if (textItem->toPlainText() == text && text != "") // 包含文本且不为空
-        {
-            view->graphicsScene->containTexts.append(textItem);
-        }
-        textItem->setSelected(false);
+        return;
     }
-    // 不为空
-    if (!view->graphicsScene->containTexts.isEmpty())
+    // 当前页没有时依次查找其他页，切换到第一个有结果的页
+    int current = ui->tabWidget->currentIndex();
+    for (int offset = 1; offset < ui->tabWidget->count(); ++offset)
     {
-       view->graphicsScene->containTexts[0]->setSelected(true);
+        QWidget* page = ui->tabWidget->widget((current + offset) % ui->tabWidget->count());
+        if (!tabCache->isLoaded(page))
+        {
+            // 已卸载的页面先检查保存的文本，有匹配时才重新创建
+            QStringList labels = tabCache->labelTexts(page);
+            Qt::CaseSensitivity sensitivity = mode == LabelIndex::Exact ? Qt::CaseSensitive : Qt::CaseInsensitive;
+            if (std::none_of(labels.cbegin(), labels.cend(), [&](const QString& label) { return LabelIndex::matches(label, text, mode, sensitivity); }))
+            {
+                continue;
+            }
+        }
+        View* pageView = tabCache->view(page);
+        if (pageView == nullptr)
+        {
+            continue;
+        }
+        pageView->graphicsScene->searchText(text, mode);
+        if (!pageView->graphicsScene->containTexts.isEmpty())
+        {
+            page->findChild<QTextEdit*>("searchEdit")->setPlainText(text);  // 在该页继续上一个、下一个
+            page->findChild<QComboBox*>("searchModeBox")->setCurrentIndex(searchModeBox->currentIndex());
+            ui->tabWidget->setCurrentWidget(page);
+            return;
+        }
     }
 }
 
 void MainWindow::lastText()
 {
-    View* view = sender()->parent()->parent()->findChild<View*>("graphicsView");
+    View* view = tabCache->view(qobject_cast<QWidget*>(sender()->parent()->parent()));
+    Scene* scene = view->graphicsScene;
     // 移除已经更改的文本
-    for (TextItem* textItem : view->graphicsScene->containTexts)
+    if (scene->refreshSearch() > 0)
     {
-        if (textItem->toPlainText() != view->graphicsScene->currentText)
+        scene->containTexts[scene->currentIndex]->setSelected(false);
+        if (scene->currentIndex > 0)
         {
-            view->graphicsScene->containTexts.removeOne(textItem);
-        }
-    }
-    if (!view->graphicsScene->containTexts.isEmpty())
-    {
-        view->graphicsScene->containTexts[view->graphicsScene->currentIndex]->setSelected(false);
-        if (view->graphicsScene->currentIndex > 0)
-        {
-            view->graphicsScene->currentIndex--;
+            scene->currentIndex--;
         }
         else
         {
-            view->graphicsScene->currentIndex = view->graphicsScene->containTexts.count() - 1;
+            scene->currentIndex = scene->containTexts.count() - 1;
         }
-        view->graphicsScene->containTexts[view->graphicsScene->currentIndex]->setSelected(true);
+        scene->containTexts[scene->currentIndex]->setSelected(true);
     }
 }
 
 void MainWindow::nextText()
 {
-    View* view = sender()->parent()->parent()->findChild<View*>("graphicsView");
-    for (TextItem* textItem : view->graphicsScene->containTexts)
-    {
-        if (textItem->toPlainText() != view->graphicsScene->currentText)
-        {
-            view->graphicsScene->containTexts.removeOne(textItem);
-        }
-    }
-    if (!view->graphicsScene->containTexts.isEmpty())
+    View* view = tabCache->view(qobject_cast<QWidget*>(sender()->parent()->parent()));
+    Scene* scene = view->graphicsScene;
+    if (scene->refreshSearch() > 0)
     {
-        view->graphicsScene->containTexts[view->graphicsScene->currentIndex]->setSelected(false);
-        if (view->graphicsScene->currentIndex < view->graphicsScene->containTexts.count() - 1)
+        scene->containTexts[scene->currentIndex]->setSelected(false);
+        if (scene->currentIndex < scene->containTexts.count() - 1)
         {
-            view->graphicsScene->currentIndex++;
+            scene->currentIndex++;
         }
         else
         {
-            view->graphicsScene->currentIndex = 0;
+            scene->currentIndex = 0;
         }
-        view->graphicsScene->containTexts[view->graphicsScene->currentIndex]->setSelected(true);
+        scene->containTexts[scene->currentIndex]->setSelected(true);
     }
 }
 
 void MainWindow::allText()
 {
     // 获取当前视图
-    View* view = sender()->parent()->parent()->findChild<View*>("graphicsView");
+    View* view = tabCache->view(qobject_cast<QWidget*>(sender()->parent()->parent()));
     if (!view) return;
 
     // 清除与当前查找文本不匹配的文本项
-    QList<TextItem*> validTexts;
-    for (TextItem* textItem : view->graphicsScene->containTexts)
-    {
-        if (textItem->toPlainText() == view->graphicsScene->currentText)
-        {
-            validTexts.append(textItem);
-        }
-    }
-    view->graphicsScene->containTexts = validTexts; // 更新 `containTexts` 列表
+    view->graphicsScene->refreshSearch();
 
     // 设置所有匹配的文本项为选中状态
     for (TextItem* textItem : view->graphicsScene->containTexts)
@@ -836,29 +864,45 @@ void MainWindow::allText()
 
 void MainWindow::replaceText()
 {
-    View* view = sender()->parent()->parent()->findChild<View*>("graphicsView");
+    View* view = tabCache->view(qobject_cast<QWidget*>(sender()->parent()->parent()));
     QTextEdit* replaceEdit = sender()->parent()->findChild<QTextEdit*>("replaceEdit");
 
-    QString oldText;
     QString newText = replaceEdit->toPlainText();
 
+    // 每个文本各自记录原来的内容
     QList<QGraphicsItem*> textItems;
+    QVector<QString> oldTexts;
     for (TextItem* textItem : view->graphicsScene->allTexts)
     {
-
         if (textItem->isSelected()) // 被选中的文本框
         {
-            oldText = textItem->toPlainText();
-            textItem->setHtml(newText);
+            oldTexts << textItem->toPlainText();
             textItems << textItem;
         }
     }
-    view->operationStack->addOperation(new ReplacceTextOperation(oldText, newText, textItems, view));
+    if (textItems.isEmpty())
+    {
+        return;
+    }
+    QVector<QString> newTexts(textItems.size(), newText);
+    Scene::setTexts(textItems, newTexts);
+    view->operationStack->addOperation(new ReplacceTextOperation(oldTexts, newTexts, textItems, view));
+}
+
+void MainWindow::replaceAllText()
+{
+    View* view = tabCache->view(qobject_cast<QWidget*>(sender()->parent()->parent()));
+    QTextEdit* searchEdit = sender()->parent()->findChild<QTextEdit*>("searchEdit");
+    QComboBox* searchModeBox = sender()->parent()->findChild<QComboBox*>("searchModeBox");
+    QTextEdit* replaceEdit = sender()->parent()->findChild<QTextEdit*>("replaceEdit");
+    // 结果在后台算好后作为一次操作应用
+    view->graphicsScene->replaceAll(searchEdit->toPlainText(), LabelIndex::MatchMode(searchModeBox->currentData().toInt()),
+                                    replaceEdit->toPlainText());
 }
 
 void MainWindow::saveSVG()
 {
-    View* view = sender()->parent()->parent()->findChild<View*>("graphicsView");
+    View* view = tabCache->view(qobject_cast<QWidget*>(sender()->parent()->parent()));
     QString defaultPath = "C:/";    // 默认路径
     QString filename = QFileDialog::getSaveFileName(this, tr("Save SVG File"), defaultPath, tr("SVG Files (*.svg)"));
     if (!filename.isEmpty())
@@ -869,7 +913,7 @@ void MainWindow::saveSVG()
 
 void MainWindow::showMenu(const QPoint& position)
 {
-    View* graphicsView = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* graphicsView = currentView();
     QMenu contextMenu(tr("Context menu"), graphicsView);    // 创建菜单，并关联到视图中
 
     // 将动作插入到菜单中
@@ -889,7 +933,7 @@ void MainWindow::showMenu(const QPoint& position)
 
 void MainWindow::deleteSelect()
 {
-    View* graphicsView = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* graphicsView = currentView();
     QList<QGraphicsItem *> items = graphicsView->graphicsScene->selectedItems();
 
     if (items.count() != 0)
@@ -917,130 +961,11 @@ void MainWindow::copySelect()
     {
        return;
     }
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view != nullptr)
     {
-        QList<QGraphicsItem*> selectedItems = view->graphicsScene->selectedItems();
-        QMap<ChartItem*, QString> copiedChartItems;
-        QMap<LineItem*, QString> copiedLineItems;
-        QMap<TextItem*, QString> copiedTextItems;
-        QList<QPair<TextItem*, QGraphicsItem*>> copiedConnectItems;
-        // 分类
-        for (QGraphicsItem* item : qAsConst(selectedItems))
-        {
-            switch(item->type())
-            {
-                case ChartItem::Type :
-                    copiedChartItems.insert(qgraphicsitem_cast<ChartItem*>(item), QUuid::createUuid().toString(QUuid::WithoutBraces));
-                    break;
-                case LineItem::Type :
-                    copiedLineItems.insert(qgraphicsitem_cast<LineItem*>(item), QUuid::createUuid().toString(QUuid::WithoutBraces));
-                    break;
-                case TextItem::Type :
-                    copiedTextItems.insert(qgraphicsitem_cast<TextItem*>(item), QUuid::createUuid().toString(QUuid::WithoutBraces));
-                    break;
-            }
-        }
-
         QClipboard* clipboard = QApplication::clipboard();  // 剪切板
-        QString clipboardData;
-        QXmlStreamWriter xml(&clipboardData);               // 创建XML流读取数据
-        xml.setAutoFormatting(true);
-        xml.writeStartDocument();
-        xml.writeStartElement("CopiedItems");
-
-        // 复制图形信息
-        for (ChartItem* chartItem : copiedChartItems.keys())
-        {
-            xml.writeStartElement("ChartItem");
-            xml.writeAttribute("Uid", copiedChartItems[chartItem]);
-            xml.writeAttribute("FlowType", QString::number(static_cast<int>(chartItem->getChartType())));
-            xml.writeAttribute("X", QString::number(chartItem->pos().x()));
-            xml.writeAttribute("Y", QString::number(chartItem->pos().y()));
-            xml.writeAttribute("FillColor", chartItem->getCurrentFillColor());
-            xml.writeAttribute("BorderColor", chartItem->getCurrentBorderColor());
-            // 添加缩放矩阵信息
-            QTransform transform = chartItem->transform();
-            QStringList trans;
-            trans << QString::number(transform.m11()) << QString::number(transform.m12())
-                  << QString::number(transform.m13());
-            trans << QString::number(transform.m21()) << QString::number(transform.m22())
-                  << QString::number(transform.m23());
-            trans << QString::number(transform.m31()) << QString::number(transform.m32())
-                  << QString::number(transform.m33());
-            xml.writeAttribute("QTransform", trans.join(" "));
-            xml.writeEndElement();
-        }
-
-
-        // 复制线信息
-        for (LineItem* lineItem : copiedLineItems.keys())
-        {
-            xml.writeStartElement("LineItem");
-            xml.writeAttribute("Uid", copiedLineItems[lineItem]);
-            xml.writeAttribute("myStartItem", copiedChartItems[lineItem->startItem]);
-            xml.writeAttribute("myEndItem", copiedChartItems[lineItem->endItem]);
-            xml.writeAttribute("myColor", lineItem->color.name());
-            xml.writeAttribute("x1", QString::number(lineItem->line().x1()));
-            xml.writeAttribute("y1", QString::number(lineItem->line().y1()));
-            xml.writeAttribute("x2", QString::number(lineItem->line().x2()));
-            xml.writeAttribute("y2", QString::number(lineItem->line().y2()));
-            xml.writeEndElement();
-        }
-
-        // 复制文本信息
-        for (TextItem* textItem : copiedTextItems.keys())
-        {
-            xml.writeStartElement("TextItem");
-            xml.writeAttribute("Uid", copiedTextItems[textItem]);
-            xml.writeAttribute("HtmlText", textItem->text);
-            xml.writeAttribute("defaultTextColor", textItem->defaultTextColor().name());
-            xml.writeAttribute("Font", textItem->font().toString());
-            xml.writeAttribute("X", QString::number(textItem->pos().x()));
-            xml.writeAttribute("Y", QString::number(textItem->pos().y()));
-
-            // 添加缩放矩阵信息
-            QTransform transform = textItem->transform();
-            QStringList trans;
-            trans << QString::number(transform.m11()) << QString::number(transform.m12())
-                  << QString::number(transform.m13());
-            trans << QString::number(transform.m21()) << QString::number(transform.m22())
-                  << QString::number(transform.m23());
-            trans << QString::number(transform.m31()) << QString::number(transform.m32())
-                  << QString::number(transform.m33());
-            xml.writeAttribute("QTransform", trans.join(" "));
-            xml.writeEndElement();
-            // 检查关联图形
-            QGraphicsItem* connectItem = qgraphicsitem_cast<TextItem*>(textItem)->connectItem;
-            if (connectItem)
-            {
-                if ((connectItem->type() == ChartItem::Type && copiedChartItems.keys().contains(qgraphicsitem_cast<ChartItem*>(connectItem))) ||
-                        (connectItem->type() == LineItem::Type && copiedLineItems.keys().contains(qgraphicsitem_cast<LineItem*>(connectItem))))
-                {
-                    copiedConnectItems.append(qMakePair(qgraphicsitem_cast<TextItem*>(textItem), connectItem));
-                }
-            }
-        }
-
-        // 复制关联信息
-        for (const auto& connectPair : copiedConnectItems)
-        {
-            xml.writeStartElement("ConnectItem");
-            xml.writeAttribute("TextItemUid", copiedTextItems[connectPair.first]);
-            if (connectPair.second->type() == ChartItem::Type)
-            {
-                xml.writeAttribute("ConnectItemUid", copiedChartItems[qgraphicsitem_cast<ChartItem*>(connectPair.second)]);
-            }
-            else
-            {
-                xml.writeAttribute("ConnectItemUid", copiedLineItems[qgraphicsitem_cast<LineItem*>(connectPair.second)]);
-            }
-            xml.writeEndElement();
-        }
-
-        xml.writeEndElement();                              // 读取结束
-        xml.writeEndDocument();
-        clipboard->setText(clipboardData);
+        clipboard->setText(view->graphicsScene->copyToXml(view->graphicsScene->selectedItems()));
     }
 }
 
@@ -1051,7 +976,7 @@ void MainWindow::pasteSelect()
         return;
     }
 
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view != nullptr)
     {
         QClipboard *clipboard = QApplication::clipboard();
@@ -1066,193 +991,11 @@ void MainWindow::pasteSelect()
         // 获取鼠标当前位置并转换为场景坐标
         QPointF mousePosition = view->mapToScene(view->mapFromGlobal(QCursor::pos()));
 
-        QXmlStreamReader reader(clipboardData);
-        QMap<QString, ChartItem*> mapCharts;
-        QMap<QString, LineItem*> mapLines;
-        QMap<QString, TextItem*> mapTexts;
-
-        // 用于计算复制项的中心点
-        QList<QPointF> originalPositions;
-        // 首先遍历一次，收集所有图形项的位置
-        while (!reader.atEnd())
-        {
-            reader.readNext();
-            if (reader.isStartElement() && reader.name() == "ChartItem")
-            {
-                QXmlStreamAttributes attributes = reader.attributes();
-                QPointF originalPos(attributes.value("X").toDouble(), attributes.value("Y").toDouble());
-                originalPositions.append(originalPos);
-            }
-
-            if (reader.isStartElement() && reader.name() == "TextItem")
-            {
-                QXmlStreamAttributes attributes = reader.attributes();
-                QPointF originalPos(attributes.value("X").toDouble(), attributes.value("Y").toDouble());
-                originalPositions.append(originalPos);
-            }
-        }
-
-        // 计算原始图形项的中心点
-        QPointF centerPosition;
-        for (const QPointF& pos : originalPositions)
-        {
-           centerPosition += pos;
-        }
-        if (!originalPositions.empty())
+        QString errorString;
+        QList<QGraphicsItem*> appendItems = view->graphicsScene->pasteFromXml(clipboardData, mousePosition, &errorString);
+        if (!errorString.isEmpty())
         {
-           centerPosition /= originalPositions.size();
-        }
-
-        // 计算鼠标位置和中心点之间的偏移
-        QPointF offset = mousePosition - centerPosition;
-
-        // 重新开始读取剪贴板数据，实际创建图形项
-        reader.clear();
-        reader.addData(clipboardData);
-
-        QList<QGraphicsItem*> appendItems;
-        while (!reader.atEnd())
-        {
-            reader.readNext();
-            // 粘贴图形
-            if (reader.isStartElement() && reader.name() == "ChartItem")
-            {
-                QXmlStreamAttributes attributes = reader.attributes();
-                FlowEnumItem _flowtype = static_cast<FlowEnumItem>(attributes.value("FlowType").toInt());
-                ChartItem* chartItem = new ChartItem(_flowtype);
-                chartItem->Uid = attributes.value("Uid").toString();
-
-                // 计算粘贴时的新位置
-                QPointF originalPos(attributes.value("X").toDouble(), attributes.value("Y").toDouble());
-                chartItem->setPos(originalPos + offset);
-
-                // 应用缩放矩阵
-                QStringList tranlist = attributes.value("QTransform").toString().split(" ");
-                if (tranlist.size() == 9)
-                {
-                    QTransform transform = QTransform(
-                                tranlist[0].toDouble(), tranlist[1].toDouble(), tranlist[2].toDouble(),
-                                tranlist[3].toDouble(), tranlist[4].toDouble(), tranlist[5].toDouble(),
-                                tranlist[6].toDouble(), tranlist[7].toDouble(), tranlist[8].toDouble());
-                    chartItem->setTransform(transform);
-                }
-
-                // 恢复填充颜色和边框颜色
-                QString fillColor = attributes.value("FillColor").toString();
-                QString borderColor = attributes.value("BorderColor").toString();
-                QString newPath = QString(":/image/flowchart/icon/fc-%1-%2%3.svg")
-                                  .arg(static_cast<int>(_flowtype))
-                                  .arg(borderColor)
-                                  .arg(fillColor);
-                chartItem->svgRender->load(newPath);
-                chartItem->setSharedRenderer(chartItem->svgRender);
-                chartItem->setCurrentPath(newPath);
-
-                view->graphicsScene->addItem(chartItem);
-                appendItems << chartItem;
-                mapCharts.insert(chartItem->Uid, chartItem);
-            }
-            // 粘贴连接线
-            else if (reader.isStartElement() && reader.name() == "LineItem")
-            {
-               QXmlStreamAttributes attributes = reader.attributes();
-               QString myStartItem_uid = attributes.value("myStartItem").toString();
-               QString myEndItem_uid = attributes.value("myEndItem").toString();
-
-               if (mapCharts.contains(myStartItem_uid) && mapCharts.contains(myEndItem_uid))
-               {
-                   LineItem* lineItem = new LineItem(mapCharts[myStartItem_uid], mapCharts[myEndItem_uid]);
-                   lineItem->setLine(QLineF(attributes.value("x1").toDouble() + offset.x(), attributes.value("y1").toDouble() + offset.y(),
-                                            attributes.value("x2").toDouble() + offset.x(), attributes.value("y2").toDouble() + offset.y()));
-                   lineItem->color = QColor(attributes.value("myColor").toString());
-                   lineItem->Uid = attributes.value("Uid").toString();
-                   view->graphicsScene->addItem(lineItem);
-                   appendItems << lineItem;
-                   view->graphicsScene->allLines.append(lineItem);
-                   connect(lineItem, &LineItem::doubleClickItem, view->graphicsScene, &Scene::doubleClickItem);
-                   mapLines.insert(lineItem->Uid, lineItem);
-                }
-            }
-            // 粘贴文本
-            else if (reader.isStartElement() && reader.name() == "TextItem")
-            {
-                QXmlStreamAttributes attributes = reader.attributes();
-                TextItem* textItem = new TextItem;
-                view->graphicsScene->addItem(textItem);
-                textItem->Uid = attributes.value("Uid").toString();
-                textItem->setHtml(attributes.value("HtmlText").toString());
-                textItem->text = attributes.value("HtmlText").toString();
-                QFont font = QFont();
-                font.fromString(attributes.value("Font").toString());
-                textItem->setFont(font);
-                textItem->setDefaultTextColor(QColor(attributes.value("defaultTextColor").toString()));
-                textItem->update();
-
-                // 计算粘贴时的新位置
-                QPointF originalPos(attributes.value("X").toDouble(), attributes.value("Y").toDouble());
-                textItem->setPos(originalPos + offset);
-
-                // 应用缩放矩阵
-                QStringList tranlist = attributes.value("QTransform").toString().split(" ");
-                if (tranlist.size() == 9)
-                {
-                    QTransform tran = QTransform(
-                                tranlist[0].toDouble(), tranlist[1].toDouble(), tranlist[2].toDouble(),
-                                tranlist[3].toDouble(), tranlist[4].toDouble(), tranlist[5].toDouble(),
-                                tranlist[6].toDouble(), tranlist[7].toDouble(), tranlist[8].toDouble());
-                    textItem->setTransform(tran);
-                }
-
-                appendItems << textItem;
-                view->graphicsScene->allTexts.append(textItem);
-                mapTexts.insert(textItem->Uid, textItem);
-            }
-            // 粘贴关联信息
-            else if (reader.isStartElement() && reader.name() == "ConnectItem")
-            {
-                QXmlStreamAttributes attributes = reader.attributes();
-                TextItem* textItem = nullptr;
-                QGraphicsItem* connectItem = nullptr;
-                // 找到关联文本项
-                QString textUid = attributes.value("TextItemUid").toString();
-                if (mapTexts.contains(textUid))
-                {
-                    textItem = mapTexts[textUid];
-                }
-                // 找到关联图形项
-                QString connectUid = attributes.value("ConnectItemUid").toString();
-                if (mapCharts.contains(connectUid))
-                {
-                    connectItem = mapCharts[connectUid];
-                }
-                else if (mapLines.contains(connectUid))
-                {
-                    connectItem = mapLines[connectUid];
-                }
-                if (textItem && connectItem)
-                {
-                    textItem->setConnectItem(connectItem);
-                    // 设置文本项的属性
-                    textItem->setFlag(QGraphicsItem::ItemIsMovable, false);                 // 禁用移动
-                    textItem->setFlag(QGraphicsItem::ItemIsSelectable, true);               // 启用选择
-                    textItem->setFlag(QGraphicsRectItem::ItemSendsGeometryChanges, false);  // 禁用几何变更信号
-                    // 连接图形项位置变化信号
-                    if (connectItem->type() == ChartItem::Type)
-                    {
-                        connect(qgraphicsitem_cast<ChartItem*>(connectItem), &ChartItem::itemPositionHasChanged, textItem, &TextItem::parentPositionHasChanged);
-                    }
-                    else
-                    {
-                        connect(qgraphicsitem_cast<LineItem*>(connectItem), &LineItem::itemPositionHasChanged, textItem, &TextItem::parentPositionHasChanged);
-                    }
-                }
-            }
-
-        }
-
-        if (reader.hasError())
-        {
-            QMessageBox::warning(this, "错误", "解析剪贴板数据时出错: " + reader.errorString());
+            QMessageBox::warning(this, "错误", "解析剪贴板数据时出错: " + errorString);
         }
         view->operationStack->addOperation(new AppendOperation(appendItems, view)); // 添加元素操纵入栈
         view->graphicsScene->update();
@@ -1266,7 +1009,7 @@ void MainWindow::cutSelect()
           return;
     }
     // 获取当前的 QGraphicsViewRefactor 对象
-    View* refator = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* refator = currentView();
     if (refator != nullptr)
     {
         QList<QGraphicsItem*> selectedItems = refator->graphicsScene->selectedItems();
@@ -1278,7 +1021,7 @@ void MainWindow::cutSelect()
 
 void MainWindow::insertLine()
 {
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view)
     {
         view->graphicsScene->setMode(Mode::InsertLine);
@@ -1287,7 +1030,7 @@ void MainWindow::insertLine()
 
 void MainWindow::insertText()
 {
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view)
     {
         view->graphicsScene->setMode(Mode::InsertText); // 切换为插入文本模式
@@ -1296,16 +1039,65 @@ void MainWindow::insertText()
 
 void MainWindow::undo()
 {
-    View* view = sender()->parent()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view)
     {
         view->operationStack->undo();
     }
 }
 
+void MainWindow::autoLayout()
+{
+    if (ui->tabWidget->currentWidget() == nullptr)
+    {
+        return;
+    }
+    View* view = currentView();
+    if (view == nullptr)
+    {
+        return;
+    }
+    // 再次触发时停止搜索并保留目前最好的结果
+    Scene* scene = view->graphicsScene;
+    if (scene->isAutoLayoutRunning())
+    {
+        scene->stopAutoLayout();
+        return;
+    }
+    connect(scene, &Scene::layoutFinished, this, &MainWindow::autoLayoutFinished, Qt::UniqueConnection);
+    scene->startAutoLayout();
+    if (scene->isAutoLayoutRunning())
+    {
+        autoLayoutAction->setText(tr("停止布局"));
+    }
+}
+
+void MainWindow::autoLayoutFinished()
+{
+    autoLayoutAction->setText(tr("自动布局"));
+}
+
+void MainWindow::setOrthogonalRouting(bool enabled)
+{
+    QList<View*> views = ui->tabWidget->findChildren<View*>("graphicsView");
+    for (View* view : qAsConst(views))
+    {
+        view->graphicsScene->setEdgeRouting(enabled ? OrthogonalRouting : StraightRouting);
+    }
+}
+
+void MainWindow::setEdgeBundling(bool enabled)
+{
+    QList<View*> views = ui->tabWidget->findChildren<View*>("graphicsView");
+    for (View* view : qAsConst(views))
+    {
+        view->graphicsScene->setEdgeBundling(enabled);
+    }
+}
+
 void MainWindow::redo()
 {
-    View* view = sender()->parent()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view)
     {
         view->operationStack->redo();
@@ -1320,6 +1112,8 @@ void MainWindow::createMenus()
     fileMenu->addAction(openAction);
     fileMenu->addAction(saveAction);
     fileMenu->addAction(saveAsAction);
+    fileMenu->addAction(openProjectAction);
+    fileMenu->addAction(saveProjectAction);
     fileMenu->addAction(exitAction);
     fileMenu->addAction(bgAction);
     fileMenu->addAction(addAction);
@@ -1331,6 +1125,9 @@ void MainWindow::createMenus()
     editMenu->addAction(cutAction);
     editMenu->addAction(undoAction);
     editMenu->addAction(redoAction);
+    editMenu->addAction(autoLayoutAction);
+    editMenu->addAction(orthogonalRoutingAction);
+    editMenu->addAction(edgeBundlingAction);
 
     aboutMenu = menuBar()->addMenu(tr("帮助"));
     aboutMenu->setObjectName("aboutMenu");
@@ -1382,7 +1179,7 @@ void MainWindow::createToolBar()
     colorToolBar->setObjectName("colorToolButton");
 
 
-    QToolButton* fillColorToolButton = new QToolButton();                       // 创建填充颜色按钮
+    fillColorToolButton = new QToolButton();                                    // 创建填充颜色按钮
     fillColorToolButton->setText("填充颜色");
     fillColorToolButton->setPopupMode(QToolButton::MenuButtonPopup);
     QIcon fillColorIcon(":/image/paint.png");                                   // 设置图标
@@ -1390,6 +1187,30 @@ void MainWindow::createToolBar()
     fillColorToolButton->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);      // 设置图标在左侧，文本在右侧
     fillColorToolButton->setObjectName("fillColorToolButton");
 
+    borderColorToolButton = new QToolButton;                                    // 创建边框颜色按钮
+    borderColorToolButton->setText("边框颜色");
+    borderColorToolButton->setPopupMode(QToolButton::MenuButtonPopup);
+    QIcon borderColorIcon(":/image/paint line.png");                            // 设置图标
+    borderColorToolButton->setIcon(borderColorIcon);
+    borderColorToolButton->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);    // 设置图标在左侧，文本在右侧
+    borderColorToolButton->setObjectName("borderColorToolButton");
+
+    templateToolButton = new QToolButton;                                       // 创建模板按钮
+    templateToolButton->setText("模版");
+    templateToolButton->setPopupMode(QToolButton::MenuButtonPopup);
+    QIcon templateIcon(":/image/template.png");
+    templateToolButton->setIcon(templateIcon);
+    templateToolButton->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);    // 设置图标在左侧，文本在右侧
+    templateToolButton->setObjectName("templateToolButton");
+
+    // 按钮到工具栏上，菜单在第一帧之后由 createToolBarMenus 创建
+    colorToolBar->addWidget(fillColorToolButton);
+    colorToolBar->addWidget(borderColorToolButton);
+    colorToolBar->addWidget(templateToolButton);
+}
+
+void MainWindow::createToolBarMenus()
+{
     QMenu* colorMenu = new QMenu(fillColorToolButton);                          // 创建填充颜色菜单
     colorMenu->setObjectName("colorMenu");
     QAction* whiteAction = colorMenu->addAction(QIcon(":/path/to/white.png"), "白色");
@@ -1407,14 +1228,6 @@ void MainWindow::createToolBar()
     connect(greenAction, &QAction::triggered, this, &MainWindow::selectFillColor);
     connect(yellowAction, &QAction::triggered, this, &MainWindow::selectFillColor);
 
-
-    QToolButton *borderColorToolButton = new QToolButton;// 创建边框颜色按钮
-    borderColorToolButton->setText("边框颜色");
-    borderColorToolButton->setPopupMode(QToolButton::MenuButtonPopup);
-    QIcon borderColorIcon(":/image/paint line.png");                            // 设置图标
-    borderColorToolButton->setIcon(borderColorIcon);
-    borderColorToolButton->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);    // 设置图标在左侧，文本在右侧
-    borderColorToolButton->setObjectName("borderColorToolButton");
     QMenu* colorMenu2 = new QMenu(borderColorToolButton);                       // 创建边框颜色菜单
     colorMenu2->setObjectName("colorMenu2");
     QAction* redAction2 = colorMenu2->addAction(QIcon(":/image/red.png"), "红色");
@@ -1429,13 +1242,6 @@ void MainWindow::createToolBar()
     connect(blueAction2, &QAction::triggered, this, &MainWindow::selectBorderColor);
     connect(blackAction2, &QAction::triggered, this, &MainWindow::selectBorderColor);
 
-    QToolButton *templateToolButton = new QToolButton;// 创建模板按钮
-    templateToolButton->setText("模版");
-    templateToolButton->setPopupMode(QToolButton::MenuButtonPopup);
-    QIcon templateIcon(":/image/template.png");
-    templateToolButton->setIcon(templateIcon);
-    templateToolButton->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);    // 设置图标在左侧，文本在右侧
-    templateToolButton->setObjectName("templateToolButton");
     QMenu* templateMenu = new QMenu(templateToolButton);
     templateMenu->setObjectName("templateMenu");
     QAction *book = templateMenu->addAction("还书流程图");
@@ -1447,14 +1253,10 @@ void MainWindow::createToolBar()
     connect(book, &QAction::triggered, this, &MainWindow::selectBook);
     connect(decision, &QAction::triggered, this, &MainWindow::selectDecision);
     connect(pay, &QAction::triggered, this, &MainWindow::selectPay);
-    // 设置菜单到按钮上，按钮到工具栏上
+    // 设置菜单到按钮上
     borderColorToolButton->setMenu(colorMenu2);
     fillColorToolButton->setMenu(colorMenu);
-    // 设置菜单到按钮上
     templateToolButton->setMenu(templateMenu);
-    colorToolBar->addWidget(fillColorToolButton);
-    colorToolBar->addWidget(borderColorToolButton);
-    colorToolBar->addWidget(templateToolButton);
 }
 
 void MainWindow::selectBook()
@@ -1508,7 +1310,7 @@ void MainWindow::selectFillColor()
     QAction* action = qobject_cast<QAction*>(sender());
 
     // 获取图形视图
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view == nullptr)
     {
         return;
@@ -1570,7 +1372,7 @@ void MainWindow::selectBorderColor()
     QAction* action = qobject_cast<QAction*>(sender());
 
     // 获取图形视图
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view == nullptr)
     {
         return;
@@ -1629,7 +1431,7 @@ void MainWindow::setFont()
         return;
     }
 
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view != nullptr)
     {
         QList<QGraphicsItem*> items;
@@ -1679,7 +1481,7 @@ void MainWindow::setFontColor()
         return;
     }
 
-    View* view = ui->tabWidget->currentWidget()->findChild<View*>("graphicsView");
+    View* view = currentView();
     if (view != nullptr)
     {
         QList<QGraphicsItem*> textItems;
@@ -1713,6 +1515,7 @@ void MainWindow::setFontColor()
 
 void MainWindow::closeTab(int index)
 {
+    tabCache->removePage(ui->tabWidget->widget(index));
     ui->tabWidget->removeTab(index);
 }
 
@@ -8,6 +8,7 @@
 #include <QFontDialog>
 #include <QMenuBar>
 #include <QDoubleSpinBox>
+#include <QComboBox>
 #include <QColorDialog>
 
 #include "flowlayout.h"
@@ -15,6 +16,9 @@
 #include "view.h"
 #include "textitem.h"
 #include "pixmapitem.h"
+#include "tabcache.h"
+#include "iconcache.h"
+#include "startuptrace.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow;
@@ -30,18 +34,31 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    bool isStartupFinished() const { return startupFinished; }                          // 首帧后延迟创建的界面是否已完成
+
+protected:
+    bool event(QEvent* event) override;                                                 // 第一次绘制后安排延迟的初始化
+
 private:
     Ui::MainWindow *ui;
 
     void loadChartView();                                                               // 加载流程图图形视图
     void createActions();                                                               // 定义Action
     void createMenus();                                                                 // 创建菜单
-    void createToolBar();                                                               // 创建工具栏
-    int addTabWidgetPage(QString pageName);                                             // 添加单页
+    void createToolBar();                                                               // 创建工具栏，按钮的菜单在首帧后创建
+    void createToolBarMenus();                                                          // 创建颜色和模板菜单
+    int addTabWidgetPage(QString pageName, bool withView = true);                       // 添加单页，项目中的页面先不创建视图
+    View* createView(QWidget* page);                                                    // 在页面中创建视图，新建页面和重新加载页面时使用
+    View* currentView();                                                                // 当前页面的视图
+
+    TabCache* tabCache;                                                                 // 不活动页面的卸载和重新加载
+    QSharedPointer<ProjectFile> project;                                                // 最近打开或保存的项目文件
 
     QAction* openAction;                                                                // 打开XML文件
     QAction* saveAction;                                                                // 保存XML文件
     QAction* saveAsAction;                                                              // 另存为XML文件
+    QAction* openProjectAction;                                                         // 打开项目文件
+    QAction* saveProjectAction;                                                         // 保存项目文件
     QAction* newAction;                                                                 // 添加新页
     QAction* copyAction;                                                                // 复制
     QAction* pasteAction;                                                               // 粘贴
@@ -55,6 +72,16 @@ private:
     QAction* aboutAction;
     QAction* bgAction;
     QAction* addAction;
+    QAction* autoLayoutAction;                                                          // 自动布局
+    QAction* orthogonalRoutingAction;                                                   // 正交连线
+    QAction* edgeBundlingAction;                                                        // 捆绑连线
+
+    QToolButton* fillColorToolButton;                                                   // 填充颜色
+    QToolButton* borderColorToolButton;                                                 // 边框颜色
+    QToolButton* templateToolButton;                                                    // 模板
+    static const int startupFallbackMsecs = 1000;                                       // 一直没有绘制时延迟创建界面的超时
+    bool firstFrame = false;                                                            // 是否已绘制第一帧
+    bool startupFinished = false;
 
     QMenu* fileMenu;                                                                    // 文件菜单
     QMenu* editMenu;                                                                    // 编辑菜单
@@ -68,10 +95,15 @@ public slots:
     void openXMLFile();                                                                 // 打开XML文件
     void saveXMLFile();                                                                 // 保存文件为XML格式
     void saveAsXMLFile();                                                               // 文件另存为XML格式
+    void openProject();                                                                 // 选择并打开项目文件
+    void saveProject();                                                                 // 保存所有页面到项目文件
+    bool openProjectFile(const QString& filePath);                                      // 打开项目文件，每页在首次激活时读取
+    bool saveProjectFile(const QString& filePath);                                      // 保存项目文件，同一文件只写修改过的页面
     void createNewPage();                                                               // 创建新页
     void scaleValueChanged(double scaleMultiple);                                       // 缩放程度改变引发控件显示的值发生改变
     void searchText();                                                                  // 搜索指定的文本
     void replaceText();                                                                 // 替换指定的文本
+    void replaceAllText();                                                              // 替换所有匹配的文本
     void lastText();                                                                    // 上一个文本
     void nextText();                                                                    // 下一个文本
     void allText();                                                                     // 选中全部文本
@@ -85,6 +117,10 @@ public slots:
     void insertText();                                                                  // 插入文本
     void undo();                                                                        // 撤销
     void redo();                                                                        // 重做
+    void autoLayout();                                                                  // 开始或停止自动布局当前页
+    void autoLayoutFinished();                                                          // 自动布局结束，恢复菜单项
+    void setOrthogonalRouting(bool enabled);                                            // 所有页面切换正交连线
+    void setEdgeBundling(bool enabled);                                                 // 所有页面切换捆绑连线
     void selectFillColor();                                                             // 填充颜色选择
     void selectBorderColor();                                                           // 边框颜色选择
     void setFont();                                                                     // 设置字体
@@ -96,6 +132,9 @@ public slots:
     void selectBook();
     void selectDecision();
     void selectPay();
+
+private slots:
+    void finishStartup();                                                               // 创建首帧不需要的界面并输出启动时间线
 };
 
 #endif // MAINWINDOW_H
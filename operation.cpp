@@ -1,9 +1,6 @@
-#include "operation.h"
+﻿#include "operation.h"
 #include "view.h"
 
-Operation::Operation(QObject *parent) : QObject(parent)
-{}
-
 // 视图移动操作的构造函数
 ViewMoveOperation:: ViewMoveOperation(QPointF oldPosition, QPointF newPosition, QObject* parent)
    : Operation(parent), oldPosition(oldPosition), newPosition(newPosition)
@@ -160,11 +157,23 @@ MoveOperation::MoveOperation(QPointF startPosition, QPointF endPosition, QList<Q
     : Operation(parent), moveItems(items), startPosition(startPosition), endPosition(endPosition)
 {}
 
+MoveOperation::MoveOperation(QList<QGraphicsItem*> items, QList<QPointF> oldPositions, QList<QPointF> newPositions, QObject* parent)
+    : Operation(parent), moveItems(items), oldPositions(oldPositions), newPositions(newPositions)
+{}
+
 // 撤销移动操作
 void MoveOperation::undo() const
 {
     if (this->parent() != nullptr)
     {
+        if (!oldPositions.isEmpty())
+        {
+            for (int i = 0; i < moveItems.count(); ++i)
+            {
+                moveItems[i]->setPos(oldPositions[i]);
+            }
+            return;
+        }
         QPointF disPointF = endPosition - startPosition;
         for (QGraphicsItem* item : qAsConst(moveItems))
         {
@@ -189,6 +198,14 @@ void MoveOperation::redo() const
 {
     if (this->parent() != nullptr)
     {
+        if (!newPositions.isEmpty())
+        {
+            for (int i = 0; i < moveItems.count(); ++i)
+            {
+                moveItems[i]->setPos(newPositions[i]);
+            }
+            return;
+        }
         QPointF disPointF = endPosition - startPosition;
         for (QGraphicsItem* item : qAsConst(moveItems))
         {
@@ -256,7 +273,6 @@ void ColorOperation::undo() const
         ChartItem* chartItem = qgraphicsitem_cast<ChartItem*>(items[i]);
         chartItem->setCurrentFillColor(fillColors[i].first);
         chartItem->setCurrentBorderColor(borderColors[i].first);
-        chartItem->setSharedRenderer(chartItem->svgRender);
     }
 }
 
@@ -268,33 +284,28 @@ void ColorOperation::redo() const
         ChartItem* chartItem = qgraphicsitem_cast<ChartItem*>(items[i]);
         chartItem->setCurrentFillColor(fillColors[i].second);
         chartItem->setCurrentBorderColor(borderColors[i].second);
-        chartItem->setSharedRenderer(chartItem->svgRender);
     }
 }
 
 // 文本替换操作的构造函数
 ReplacceTextOperation::ReplacceTextOperation(QString oldText, QString newText, QList<QGraphicsItem*> changedItems, QObject* parent)
-    : Operation(parent),  oldText(oldText), newText(newText), changedItems(changedItems)
+    : Operation(parent), oldTexts(changedItems.size(), oldText), newTexts(changedItems.size(), newText), changedItems(changedItems)
+{}
+
+ReplacceTextOperation::ReplacceTextOperation(QVector<QString> oldTexts, QVector<QString> newTexts, QList<QGraphicsItem*> changedItems, QObject* parent)
+    : Operation(parent), oldTexts(oldTexts), newTexts(newTexts), changedItems(changedItems)
 {}
 
 // 撤销替换操作
 void ReplacceTextOperation::undo() const
 {
-    for (QGraphicsItem* item : changedItems)
-    {
-        TextItem* textItem = qgraphicsitem_cast<TextItem*>(item);
-        textItem->setPlainText(oldText);
-    }
+    Scene::setTexts(changedItems, oldTexts);                        // 整批设置后再统一重新定位
 }
 
 // 执行替换操作
 void ReplacceTextOperation::redo() const
 {
-    for (QGraphicsItem* item : changedItems)
-    {
-        TextItem* textItem = qgraphicsitem_cast<TextItem*>(item);
-        textItem->setPlainText(newText);
-    }
+    Scene::setTexts(changedItems, newTexts);
 }
 
 // 文本样式更改操作的构造函数
@@ -325,23 +336,21 @@ void ChangeFontOperation::redo() const
 }
 
 
-AppendBackgroundOperation::AppendBackgroundOperation(QBrush oldBackground, QBrush newBackground, QObject* parent)
-    : Operation(parent), oldBackground(oldBackground), newBackground(newBackground)
+AppendBackgroundOperation::AppendBackgroundOperation(QString oldImage, QSize oldSize, QString newImage, QSize newSize, QObject* parent)
+    : Operation(parent), oldImage(oldImage), oldSize(oldSize), newImage(newImage), newSize(newSize)
 {}
 
 void AppendBackgroundOperation::undo() const
 {
     View* view = qobject_cast<View*>(this->parent());
-    view->graphicsScene->setBackgroundBrush(oldBackground);
-    view->graphicsScene->update();
+    view->graphicsScene->setBackgroundImage(oldImage, oldSize);
     view->update();
 }
 
 void AppendBackgroundOperation::redo() const
 {
     View* view = qobject_cast<View*>(this->parent());
-    view->graphicsScene->setBackgroundBrush(newBackground);
-    view->graphicsScene->update();
+    view->graphicsScene->setBackgroundImage(newImage, newSize);
     view->update();
 }
 
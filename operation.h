@@ -7,16 +7,7 @@
 #include <QPointF>
 #include <QGraphicsItem>
 #include "textitem.h"
-// 基类
-class Operation : public QObject
-{
-    Q_OBJECT
-public:
-    explicit Operation(QObject* parent = nullptr);
-
-    virtual void undo() const = 0;  // 撤销操作
-    virtual void redo() const = 0;  // 重做操作
-};
+#include "operationstack.h"
 
 // 移动操作
 class ViewMoveOperation : public Operation
@@ -82,6 +73,8 @@ class MoveOperation : public Operation
     Q_OBJECT
 public:
     explicit MoveOperation(QPointF startPosition, QPointF endPosition, QList<QGraphicsItem*> items, QObject* parent = nullptr);
+    // 每个图形移动到各自的位置，用于自动布局
+    explicit MoveOperation(QList<QGraphicsItem*> items, QList<QPointF> oldPositions, QList<QPointF> newPositions, QObject* parent = nullptr);
 
     void undo() const override;
     void redo() const override;
@@ -90,6 +83,8 @@ private:
     QList<QGraphicsItem*> moveItems;
     QPointF startPosition;
     QPointF endPosition;
+    QList<QPointF> oldPositions;    // 各图形移动前的位置，为空时按统一的偏移移动
+    QList<QPointF> newPositions;    // 各图形移动后的位置
 };
 
 // 改变操作
@@ -129,13 +124,14 @@ class ReplacceTextOperation : public Operation
 {
 public:
     explicit ReplacceTextOperation(QString oldText, QString newText, QList<QGraphicsItem*> changedItems, QObject* parent = nullptr);
+    explicit ReplacceTextOperation(QVector<QString> oldTexts, QVector<QString> newTexts, QList<QGraphicsItem*> changedItems, QObject* parent = nullptr); // 每项各自的新旧文本
 
     void undo() const override;
     void redo() const override;
 
 private:
-    QString oldText;
-    QString newText;
+    QVector<QString> oldTexts;                                      // 与 changedItems 同下标，相同的文本共享数据
+    QVector<QString> newTexts;
     QList<QGraphicsItem*> changedItems;
 };
 
@@ -160,14 +156,16 @@ private:
 class AppendBackgroundOperation : public Operation
 {
 public:
-    explicit AppendBackgroundOperation(QBrush oldBackground, QBrush newBackground, QObject* parent = nullptr);
+    explicit AppendBackgroundOperation(QString oldImage, QSize oldSize, QString newImage, QSize newSize, QObject* parent = nullptr);
 
     void undo() const override;
     void redo() const override;
 
 private:
-    QBrush oldBackground;
-    QBrush newBackground;
+    QString oldImage;                                       // 图片在场景图片仓库中的哈希
+    QSize oldSize;
+    QString newImage;
+    QSize newSize;
 };
 
 // 改变图片大小操作
@@ -1,9 +1,44 @@
-#include "pixmapitem.h"
+﻿#include "pixmapitem.h"
 #include "view.h"
+#include "profiler.h"
+#include "imagestore.h"
+
+#include <QCoreApplication>
+#include <QUuid>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QStyleOptionGraphicsItem>
+
+namespace
+{
+    // 在线程池中运行一个函数
+    class PixmapJob : public QRunnable
+    {
+    public:
+        explicit PixmapJob(std::function<void()> work) : work(std::move(work)) {}
+        void run() override { work(); }
+
+    private:
+        std::function<void()> work;
+    };
+}
 
 PixmapItem::PixmapItem(const QPixmap& pixmap, QGraphicsItem* parent)
-    : QGraphicsPixmapItem(pixmap, parent), resizing(false),  resizeMode(None), originalPixmap(pixmap)
+    : QGraphicsPixmapItem(pixmap, parent), resizing(false),  resizeMode(None), originalImage(pixmap.toImage()), self(new PixmapItem*(this))
+{
+    init();
+}
+
+PixmapItem::PixmapItem(const QImage& image, QGraphicsItem* parent)
+    : QGraphicsPixmapItem(QPixmap::fromImage(image), parent), resizing(false),  resizeMode(None), originalImage(image), self(new PixmapItem*(this))
+{
+    init();
+}
+
+void PixmapItem::init()
 {
+    Uid = QUuid::createUuid().toString(QUuid::WithoutBraces);  // 生成唯一ID
+    size = originalImage.size();
     // 可移动、可选择、可聚焦，并且会在几何变化时发送信号
     setFlags(QGraphicsItem::ItemIsMovable | QGraphicsItem::ItemIsSelectable | QGraphicsItem::ItemIsFocusable | QGraphicsItem::ItemSendsGeometryChanges);
     setTransformationMode(Qt::SmoothTransformation);    // 平滑缩放和变换
@@ -11,6 +46,13 @@ PixmapItem::PixmapItem(const QPixmap& pixmap, QGraphicsItem* parent)
 
     oldRect = boundingRect();
     oldPos = pos();  // 记录初始位置
+    buildMipsAsync();
+}
+
+PixmapItem::~PixmapItem()
+{
+    *self = nullptr;                // 尚未完成的后台缩放结果到达时直接丢弃
+    Scene::removeItemIndex(this);   // 析构时不会收到场景变更事件
 }
 
 int PixmapItem::type() const
@@ -18,6 +60,44 @@ int PixmapItem::type() const
     return Type;
 }
 
+void PixmapItem::setImageSource(const QString& key, const QByteArray& encoded)
+{
+    this->key = key;
+    source = encoded;
+    nativeSize = ImageStore::imageSize(encoded);                // 只读取文件头
+}
+
+void PixmapItem::setDisplaySize(const QSizeF& size, qreal scale)
+{
+    prepareGeometryChange();
+    this->size = size;
+    renderScale = scale;
+    Scene::updateItemIndex(this);
+}
+
+QRectF PixmapItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), size);
+}
+
+QPainterPath PixmapItem::shape() const
+{
+    QPainterPath path;
+    path.addRect(boundingRect());
+    return path;
+}
+
+QSize PixmapItem::pixelSize() const
+{
+    QSize full = nativeSize.isValid() ? nativeSize : originalImage.size();
+    QSize wanted = (size * renderScale).toSize().expandedTo(QSize(1, 1));
+    if (wanted.width() > full.width() || wanted.height() > full.height())
+    {
+        return full;                                            // 显示得比原图大时由绘制拉伸，不再增加像素
+    }
+    return wanted;
+}
+
 void PixmapItem::mousePressEvent(QGraphicsSceneMouseEvent* event)
 {
     resizeMode = getResizeMode(event->pos());   // 设置缩放模式
@@ -59,7 +139,7 @@ void PixmapItem::mouseMoveEvent(QGraphicsSceneMouseEvent* event)
         // 确保矩形的长度和宽度不小于50
         if (newRect.width() >= 50 && newRect.height() >= 50)
         {
-            changeRect(newRect);
+            changeRect(newRect, true);
         }
         // 更新鼠标位置，便于下次更新鼠标移动的增量
         lastMousePos = event->scenePos();
@@ -70,10 +150,145 @@ void PixmapItem::mouseMoveEvent(QGraphicsSceneMouseEvent* event)
     }
 }
 
-void PixmapItem::changeRect(QRectF newRect)
+void PixmapItem::changeRect(QRectF newRect, bool interactive)
 {
+    QSizeF display = QSizeF(nativeSize.isValid() ? nativeSize : originalImage.size()).scaled(newRect.size(), Qt::KeepAspectRatio);
+    if (display.isEmpty())
+    {
+        return;
+    }
     prepareGeometryChange();
-    setPixmap(originalPixmap.scaled(newRect.size().toSize(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    size = display;
+    ++scaleGeneration;
+    QSize target = pixelSize();
+    // 从不小于目标大小的最近一级快速缩放，缩放倍数不超过2，不会每次都处理整张原图
+    QImage preview;
+    if (mips.isEmpty())
+    {
+        preview = originalImage.scaled(target, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+        smooth = target == originalImage.size();
+    }
+    else
+    {
+        preview = mips.scaled(target, Qt::FastTransformation);
+        smooth = mips.levelFor(target).size() == target;
+    }
+    setPixmap(QPixmap::fromImage(preview));
+    Scene::updateItemIndex(this);   // 尺寸变化后更新网格索引
+    if (!interactive && !smooth)
+    {
+        smoothScaleAsync();
+    }
+}
+
+void PixmapItem::runAsync(std::function<void()> work)
+{
+    QThreadPool::globalInstance()->start(new PixmapJob(std::move(work)));
+}
+
+void PixmapItem::buildMipsAsync()
+{
+    if (originalImage.isNull())
+    {
+        return;
+    }
+    QImage image = originalImage;                   // 隐式共享，不复制像素
+    QSharedPointer<PixmapItem*> token = self;
+    runAsync([image, token]()
+    {
+        MipPyramid pyramid(image);
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [token, pyramid]()
+        {
+            PixmapItem* item = *token;
+            if (item && pyramid.originalSize() == item->originalImage.size())   // 期间换成了更高分辨率的图像时丢弃
+            {
+                item->mips = pyramid;
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void PixmapItem::requestScale(qreal scale)
+{
+    // 只在明显不够清晰时才重新解码，缩小视图时保留已有的图像
+    if (resizing || scale <= renderScale * 1.25 || pixelSize() == (nativeSize.isValid() ? nativeSize : originalImage.size()))
+    {
+        return;
+    }
+    renderScale = scale;
+    ++scaleGeneration;
+    smooth = false;
+    smoothScaleAsync();
+}
+
+void PixmapItem::smoothScaleAsync()
+{
+    QSize target = pixelSize();
+    int generation = scaleGeneration;
+    QImage image = originalImage;
+    MipPyramid pyramid = mips;
+    // 放大到超过当前图像时，有压缩数据则按新的大小重新解码，而不是拉伸
+    QByteArray encoded = target.width() > image.width() || target.height() > image.height() ? source : QByteArray();
+    QSharedPointer<PixmapItem*> token = self;
+    runAsync([image, pyramid, encoded, target, generation, token]()
+    {
+        QImage decoded = ImageStore::decode(encoded, target);
+        QImage scaled;
+        if (!decoded.isNull())
+        {
+            scaled = decoded.size() == target ? decoded : decoded.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        }
+        else
+        {
+            scaled = pyramid.isEmpty() ? image.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                                       : pyramid.scaled(target, Qt::SmoothTransformation);
+        }
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [token, generation, scaled, decoded]()
+        {
+            PixmapItem* item = *token;
+            // 期间又改变了大小时由新的请求负责
+            if (item && item->scaleGeneration == generation)
+            {
+                item->setPixmap(QPixmap::fromImage(scaled));
+                item->smooth = true;
+                if (decoded.width() > item->originalImage.width())
+                {
+                    item->originalImage = decoded;      // 以更高分辨率的解码结果作为之后缩放的来源
+                    item->mips = MipPyramid();
+                    item->buildMipsAsync();
+                }
+            }
+        }, Qt::QueuedConnection);
+    });
+}
+
+void PixmapItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    PROFILE_PAINT(PixmapPaint);
+    qreal scale = option->levelOfDetailFromTransform(painter->worldTransform()) * (widget != nullptr ? widget->devicePixelRatioF() : 1);
+    requestScale(scale);
+    // 图片的像素数可能与显示大小不同，绘制时缩放到显示大小
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, transformationMode() == Qt::SmoothTransformation);
+    painter->drawPixmap(boundingRect(), pixmap(), QRectF(pixmap().rect()));
+    if (option->state & QStyle::State_Selected)
+    {
+        painter->setPen(QPen(Qt::black, 0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(boundingRect());
+    }
+}
+
+QVariant PixmapItem::itemChange(GraphicsItemChange change, const QVariant& value)
+{
+    if (change == QGraphicsItem::ItemSceneChange)
+    {
+        Scene::removeItemIndex(this);   // 从原场景的索引中移除
+    }
+    else if (change == QGraphicsItem::ItemSceneHasChanged || change == QGraphicsItem::ItemPositionHasChanged)
+    {
+        Scene::updateItemIndex(this);   // 更新网格索引
+    }
+    return QGraphicsPixmapItem::itemChange(change, value);
 }
 
 void PixmapItem::mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
@@ -82,6 +297,10 @@ void PixmapItem::mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
     {
         resizing = false;           // 取消缩放
         setCursor(Qt::ArrowCursor); // 恢复光标
+        if (!smooth)
+        {
+            smoothScaleAsync();     // 拖动中只做了快速缩放，松开后在后台平滑缩放
+        }
     }
     else
     {
@@ -90,7 +309,8 @@ void PixmapItem::mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
     // 大小不同时加入撤销重做栈
     if (oldRect != boundingRect())
     {
-        qobject_cast<View*>(this->scene()->parent())->operationStack->addOperation(new ChangeRectOperation(oldRect, boundingRect(), this));
+        qobject_cast<Scene*>(this->scene())->addOperation(new ChangeRectOperation(oldRect, boundingRect(), this));
+        oldRect = boundingRect();
     }
 }
 
@@ -5,16 +5,32 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QCursor>
 #include <QPainter>
+#include <QSharedPointer>
+#include <functional>
+
+#include "mippyramid.h"
 
 class PixmapItem : public QGraphicsPixmapItem
 {
 public:
     PixmapItem(const QPixmap& pixmap, QGraphicsItem* parent = nullptr);
+    PixmapItem(const QImage& image, QGraphicsItem* parent = nullptr);
+    ~PixmapItem() override;
 
     enum { Type = UserType + 5 };
 
     int type() const override;
-    void changeRect(QRectF newRect);                                    // 改变形状
+    QString Uid;                                                        // 唯一识别id
+    void setImageSource(const QString& key, const QByteArray& encoded); // 设置图片仓库中的哈希和压缩数据，放大时从中重新解码
+    QString imageKey() const { return key; }
+    const QImage& image() const { return originalImage; }               // 当前用于缩放的图像，可能小于原图
+    QSizeF getDisplaySize() const { return size; }
+    void setDisplaySize(const QSizeF& size, qreal scale = 1);           // 设置在场景中的大小，当前图片按 size*scale 像素解码
+    void changeRect(QRectF newRect, bool interactive = false);          // 改变形状，拖动中只做快速缩放，否则随后在后台平滑缩放
+    bool isSmooth() const { return smooth; }                            // 当前显示的是否为平滑缩放的结果
+    QRectF boundingRect() const override;                               // 显示大小，与图片的像素数无关
+    QPainterPath shape() const override;
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override; // 绘制图片，放大后分辨率不够时在后台重新解码
 protected:
     enum ResizeMode { None, TopLeft, TopRight, BottomLeft, BottomRight };
 
@@ -22,16 +38,32 @@ protected:
     void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override;      // 鼠标移动事件
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *event) override;   // 鼠标松开事件
     void hoverMoveEvent(QGraphicsSceneHoverEvent *event) override;      // 鼠标悬停事件
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value) override; // 图形更改事件
 
 private:
     bool resizing;                                                      // 是否可拖动和缩放
     ResizeMode resizeMode;                                              // 拖动模式
     QPointF lastMousePos;                                               // 鼠标上次出现的位置
-    QPixmap originalPixmap;                                             // 用于保存原始的高分辨率图像
+    QImage originalImage;                                               // 用于缩放的图像，有压缩数据时按显示大小解码
+    QString key;                                                        // 图片在仓库中的哈希，尚未登记时为空
+    QByteArray source;                                                  // 压缩的原图数据，与仓库共享
+    QSize nativeSize;                                                   // 原图大小，没有压缩数据时无效
+    QSizeF size;                                                        // 在场景中的显示大小
+    qreal renderScale = 1;                                              // 每单位显示大小需要的像素数，随视图放大而增加
+    MipPyramid mips;                                                    // 原图的各级缩小版本，在工作线程中生成，生成前为空
+    int scaleGeneration = 0;                                            // 每次改变大小加1，丢弃过时的平滑缩放结果
+    bool smooth = true;
+    QSharedPointer<PixmapItem*> self;                                   // 工作线程结果回到主线程时用于判断图形是否已析构
     QRectF oldRect;                                                     // 形状
     QPointF oldPos;
+    void init();
     ResizeMode getResizeMode(const QPointF &pos) const;                 // 获取拖动模式
     QRectF getResizeRect(ResizeMode mode) const;                        // 获取缩放矩形
+    QSize pixelSize() const;                                            // 按显示大小和 renderScale 需要的像素数，不超过原图
+    void requestScale(qreal scale);                                     // 放大后分辨率明显不够时按新的比例重新解码
+    void buildMipsAsync();                                              // 在全局线程池中生成 mips
+    void smoothScaleAsync();                                            // 在全局线程池中按当前大小平滑缩放
+    static void runAsync(std::function<void()> work);
 
     const int resizeHandleSize = 10;
 };
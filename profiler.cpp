@@ -0,0 +1,159 @@
+﻿#include "profiler.h"
+
+#ifdef FLOWCHARTS_PROFILING
+
+#include <QFile>
+#include <QTextStream>
+
+static const char* const paintKindNames[Profiler::PaintKindCount] = { "ChartItem", "LineItem", "TextItem", "PixmapItem" };
+
+Profiler::Profiler()
+{
+    clock.start();
+    frames.reserve(1024);
+}
+
+Profiler& Profiler::instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::beginFrame()
+{
+    if (frameDepth++ > 0)
+    {
+        return;
+    }
+    // 两帧之间（如鼠标事件中）的索引查询计入这一帧
+    current = Frame();
+    current.start = clock.nsecsElapsed();
+    current.indexQueries = pendingIndexQueries;
+    pendingIndexQueries = 0;
+}
+
+void Profiler::endFrame(int operations)
+{
+    if (frameDepth == 0 || --frameDepth > 0)
+    {
+        return;
+    }
+    current.duration = clock.nsecsElapsed() - current.start;
+    current.operations = operations;
+    last = current;
+    if (frames.size() >= maxFrames)
+    {
+        frames.remove(0, maxFrames / 2);    // 丢弃较早的一半
+    }
+    frames.append(current);
+}
+
+void Profiler::addPaint(PaintKind kind, qint64 nsecs)
+{
+    current.painted[kind]++;
+    current.paintCost[kind] += nsecs;
+}
+
+void Profiler::addIndexQuery()
+{
+    if (frameDepth > 0)
+    {
+        current.indexQueries++;
+    }
+    else
+    {
+        pendingIndexQueries++;
+    }
+}
+
+const Profiler::Frame& Profiler::lastFrame() const
+{
+    return last;
+}
+
+QString Profiler::overlayText() const
+{
+    int painted = 0;
+    for (int i = 0; i < PaintKindCount; ++i)
+    {
+        painted += last.painted[i];
+    }
+    QString text = QString("帧耗时: %1 ms\n绘制图形: %2\n").arg(last.duration / 1e6, 0, 'f', 2).arg(painted);
+    for (int i = 0; i < PaintKindCount; ++i)
+    {
+        text += QString("%1: %2 个 / %3 ms\n").arg(paintKindNames[i]).arg(last.painted[i]).arg(last.paintCost[i] / 1e6, 0, 'f', 2);
+    }
+    text += QString("索引查询: %1\n操作栈: %2").arg(last.indexQueries).arg(last.operations);
+    return text;
+}
+
+bool Profiler::exportCsv(const QString& fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+    QTextStream out(&file);
+    out << "frame,start_ms,frame_ms";
+    for (int i = 0; i < PaintKindCount; ++i)
+    {
+        out << ',' << paintKindNames[i] << "_count," << paintKindNames[i] << "_ms";
+    }
+    out << ",index_queries,operations\n";
+    for (int f = 0; f < frames.size(); ++f)
+    {
+        const Frame& frame = frames.at(f);
+        out << f << ',' << frame.start / 1e6 << ',' << frame.duration / 1e6;
+        for (int i = 0; i < PaintKindCount; ++i)
+        {
+            out << ',' << frame.painted[i] << ',' << frame.paintCost[i] / 1e6;
+        }
+        out << ',' << frame.indexQueries << ',' << frame.operations << '\n';
+    }
+    return true;
+}
+
+bool Profiler::exportChromeTrace(const QString& fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        return false;
+    }
+    // 每帧一个完整事件，各类图形的绘制耗时依次排在帧内；数量类数据作为计数器事件
+    QTextStream out(&file);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (const Frame& frame : frames)
+    {
+        qint64 ts = frame.start / 1000;
+        out << (first ? "" : ",") << "\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << ts
+            << ",\"dur\":" << frame.duration / 1000 << '}';
+        first = false;
+        qint64 offset = ts;
+        for (int i = 0; i < PaintKindCount; ++i)
+        {
+            if (frame.painted[i] == 0)
+            {
+                continue;
+            }
+            out << ",\n{\"name\":\"" << paintKindNames[i] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << offset
+                << ",\"dur\":" << frame.paintCost[i] / 1000 << ",\"args\":{\"count\":" << frame.painted[i] << "}}";
+            offset += frame.paintCost[i] / 1000;
+        }
+        out << ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"ts\":" << ts << ",\"args\":{\"index_queries\":"
+            << frame.indexQueries << ",\"operations\":" << frame.operations << "}}";
+    }
+    out << "\n]}\n";
+    return true;
+}
+
+void Profiler::clear()
+{
+    frames.clear();
+    last = Frame();
+    pendingIndexQueries = 0;
+}
+
+#endif // FLOWCHARTS_PROFILING
@@ -0,0 +1,78 @@
+﻿#ifndef PROFILER_H
+#define PROFILER_H
+
+// 性能计数器：统计每帧耗时、绘制的图形数量和各类图形的绘制开销
+// 只在定义了 FLOWCHARTS_PROFILING 时编译（调试版本），发布版本中下面的宏展开为空
+#ifdef FLOWCHARTS_PROFILING
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+class Profiler
+{
+public:
+    // 分别统计绘制开销的图形类型
+    enum PaintKind { ChartPaint, LinePaint, TextPaint, PixmapPaint, PaintKindCount };
+
+    // 一帧的统计数据
+    struct Frame
+    {
+        qint64 start = 0;                                   // 帧开始时间（纳秒，相对于计时器启动）
+        qint64 duration = 0;                                // 帧耗时（纳秒）
+        int painted[PaintKindCount] = {};                   // 各类图形绘制次数
+        qint64 paintCost[PaintKindCount] = {};              // 各类图形绘制耗时（纳秒）
+        int indexQueries = 0;                               // 场景索引查询次数
+        int operations = 0;                                 // 撤销栈与重做栈中的操作数
+    };
+
+    static Profiler& instance();
+
+    bool overlayVisible = false;                            // 是否显示性能浮层
+
+    void beginFrame();                                      // 开始一帧
+    void endFrame(int operations);                          // 结束一帧并记录
+    void addPaint(PaintKind kind, qint64 nsecs);            // 记录一次图形绘制
+    void addIndexQuery();                                   // 记录一次索引查询
+    const Frame& lastFrame() const;                         // 最近完成的一帧
+    QString overlayText() const;                            // 浮层显示的文本
+    bool exportCsv(const QString& fileName) const;          // 导出为CSV
+    bool exportChromeTrace(const QString& fileName) const;  // 导出为 Chrome trace（chrome://tracing 可打开）
+    void clear();                                           // 清空记录
+
+private:
+    Profiler();
+
+    static const int maxFrames = 10000;                     // 最多保留的帧数
+
+    QElapsedTimer clock;                                    // 计时器
+    Frame current;                                          // 当前帧
+    Frame last;                                             // 上一帧
+    QVector<Frame> frames;                                  // 已完成的帧
+    int frameDepth = 0;                                     // 嵌套的帧数，多个视图同时绘制时只统计最外层
+    int pendingIndexQueries = 0;                            // 两帧之间的索引查询，在下一帧开始时计入
+};
+
+// 统计作用域内的绘制耗时
+class PaintScope
+{
+public:
+    explicit PaintScope(Profiler::PaintKind kind) : kind(kind) { timer.start(); }
+    ~PaintScope() { Profiler::instance().addPaint(kind, timer.nsecsElapsed()); }
+
+private:
+    Profiler::PaintKind kind;
+    QElapsedTimer timer;
+};
+
+#define PROFILE_PAINT(kind) PaintScope profilePaintScope(Profiler::kind)
+#define PROFILE_INDEX_QUERY() Profiler::instance().addIndexQuery()
+
+#else
+
+#define PROFILE_PAINT(kind)
+#define PROFILE_INDEX_QUERY()
+
+#endif // FLOWCHARTS_PROFILING
+
+#endif // PROFILER_H
@@ -1,19 +1,38 @@
 ﻿#include "scene.h"
 #include "view.h"
+#include "profiler.h"
+
+#include <algorithm>
 
 Scene::Scene(QObject* parent)
     : QGraphicsScene(parent),
+      operationStack(nullptr),
+      currentIndex(0),
+      searchMode(LabelIndex::Exact),
       mode(NoMode),
       lineItem(nullptr),
       chartItem(nullptr),
       textItem(nullptr),
       pixmapItem(nullptr),
       isMove(false),
-      shiftIsClicked(false)
-{}
+      shiftIsClicked(false),
+      dragProxy(nullptr),
+      layoutPending(false),
+      indexMethod(BspTreeIndexing),
+      grid(256),
+      edgeRouting(StraightRouting),
+      edgeBundling(false),
+      bundlesDirty(false),
+      analysisPending(false),
+      layoutSearch(nullptr)
+{
+    connect(&router, &IncrementalRouter::routesChanged, this, &Scene::applyRoutes);
+    connect(&replacer, &TextReplacer::finished, this, &Scene::applyReplacement);
+}
 
 Scene::~Scene()
 {
+    delete layoutSearch;                                                // 等待后台布局的任务结束
     items().clear();
 }
 
@@ -94,6 +113,11 @@ void Scene::removeAllSelect(QList<QGraphicsItem *> items)
             case TextItem::Type :
             {
                 allTexts.removeAll(qgraphicsitem_cast<TextItem *>(item));          // 从关联文本列表中移除
+                if (qgraphicsitem_cast<TextItem *>(item)->connectItem != nullptr
+                    && qgraphicsitem_cast<TextItem *>(item)->connectItem->type() == LineItem::Type)
+                {
+                    invalidateBundles();                                            // 线不再带文本，可以参与捆绑
+                }
                 if (!removeTexts.contains(qgraphicsitem_cast<TextItem *>(item)))
                 {
                     removeTexts.append(qgraphicsitem_cast<TextItem *>(item));      // 添加到移除列表
@@ -124,7 +148,7 @@ void Scene::removeAllSelect(QList<QGraphicsItem *> items)
     }
 
     // 将删除操作记录到命令栈中，用于撤销操作
-    (qobject_cast<View*>(this->parent()))->operationStack->addOperation(new DeleteOperation(allMovedItems, this->parent()));
+    addOperation(new DeleteOperation(allMovedItems, this->parent()));
 }
 
 QList<TextItem*> Scene::getConnectText(QGraphicsItem* item)
@@ -198,7 +222,8 @@ void Scene::setMode(Mode mode)
         default:  // 默认模式
         {
             view->viewport()->setCursor(Qt::ArrowCursor);               // 设置光标为箭头
-            view->setDragMode(QGraphicsView::RubberBandDrag);           // 设置拖动模式为橡皮筋拖动
+            // 网格索引下由视图自己绘制橡皮筋并通过网格查询选中项
+            view->setDragMode(indexMethod == GridIndexing ? QGraphicsView::NoDrag : QGraphicsView::RubberBandDrag);
             break;
         }
     }
@@ -220,18 +245,14 @@ void Scene::doubleClickItem()
         }
         // 如果没有找到关联的文本项，则添加一个新的文本项
         TextItem* text = new TextItem();
-        text->setConnectItem(line);                                         // 设置关联文本
-        text->setFlag(QGraphicsItem::ItemIsMovable, false);                 // 禁用移动
-        text->setFlag(QGraphicsItem::ItemIsSelectable, true);               // 启用选择
-        text->setFlag(QGraphicsRectItem::ItemSendsGeometryChanges, false);  // 禁用几何变更信号
+        connectText(text, line);                                            // 设置关联文本并跟随线移动
         addItem(text);                                                      // 添加到场景中
-        connect(line, &LineItem::itemPositionHasChanged, text, &TextItem::parentPositionHasChanged);
         allTexts.append(text);                                              // 添加到关联文本列表
         text->setTextEditFlags(Qt::TextEditorInteraction);                  // 设置文本编辑标志
         text->setFocus();                                                   // 设置焦点
 
         // 将添加操作记录到命令栈中，用于撤销操作
-        (qobject_cast<View*>(this->parent()))->operationStack->addOperation(new AppendOperation(QList<QGraphicsItem*>() << text, this->parent()));
+        addOperation(new AppendOperation(QList<QGraphicsItem*>() << text, this->parent()));
     }
 }
 
@@ -266,16 +287,22 @@ void Scene::mousePressEvent(QGraphicsSceneMouseEvent* event)
             allTexts.append(textItem);  // 添加到文本列表
 
             // 将添加操作记录到命令栈中，用于撤销操作
-            (qobject_cast<View*>(this->parent()))->operationStack->addOperation(new AppendOperation(QList<QGraphicsItem*>() << textItem, this->parent()));
+            addOperation(new AppendOperation(QList<QGraphicsItem*>() << textItem, this->parent()));
             break;
         }
 
         case NoMode:                                                                        // 无模式
         {
-            QList<QGraphicsItem*> startItems = items(event->scenePos());                    // 获取鼠标按下位置的所有图形项
+            QList<QGraphicsItem*> startItems = diagramItems(event->scenePos());             // 获取鼠标按下位置的所有图形项
+            dragItems = selectedItems();                                                    // 整个拖动过程只取一次选中项
+            dragSelection.clear();
+            for (QGraphicsItem* item : qAsConst(dragItems))
+            {
+                dragSelection.insert(item);
+            }
             for (QGraphicsItem* item : qAsConst(startItems))
             {
-                if (item->type() == ChartItem::Type && selectedItems().contains(item))
+                if (item->type() == ChartItem::Type && dragSelection.contains(item))
                 {
                     chartItem = qgraphicsitem_cast<ChartItem*>(item);
                     startPosition = chartItem->pos();                                       // 记录起始位置
@@ -283,10 +310,10 @@ void Scene::mousePressEvent(QGraphicsSceneMouseEvent* event)
                     QRectF viewRect = qobject_cast<View*>(this->parent())->rect();          // 获取视图的矩形范围
                     QPointF leftTop = qobject_cast<View*>(this->parent())->mapToScene(int(viewRect.x()), int(viewRect.y()));
                     QPointF rightBottom = qobject_cast<View*>(this->parent())->mapToScene(int(viewRect.width()), int(viewRect.height()));
-                    QList<QGraphicsItem*> viewItems = items(QRectF(leftTop.x(), leftTop.y(), rightBottom.x() - leftTop.x(), rightBottom.y() - leftTop.y()));
+                    QList<QGraphicsItem*> viewItems = diagramItems(QRectF(leftTop.x(), leftTop.y(), rightBottom.x() - leftTop.x(), rightBottom.y() - leftTop.y()));
                     for (QGraphicsItem* rectItem : qAsConst(viewItems))
                     {
-                        if (rectItem->type() == ChartItem::Type && !selectedItems().contains(rectItem))
+                        if (rectItem->type() == ChartItem::Type && !dragSelection.contains(rectItem))
                         {
                             QRectF rects = rectItem->boundingRegion(rectItem->transform()).boundingRect();
                             QPen pen = QPen(QColor("#000000"), 0.5, Qt::DashLine);
@@ -320,15 +347,32 @@ void Scene::mousePressEvent(QGraphicsSceneMouseEvent* event)
                             horizontalLine.append(bottomLine);
                         }
                     }
+                    // 选中项过多时用一个轮廓代替它们跟随鼠标，松开时再统一移动
+                    if (dragItems.count() >= proxyDragThreshold)
+                    {
+                        QPainterPath outline;
+                        for (QGraphicsItem* dragItem : qAsConst(dragItems))
+                        {
+                            if (dragItem->flags() & QGraphicsItem::ItemIsMovable)
+                            {
+                                outline.addRect(dragItem->sceneBoundingRect());
+                            }
+                        }
+                        dragProxy = new QGraphicsPathItem(outline);
+                        dragProxy->setPen(QPen(QColor("#7596D7"), 1, Qt::DashLine));
+                        dragProxy->setZValue(100);
+                        addItem(dragProxy);
+                        endPosition = startPosition;
+                    }
                     break;
                 }
-                else if (item->type() == TextItem::Type && selectedItems().contains(item))
+                else if (item->type() == TextItem::Type && dragSelection.contains(item))
                 {
                     textItem = qgraphicsitem_cast<TextItem*>(item);
                     startPosition = textItem->pos();
                     isMove = true;
                 }
-                else if (item->type() == PixmapItem::Type && selectedItems().contains(item))
+                else if (item->type() == PixmapItem::Type && dragSelection.contains(item))
                 {
                     pixmapItem = qgraphicsitem_cast<PixmapItem*>(item);
                     startPosition = pixmapItem->pos();
@@ -349,72 +393,87 @@ void Scene::mouseMoveEvent(QGraphicsSceneMouseEvent *event)
         QLineF newLine(lineItem->line().p1(), event->scenePos());   // 更新连接线的位置
         lineItem->setLine(newLine);
     }
+    else if (mode == NoMode && isMove && chartItem != nullptr && dragProxy != nullptr)
+    {
+        // 只移动轮廓，不调用父类处理，选中的图形在松开鼠标时统一移动
+        QPointF position = startPosition + event->scenePos() - event->buttonDownScenePos(Qt::LeftButton);
+        endPosition = position + alignToGuides(position);
+        dragProxy->setPos(endPosition - startPosition);
+    }
     else
     {
         QGraphicsScene::mouseMoveEvent(event);                      // 调用父类的鼠标移动事件处理
         if (mode == NoMode && isMove && chartItem != nullptr)
         {
-            // 隐藏所有的辅助对齐线
-            for (QGraphicsLineItem* item : qAsConst(horizontalLine))
-            {
-                item->hide();
-            }
-            for (QGraphicsLineItem* item : qAsConst(verticalLine))
-            {
-                item->hide();
-            }
-            // 获取临近的对齐线并显示
-            QRectF chartRect = chartItem->boundingRegion(chartItem->transform()).boundingRect();
-            QPointF center = chartItem->pos() + QPoint(int(chartRect.width() / 2), int(chartRect.height() / 2));
-            double horizontalDistance = 11;  // 左右对齐线的距离差
-            for (QGraphicsLineItem* item : qAsConst(verticalLine))
+            QPointF offset = alignToGuides(chartItem->pos());
+
+            // 更新图形项的位置
+            endPosition = chartItem->pos();
+            if (!offset.isNull())
             {
-                double dis = qAbs(center.x() - item->line().p1().x()) - chartRect.width() / 2;
-                if (dis >= 0 && dis <= 10 && distance(item->data(Qt::UserRole + 1).toPointF(), center) < chartRect.width() / 2 + 200)
+                for (QGraphicsItem* item : qAsConst(dragItems))
                 {
-                    item->show();
-                    if (dis < qAbs(horizontalDistance))
+                    if (item->type() == LineItem::Type)
                     {
-                        horizontalDistance = (center.x() >= item->line().p1().x() ? -1 : 1) * dis;
+                        continue;
                     }
+                    item->setPos(item->pos() + offset);
                 }
             }
+        }
+    }
+}
 
-            double verticallDistance = 11;  // 上下对齐线的距离差
-            for (QGraphicsLineItem* item : qAsConst(horizontalLine))
+QPointF Scene::alignToGuides(QPointF position)
+{
+    // 隐藏所有的辅助对齐线
+    for (QGraphicsLineItem* item : qAsConst(horizontalLine))
+    {
+        item->hide();
+    }
+    for (QGraphicsLineItem* item : qAsConst(verticalLine))
+    {
+        item->hide();
+    }
+    // 获取临近的对齐线并显示
+    QRectF chartRect = chartItem->boundingRegion(chartItem->transform()).boundingRect();
+    QPointF center = position + QPoint(int(chartRect.width() / 2), int(chartRect.height() / 2));
+    double horizontalDistance = 11;  // 左右对齐线的距离差
+    for (QGraphicsLineItem* item : qAsConst(verticalLine))
+    {
+        double dis = qAbs(center.x() - item->line().p1().x()) - chartRect.width() / 2;
+        if (dis >= 0 && dis <= 10 && distance(item->data(Qt::UserRole + 1).toPointF(), center) < chartRect.width() / 2 + 200)
+        {
+            item->show();
+            if (dis < qAbs(horizontalDistance))
             {
-                double dis = qAbs(center.y() - item->line().p1().y()) - chartRect.height() / 2;
-                if (dis >= 0 && dis <= 10 && distance(item->data(Qt::UserRole + 1).toPointF(), center) < chartRect.width() / 2 + 200)
-                {
-                    item->show();
-                    if (dis < qAbs(verticallDistance))
-                    {
-                        verticallDistance = (center.y() >= item->line().p1().y() ? -1 : 1) * dis;
-                    }
-                }
+                horizontalDistance = (center.x() >= item->line().p1().x() ? -1 : 1) * dis;
             }
+        }
+    }
 
-            // 更新图形项的位置
-            endPosition = chartItem->pos();
-            QList<QGraphicsItem*> selectLists = selectedItems();
-            for (QGraphicsItem* item : qAsConst(selectLists))
+    double verticallDistance = 11;  // 上下对齐线的距离差
+    for (QGraphicsLineItem* item : qAsConst(horizontalLine))
+    {
+        double dis = qAbs(center.y() - item->line().p1().y()) - chartRect.height() / 2;
+        if (dis >= 0 && dis <= 10 && distance(item->data(Qt::UserRole + 1).toPointF(), center) < chartRect.width() / 2 + 200)
+        {
+            item->show();
+            if (dis < qAbs(verticallDistance))
             {
-                if (item->type() == LineItem::Type)
-                {
-                    continue;
-                }
-                item->setPos(item->pos().x() + (horizontalDistance <= 10 ? horizontalDistance : 0), item->pos().y() + (verticallDistance <= 10 ? verticallDistance : 0));
+                verticallDistance = (center.y() >= item->line().p1().y() ? -1 : 1) * dis;
             }
         }
     }
+    return QPointF(horizontalDistance <= 10 ? horizontalDistance : 0, verticallDistance <= 10 ? verticallDistance : 0);
 }
 
 void Scene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
 {
     if (lineItem != nullptr && mode == InsertLine)
     {
-        QList<QGraphicsItem *> startItems = items(lineItem->line().p1());
-        QList<QGraphicsItem *> endItems = items(lineItem->line().p2());
+        QList<QGraphicsItem *> startItems = diagramItems(lineItem->line().p1());
+        QList<QGraphicsItem *> endItems = diagramItems(lineItem->line().p2());
         // 在起始的图形标记线的起始点
         ChartItem* startItem = nullptr;
         for (QGraphicsItem *topItem : startItems)
@@ -444,7 +503,7 @@ void Scene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
             connect(line, &LineItem::doubleClickItem, this, &Scene::doubleClickItem);
 
             // 将添加操作记录到命令栈中，用于撤销操作
-            (qobject_cast<View*>(this->parent()))->operationStack->addOperation(new AppendOperation(QList<QGraphicsItem*>() << line, this->parent()));
+            addOperation(new AppendOperation(QList<QGraphicsItem*>() << line, this->parent()));
         }
         // // 清空线条
         removeItem(lineItem);
@@ -463,6 +522,21 @@ void Scene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
     {
         if (chartItem)
         {
+            if (dragProxy != nullptr)
+            {
+                // 一次性提交轮廓的位移
+                removeItem(dragProxy);
+                delete dragProxy;
+                dragProxy = nullptr;
+                QPointF disPointF = endPosition - startPosition;
+                for (QGraphicsItem* item : qAsConst(dragItems))
+                {
+                    if (item->flags() & QGraphicsItem::ItemIsMovable)
+                    {
+                        item->setPos(item->pos() + disPointF);
+                    }
+                }
+            }
             endPosition = chartItem->pos();
             isMove = false;
             chartItem = nullptr;
@@ -493,8 +567,10 @@ void Scene::mouseReleaseEvent(QGraphicsSceneMouseEvent *event)
         // 起始位置不同则记录
         if (!(startPosition == event->scenePos() || startPosition == endPosition))
         {
-            (qobject_cast<View*>(this->parent()))->operationStack->addOperation(new MoveOperation(startPosition, endPosition, selectedItems(), this->parent()));
+            addOperation(new MoveOperation(startPosition, endPosition, dragItems, this->parent()));
         }
+        dragItems.clear();
+        dragSelection.clear();
     }
 
     QGraphicsScene::mouseReleaseEvent(event);
@@ -548,6 +624,8 @@ void Scene::clearAllItems()
     // 清空 `allTexts` 和 `allLines` 列表
     allTexts.clear();
     allLines.clear();
+    bundleItems.clear();                                                // 捆绑路径随其他图形项一起销毁
+    bundledLines.clear();
 
     // 获取场景中的所有图形项
     QList<QGraphicsItem*> allItems = items();
@@ -559,3 +637,944 @@ void Scene::clearAllItems()
         delete item;  // 删除图形项以释放内存
     }
 }
+
+void Scene::markLayoutDirty(ChartItem* item)
+{
+    if (item->layoutDirty)
+    {
+        return;
+    }
+    item->layoutDirty = true;
+    dirtyCharts.append(item);
+    if (!layoutPending)
+    {
+        layoutPending = true;
+        // 排队到事件循环，在本帧重绘之前执行一次
+        QMetaObject::invokeMethod(this, "flushLayout", Qt::QueuedConnection);
+    }
+}
+
+void Scene::flushLayout()
+{
+    layoutPending = false;
+    QList<QPointer<ChartItem>> charts;
+    charts.swap(dirtyCharts);
+    for (const QPointer<ChartItem>& chart : charts)
+    {
+        if (chart.isNull())
+        {
+            continue;       // 图形已被删除
+        }
+        chart->layoutDirty = false;
+        emit chart->itemPositionHasChanged();   // 关联的文本与线各更新一次
+    }
+    if (bundlesDirty)
+    {
+        rebuildBundles();                       // 线都更新后再重建一次
+    }
+}
+
+IndexMethod Scene::getIndexMethod() const
+{
+    return indexMethod;
+}
+
+void Scene::setIndexMethod(IndexMethod method)
+{
+    if (method == indexMethod)
+    {
+        return;
+    }
+    indexMethod = method;
+    grid.clear();
+    if (method == BspTreeIndexing)
+    {
+        setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+    }
+    else
+    {
+        setItemIndexMethod(QGraphicsScene::NoIndex);                    // 网格模式下不再维护BSP树
+    }
+    if (method == GridIndexing)
+    {
+        QList<QGraphicsItem*> allItems = items(Qt::AscendingOrder);   // 按堆叠顺序登记，保持上下关系
+        for (QGraphicsItem* item : qAsConst(allItems))
+        {
+            updateItemIndex(item);
+        }
+    }
+    QGraphicsView* view = dynamic_cast<QGraphicsView*>(this->parent());
+    if (view != nullptr && mode != InsertLine && mode != InsertText)
+    {
+        view->setDragMode(method == GridIndexing ? QGraphicsView::NoDrag : QGraphicsView::RubberBandDrag);
+    }
+}
+
+QList<QGraphicsItem*> Scene::diagramItems(const QPointF& position)
+{
+    PROFILE_INDEX_QUERY();
+    if (indexMethod != GridIndexing)
+    {
+        return items(position);
+    }
+    QList<QGraphicsItem*> result;
+    QList<QGraphicsItem*> candidates = grid.query(position);
+    for (QGraphicsItem* item : qAsConst(candidates))
+    {
+        if (item->isVisible() && item->contains(item->mapFromScene(position)))
+        {
+            result.append(item);
+        }
+    }
+    sortByStacking(result);
+    return result;
+}
+
+QList<QGraphicsItem*> Scene::diagramItems(const QRectF& rect, Qt::ItemSelectionMode selectionMode)
+{
+    PROFILE_INDEX_QUERY();
+    if (indexMethod != GridIndexing)
+    {
+        return items(rect, selectionMode);
+    }
+    QPainterPath path;
+    path.addRect(rect);
+    QList<QGraphicsItem*> result;
+    QList<QGraphicsItem*> candidates = grid.query(rect);
+    for (QGraphicsItem* item : qAsConst(candidates))
+    {
+        if (item->isVisible() && item->collidesWithPath(item->mapFromScene(path), selectionMode))
+        {
+            result.append(item);
+        }
+    }
+    sortByStacking(result);
+    return result;
+}
+
+void Scene::selectItemsInRect(const QRectF& rect)
+{
+    QList<QGraphicsItem*> hits = diagramItems(rect, Qt::IntersectsItemShape);
+    QSet<QGraphicsItem*> hitSet;
+    for (QGraphicsItem* item : qAsConst(hits))
+    {
+        hitSet.insert(item);
+    }
+    QList<QGraphicsItem*> selected = selectedItems();
+    for (QGraphicsItem* item : qAsConst(selected))
+    {
+        if (!hitSet.contains(item))
+        {
+            item->setSelected(false);
+        }
+    }
+    for (QGraphicsItem* item : qAsConst(hits))
+    {
+        if (item->flags() & QGraphicsItem::ItemIsSelectable)
+        {
+            item->setSelected(true);
+        }
+    }
+}
+
+void Scene::updateItemIndex(QGraphicsItem* item)
+{
+    Scene* scene = qobject_cast<Scene*>(item->scene());
+    if (scene == nullptr || item->parentItem() != nullptr)
+    {
+        return;
+    }
+    int type = item->type();
+    if (type == ChartItem::Type && scene->edgeRouting == OrthogonalRouting)
+    {
+        scene->router.setObstacle(quintptr(item), item->sceneBoundingRect());   // 图形是连线的障碍物
+    }
+    if (scene->indexMethod != GridIndexing)
+    {
+        return;
+    }
+    // 只登记流程图的图形项，辅助线和按钮等不参与查询
+    if (type != ChartItem::Type && type != LineItem::Type && type != TextItem::Type && type != PixmapItem::Type)
+    {
+        return;
+    }
+    scene->grid.insert(item, item->sceneBoundingRect());
+}
+
+void Scene::removeItemIndex(QGraphicsItem* item)
+{
+    Scene* scene = qobject_cast<Scene*>(item->scene());
+    if (scene == nullptr)
+    {
+        return;
+    }
+    if (item->type() == ChartItem::Type)
+    {
+        scene->router.removeObstacle(quintptr(item));
+        scene->graph.removeNode(quintptr(item));
+        scene->scheduleAnalysis();
+    }
+    else if (item->type() == LineItem::Type)
+    {
+        scene->router.removeRoute(quintptr(item));                     // 之后不会再收到这条线的结果
+        scene->invalidateBundles();
+        scene->graph.removeEdge(quintptr(item));
+        scene->scheduleAnalysis();
+    }
+    else if (item->type() == TextItem::Type)
+    {
+        scene->labels.removeLabel(quintptr(item));
+    }
+    if (scene->indexMethod == GridIndexing)
+    {
+        scene->grid.remove(item);
+    }
+}
+
+void Scene::updateGraphItem(QGraphicsItem* item)
+{
+    Scene* scene = qobject_cast<Scene*>(item->scene());
+    if (scene == nullptr)
+    {
+        return;
+    }
+    if (item->type() == ChartItem::Type)
+    {
+        scene->graph.setNode(quintptr(item), static_cast<int>(qgraphicsitem_cast<ChartItem*>(item)->getChartType()));
+    }
+    else if (item->type() == LineItem::Type)
+    {
+        // 键统一取 QGraphicsItem 指针
+        LineItem* line = qgraphicsitem_cast<LineItem*>(item);
+        QGraphicsItem* startItem = line->startItem;
+        QGraphicsItem* endItem = line->endItem;
+        scene->graph.setEdge(quintptr(item), quintptr(startItem), quintptr(endItem));
+    }
+    scene->scheduleAnalysis();
+}
+
+void Scene::updateLabelIndex(TextItem* item)
+{
+    Scene* scene = qobject_cast<Scene*>(item->scene());
+    if (scene == nullptr)
+    {
+        return;
+    }
+    // 内容未变时只是一次查表，可以在每次设置文本时调用
+    scene->labels.setLabel(quintptr(static_cast<QGraphicsItem*>(item)), item->toPlainText());
+}
+
+void Scene::scheduleAnalysis()
+{
+    if (!analysisPending && graph.isDirty())
+    {
+        analysisPending = true;
+        QMetaObject::invokeMethod(this, "analyzeGraph", Qt::QueuedConnection);  // 同一帧内的多次修改合并为一次检查
+    }
+}
+
+void Scene::analyzeGraph()
+{
+    analysisPending = false;
+    QList<quintptr> changed = graph.analyze();
+    for (quintptr key : qAsConst(changed))
+    {
+        // 删除的图形已从检查中移除，不会出现在结果中
+        qgraphicsitem_cast<ChartItem*>(reinterpret_cast<QGraphicsItem*>(key))->setWarnings(graph.warnings(key));
+    }
+}
+
+EdgeRouting Scene::getEdgeRouting() const
+{
+    return edgeRouting;
+}
+
+void Scene::setEdgeRouting(EdgeRouting routing)
+{
+    if (routing == edgeRouting)
+    {
+        return;
+    }
+    edgeRouting = routing;
+    router.clear();
+    QList<QGraphicsItem*> allItems = items();
+    QList<LineItem*> lines;
+    for (QGraphicsItem* item : qAsConst(allItems))
+    {
+        if (item->type() == ChartItem::Type)
+        {
+            updateItemIndex(item);
+        }
+        else if (item->type() == LineItem::Type)
+        {
+            lines.append(qgraphicsitem_cast<LineItem*>(item));
+        }
+    }
+    // 障碍物全部登记后再布线
+    for (LineItem* line : qAsConst(lines))
+    {
+        line->updatePosition();
+    }
+    rebuildBundles();                                                   // 正交布线时不捆绑
+}
+
+QPolygonF Scene::routeEdge(LineItem* line)
+{
+    // 键统一取 QGraphicsItem 指针，与登记障碍物时一致
+    QGraphicsItem* startItem = line->startItem;
+    QGraphicsItem* endItem = line->endItem;
+    return router.route(quintptr(static_cast<QGraphicsItem*>(line)), startItem->sceneBoundingRect(), endItem->sceneBoundingRect(),
+                        quintptr(startItem), quintptr(endItem));
+}
+
+void Scene::applyRoutes(const QList<quintptr>& edges)
+{
+    for (quintptr edge : edges)
+    {
+        // 线离开场景或析构时会移除缓存的折线，有结果的线一定仍在场景中
+        qgraphicsitem_cast<LineItem*>(reinterpret_cast<QGraphicsItem*>(edge))->updatePosition();
+    }
+}
+
+bool Scene::isEdgeBundling() const
+{
+    return edgeBundling;
+}
+
+void Scene::setEdgeBundling(bool enabled)
+{
+    if (enabled == edgeBundling)
+    {
+        return;
+    }
+    edgeBundling = enabled;
+    rebuildBundles();
+}
+
+void Scene::invalidateBundles()
+{
+    if (!edgeBundling || bundlesDirty)
+    {
+        return;
+    }
+    bundlesDirty = true;
+    if (!layoutPending)
+    {
+        layoutPending = true;
+        QMetaObject::invokeMethod(this, "flushLayout", Qt::QueuedConnection);
+    }
+}
+
+void Scene::rebuildBundles()
+{
+    bundlesDirty = false;
+    for (const QPointer<LineItem>& line : qAsConst(bundledLines))
+    {
+        if (line)
+        {
+            line->setBundled(false);
+        }
+    }
+    bundledLines.clear();
+    qDeleteAll(bundleItems);
+    bundleItems.clear();
+    // 正交布线时捆绑路径会穿过图形，不捆绑
+    if (!edgeBundling || edgeRouting == OrthogonalRouting)
+    {
+        return;
+    }
+
+    // 带文本的线保持原样，文本仍位于线的中点
+    QSet<QGraphicsItem*> labelledLines;
+    for (TextItem* text : qAsConst(allTexts))
+    {
+        if (text->scene() == this && text->connectItem != nullptr && text->connectItem->type() == LineItem::Type)
+        {
+            labelledLines.insert(text->connectItem);
+        }
+    }
+
+    // 图形按线的颜色分别登记，只有颜色相同的入边才捆绑在一起
+    QHash<QPair<ChartItem*, QRgb>, int> nodeIndex;
+    QVector<QRectF> bounds;
+    QVector<int> starts;
+    QVector<int> ends;
+    QList<LineItem*> lines;
+    auto indexOf = [&](ChartItem* chart, QRgb color) {
+        QPair<ChartItem*, QRgb> key(chart, color);
+        QHash<QPair<ChartItem*, QRgb>, int>::const_iterator it = nodeIndex.constFind(key);
+        if (it != nodeIndex.constEnd())
+        {
+            return it.value();
+        }
+        bounds.append(chart->sceneBoundingRect());
+        return nodeIndex.insert(key, bounds.size() - 1).value();
+    };
+    for (LineItem* line : qAsConst(allLines))
+    {
+        if (line->scene() != this || labelledLines.contains(line))
+        {
+            continue;
+        }
+        starts.append(indexOf(line->startItem, line->color.rgba()));
+        ends.append(indexOf(line->endItem, line->color.rgba()));
+        lines.append(line);
+    }
+
+    QVector<EdgeBundler::Bundle> bundles = EdgeBundler::bundle(bounds, starts, ends);
+    for (const EdgeBundler::Bundle& bundle : qAsConst(bundles))
+    {
+        QColor color = lines.at(bundle.edges.first())->color;
+        QGraphicsPathItem* item = new QGraphicsPathItem(bundle.path);
+        item->setPen(QPen(color, 2));
+        item->setBrush(color);                                          // 只填充箭头，线段不围出面积
+        item->setZValue(98);                                            // 在线之下
+        addItem(item);
+        bundleItems.append(item);
+        for (int edge : bundle.edges)
+        {
+            lines.at(edge)->setBundled(true);
+            bundledLines.append(lines.at(edge));
+        }
+    }
+}
+
+void Scene::sortByStacking(QList<QGraphicsItem*>& items) const
+{
+    // Z值相同时与QGraphicsScene一致，后加入场景的在上面
+    std::sort(items.begin(), items.end(), [this](QGraphicsItem* a, QGraphicsItem* b) {
+        if (a->zValue() != b->zValue())
+        {
+            return a->zValue() > b->zValue();
+        }
+        return grid.sequence(a) > grid.sequence(b);
+    });
+}
+
+void Scene::connectText(TextItem* textItem, QGraphicsItem* item)
+{
+    textItem->setConnectItem(item);
+    // 设置文本项的属性
+    textItem->setFlag(QGraphicsItem::ItemIsMovable, false);                 // 禁用移动
+    textItem->setFlag(QGraphicsItem::ItemIsSelectable, true);               // 启用选择
+    textItem->setFlag(QGraphicsRectItem::ItemSendsGeometryChanges, false);  // 禁用几何变更信号
+    // 连接图形项位置变化信号
+    if (item->type() == ChartItem::Type)
+    {
+        connect(qgraphicsitem_cast<ChartItem*>(item), &ChartItem::itemPositionHasChanged, textItem, &TextItem::parentPositionHasChanged);
+    }
+    else
+    {
+        connect(qgraphicsitem_cast<LineItem*>(item), &LineItem::itemPositionHasChanged, textItem, &TextItem::parentPositionHasChanged);
+        invalidateBundles();                                            // 带文本的线不参与捆绑
+    }
+}
+
+DiagramModel Scene::toModel(const QList<QGraphicsItem*>& items)
+{
+    flushLayout();      // 转换前确保文本和线的位置是最新的
+    if (edgeRouting == OrthogonalRouting)
+    {
+        router.waitForDone();                           // 等待后台布线，保存的线段与显示一致
+    }
+    DiagramModel model;
+    QHash<QGraphicsItem*, int> nodeIndex;               // 图形在模型中的下标
+    QHash<QGraphicsItem*, int> edgeIndex;               // 连线在模型中的下标
+    QList<LineItem*> lineItems;
+    QList<TextItem*> textItems;
+    model.reserve(items.size(), 0, 0);
+
+    for (QGraphicsItem* item : qAsConst(items))
+    {
+        switch (item->type())
+        {
+            case ChartItem::Type :
+            {
+                ChartItem* chartItem = qgraphicsitem_cast<ChartItem*>(item);
+                nodeIndex.insert(item, model.addNode(chartItem->Uid, static_cast<int>(chartItem->getChartType()), chartItem->pos(),
+                                                     chartItem->transform(), chartItem->getStyle()));
+                break;
+            }
+            case LineItem::Type :
+                lineItems.append(qgraphicsitem_cast<LineItem*>(item));
+                break;
+            case TextItem::Type :
+                textItems.append(qgraphicsitem_cast<TextItem*>(item));
+                break;
+            case PixmapItem::Type :
+            {
+                // 没有登记到仓库的图片（例如由 QPixmap 直接创建）先编码保存
+                PixmapItem* pixmapItem = qgraphicsitem_cast<PixmapItem*>(item);
+                if (pixmapItem->imageKey().isEmpty() || !images.contains(pixmapItem->imageKey()))
+                {
+                    QString key = images.insert(pixmapItem->image());
+                    pixmapItem->setImageSource(key, images.data(key));
+                }
+                if (!pixmapItem->imageKey().isEmpty())
+                {
+                    model.addPicture(pixmapItem->Uid, pixmapItem->imageKey(), pixmapItem->pos(), pixmapItem->getDisplaySize().toSize());
+                    model.images.insert(pixmapItem->imageKey(), images.data(pixmapItem->imageKey()));
+                }
+                break;
+            }
+        }
+    }
+    if (!backgroundImage.isEmpty())
+    {
+        model.backgroundImage = backgroundImage;
+        model.backgroundSize = backgroundSize;
+        model.images.insert(backgroundImage, images.data(backgroundImage));
+    }
+
+    // 只保留两端图形都在模型中的连线
+    for (LineItem* lineItem : qAsConst(lineItems))
+    {
+        int start = nodeIndex.value(lineItem->startItem, -1);
+        int end = nodeIndex.value(lineItem->endItem, -1);
+        if (start >= 0 && end >= 0)
+        {
+            edgeIndex.insert(lineItem, model.addEdge(lineItem->Uid, start, end, lineItem->line(), lineItem->color.rgb()));
+        }
+    }
+
+    for (TextItem* textItem : qAsConst(textItems))
+    {
+        // 检查关联图形
+        DiagramModel::LabelOwner owner = DiagramModel::NoOwner;
+        int ownerIndex = nodeIndex.value(textItem->connectItem, -1);
+        if (ownerIndex >= 0)
+        {
+            owner = DiagramModel::NodeOwner;
+        }
+        else if ((ownerIndex = edgeIndex.value(textItem->connectItem, -1)) >= 0)
+        {
+            owner = DiagramModel::EdgeOwner;
+        }
+        model.addLabel(textItem->Uid, textItem->text, textItem->pos(), textItem->font(), textItem->defaultTextColor().rgb(),
+                       textItem->transform(), owner, ownerIndex);
+    }
+    return model;
+}
+
+QList<QGraphicsItem*> Scene::addModel(const DiagramModel& model)
+{
+    QList<QGraphicsItem*> appendItems;
+    QVector<ChartItem*> chartItems(model.nodeCount());
+    QVector<LineItem*> lineItems(model.edgeCount());
+    appendItems.reserve(model.nodeCount() + model.edgeCount() + model.labelCount());
+
+    for (int i = 0; i < model.nodeCount(); ++i)
+    {
+        ChartItem* chartItem = new ChartItem(static_cast<FlowEnumItem>(model.nodeTypes.at(i)));
+        chartItem->Uid = model.nodeUids.at(i);
+        chartItem->setTransform(model.nodeTransforms.at(i));
+        chartItem->setPos(model.nodePositions.at(i));
+        chartItem->setStyle(model.nodeStyles.at(i));    // 设置颜色，图元由共享渲染器提供
+        addItem(chartItem);
+        appendItems << chartItem;
+        chartItems[i] = chartItem;
+    }
+
+    for (int i = 0; i < model.edgeCount(); ++i)
+    {
+        LineItem* lineItem = new LineItem(chartItems.at(model.edgeStarts.at(i)), chartItems.at(model.edgeEnds.at(i)));
+        lineItem->setLine(model.edgeLines.at(i));
+        lineItem->color = QColor(model.edgeColors.at(i));
+        lineItem->Uid = model.edgeUids.at(i);
+        addItem(lineItem);
+        appendItems << lineItem;
+        allLines.append(lineItem);
+        connect(lineItem, &LineItem::doubleClickItem, this, &Scene::doubleClickItem);
+        lineItems[i] = lineItem;
+    }
+
+    for (int i = 0; i < model.labelCount(); ++i)
+    {
+        TextItem* textItem = new TextItem();
+        addItem(textItem);
+        textItem->Uid = model.labelUids.at(i);
+        textItem->setPlainText(model.labelTexts.at(i));
+        textItem->text = model.labelTexts.at(i);
+        textItem->setDefaultTextColor(QColor(model.labelColors.at(i)));
+        textItem->setFont(model.fonts.at(model.labelFonts.at(i)));
+        textItem->setPos(model.labelPositions.at(i));
+        textItem->setTransform(model.labelTransforms.at(i));
+        textItem->update();
+        appendItems << textItem;
+        allTexts.append(textItem);
+        // 关联到图形或线，跟随其位置
+        if (model.labelOwners.at(i) == DiagramModel::NodeOwner)
+        {
+            connectText(textItem, chartItems.at(model.labelOwnerIndices.at(i)));
+        }
+        else if (model.labelOwners.at(i) == DiagramModel::EdgeOwner)
+        {
+            connectText(textItem, lineItems.at(model.labelOwnerIndices.at(i)));
+        }
+    }
+
+    // 图片数据登记到本页的仓库，哈希以重新计算的为准
+    QHash<QString, QString> imageKeys;
+    for (QHash<QString, QByteArray>::const_iterator it = model.images.constBegin(); it != model.images.constEnd(); ++it)
+    {
+        imageKeys.insert(it.key(), images.insert(it.value()));
+    }
+    for (int i = 0; i < model.pictureCount(); ++i)
+    {
+        PixmapItem* pixmapItem = createPixmapItem(imageKeys.value(model.pictureImages.at(i)), model.pictureSizes.at(i));
+        if (pixmapItem == nullptr)
+        {
+            continue;                                   // 图片数据缺失或无法解码
+        }
+        pixmapItem->Uid = model.pictureUids.at(i);
+        pixmapItem->setPos(model.picturePositions.at(i));
+        addItem(pixmapItem);
+        appendItems << pixmapItem;
+    }
+    if (!model.backgroundImage.isEmpty())
+    {
+        setBackgroundImage(imageKeys.value(model.backgroundImage), model.backgroundSize);
+    }
+    return appendItems;
+}
+
+PixmapItem* Scene::createPixmapItem(const QString& key, QSizeF size, qreal scale)
+{
+    QByteArray encoded = images.data(key);
+    QSize native = ImageStore::imageSize(encoded);
+    if (!native.isValid())
+    {
+        return nullptr;
+    }
+    QSizeF display = size.isValid() ? QSizeF(native).scaled(size, Qt::KeepAspectRatio) : QSizeF(native);
+    // 只按显示大小乘以缩放比例解码，大图不会先生成原图大小的图像
+    QImage image = ImageStore::decode(encoded, (display * scale).toSize().expandedTo(QSize(1, 1)));
+    if (image.isNull())
+    {
+        return nullptr;
+    }
+    PixmapItem* pixmapItem = new PixmapItem(image);
+    pixmapItem->setImageSource(key, encoded);
+    pixmapItem->setDisplaySize(display, scale);
+    return pixmapItem;
+}
+
+void Scene::setBackgroundImage(const QString& key, QSize size)
+{
+    QImage image = key.isEmpty() ? QImage() : images.image(key, size);
+    backgroundImage = image.isNull() ? QString() : key;
+    backgroundSize = size;
+    backgroundTiles.setImage(image);        // 不再作为画刷，每次重绘时按缩放比例平铺整个暴露区域
+    update();
+}
+
+void Scene::drawBackground(QPainter* painter, const QRectF& rect)
+{
+    QGraphicsScene::drawBackground(painter, rect);
+    backgroundTiles.draw(painter, rect);
+}
+
+bool Scene::saveToXml(QIODevice* device, const QString& tabName, const QString& guid)
+{
+    DiagramModel model = toModel(items());
+    model.tabName = tabName;
+    model.guid = guid;
+    return model.writeXml(device);
+}
+
+void Scene::loadFromXml(QIODevice* device)
+{
+    DiagramModel model;
+    model.readXml(device);  // 文件不完整时仍加载已读取的部分
+    addModel(model);
+}
+
+QString Scene::copyToXml(const QList<QGraphicsItem*>& items)
+{
+    DiagramModel model = toModel(items);
+    model.regenerateUids();     // 复制出的图形项使用新的唯一ID
+    // 背景不随图形项复制
+    if (!model.pictureImages.contains(model.backgroundImage))
+    {
+        model.images.remove(model.backgroundImage);
+    }
+    model.backgroundImage.clear();
+    return model.toClipboardXml();
+}
+
+QList<QGraphicsItem*> Scene::pasteFromXml(const QString& data, QPointF position, QString* errorString)
+{
+    DiagramModel model;
+    model.fromClipboardXml(data, errorString);
+    model.translate(position - model.center());     // 以粘贴位置为中心
+    return addModel(model);
+}
+
+void Scene::collectLayoutItems(QList<QGraphicsItem*>& charts, QList<QGraphicsItem*>& lines) const
+{
+    QList<QGraphicsItem*> allItems = items();
+    for (QGraphicsItem* item : qAsConst(allItems))
+    {
+        if (item->type() == ChartItem::Type)
+        {
+            charts.append(item);
+        }
+        else if (item->type() == LineItem::Type)
+        {
+            lines.append(item);
+        }
+    }
+}
+
+void Scene::autoLayout()
+{
+    stopAutoLayout();
+    // 模型中的图形与 charts 同序
+    QList<QGraphicsItem*> charts;
+    QList<QGraphicsItem*> lines;
+    collectLayoutItems(charts, lines);
+    if (charts.isEmpty())
+    {
+        return;
+    }
+    QVector<QPointF> positions = LayeredLayout::layout(toModel(charts + lines));
+
+    QList<QPointF> oldPositions;
+    QList<QPointF> newPositions;
+    for (int i = 0; i < charts.size(); ++i)
+    {
+        oldPositions.append(charts.at(i)->pos());
+        newPositions.append(positions.at(i));
+        charts.at(i)->setPos(positions.at(i));
+    }
+    addOperation(new MoveOperation(charts, oldPositions, newPositions, this->parent()));
+}
+
+void Scene::startAutoLayout()
+{
+    if (layoutSearch)
+    {
+        return;
+    }
+    QList<QGraphicsItem*> charts;
+    QList<QGraphicsItem*> lines;
+    collectLayoutItems(charts, lines);
+    if (charts.isEmpty())
+    {
+        return;
+    }
+    layoutCharts.clear();
+    layoutStartPositions.clear();
+    for (QGraphicsItem* item : qAsConst(charts))
+    {
+        layoutCharts.append(qgraphicsitem_cast<ChartItem*>(item));
+        layoutStartPositions.append(item->pos());
+    }
+    layoutShownPositions = layoutStartPositions;
+
+    // 结果由工作线程发出，以排队连接回到界面线程处理
+    layoutSearch = new LayoutSearch(toModel(charts + lines));
+    connect(layoutSearch, &LayoutSearch::improved, this, &Scene::applyLayoutPreview, Qt::QueuedConnection);
+    connect(layoutSearch, &LayoutSearch::progress, this, &Scene::layoutProgress, Qt::QueuedConnection);
+    connect(layoutSearch, &LayoutSearch::finished, this, &Scene::finishAutoLayout, Qt::QueuedConnection);
+    layoutSearch->start();
+}
+
+bool Scene::isAutoLayoutRunning() const
+{
+    return layoutSearch != nullptr;
+}
+
+void Scene::stopAutoLayout()
+{
+    if (layoutSearch)
+    {
+        // 已取消的搜索仍可能发出信号，断开后不会结束之后开始的搜索
+        layoutSearch->cancel();
+        disconnect(layoutSearch, nullptr, this, nullptr);
+        finishAutoLayout();
+    }
+}
+
+void Scene::applyLayoutPreview(const QVector<QPointF>& positions)
+{
+    // 更早的结果可能在更好的结果之后到达，只显示目前最好的
+    if (layoutSearch == nullptr || (sender() != nullptr && sender() != layoutSearch) || positions.size() != layoutCharts.size() || positions != layoutSearch->bestPositions())
+    {
+        return;
+    }
+    // 用户在搜索期间拖动或撤销移动过的图形保持原样
+    for (int i = 0; i < layoutCharts.size(); ++i)
+    {
+        ChartItem* chart = layoutCharts.at(i);
+        if (chart && chart->pos() == layoutShownPositions.at(i))
+        {
+            chart->setPos(positions.at(i));
+            layoutShownPositions[i] = positions.at(i);
+        }
+    }
+}
+
+void Scene::finishAutoLayout()
+{
+    // 断开前已经排队的信号可能来自被取消的搜索
+    if (layoutSearch == nullptr || (sender() != nullptr && sender() != layoutSearch))
+    {
+        return;
+    }
+    LayoutSearch* search = layoutSearch;
+    layoutSearch = nullptr;
+    QVector<QPointF> positions = search->bestPositions();
+    search->deleteLater();                                              // 析构时等待被取消的任务返回
+
+    // 搜索期间被删除或被用户移动过的图形不参与移动，用户的移动已单独记录
+    QList<QGraphicsItem*> charts;
+    QList<QPointF> oldPositions;
+    QList<QPointF> newPositions;
+    for (int i = 0; i < layoutCharts.size(); ++i)
+    {
+        ChartItem* chart = layoutCharts.at(i);
+        if (chart == nullptr || chart->pos() != layoutShownPositions.at(i))
+        {
+            continue;
+        }
+        QPointF position = positions.size() == layoutCharts.size() ? positions.at(i) : layoutStartPositions.at(i);
+        chart->setPos(position);
+        if (position != layoutStartPositions.at(i))
+        {
+            charts.append(chart);
+            oldPositions.append(layoutStartPositions.at(i));
+            newPositions.append(position);
+        }
+    }
+    layoutCharts.clear();
+    layoutStartPositions.clear();
+    layoutShownPositions.clear();
+    if (!charts.isEmpty())
+    {
+        addOperation(new MoveOperation(charts, oldPositions, newPositions, this->parent()));
+    }
+    emit layoutFinished();
+}
+
+void Scene::addOperation(Operation* operation)
+{
+    if (operationStack)
+    {
+        operationStack->addOperation(operation);
+    }
+    else
+    {
+        delete operation;   // 没有视图时不记录
+    }
+}
+
+void Scene::searchText(const QString& text, LabelIndex::MatchMode mode)
+{
+    // 重置
+    for (TextItem* textItem : qAsConst(allTexts))
+    {
+        if (textItem->isSelected())
+        {
+            textItem->setSelected(false);
+        }
+    }
+    containTexts.clear();
+    currentIndex = 0;
+    currentText = text;
+    searchMode = mode;
+    // 由索引给出匹配的文本，不再逐个比较
+    QList<quintptr> keys = labels.search(text, mode, mode == LabelIndex::Exact ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    containTexts.reserve(keys.size());
+    for (quintptr key : qAsConst(keys))
+    {
+        containTexts.append(qgraphicsitem_cast<TextItem*>(reinterpret_cast<QGraphicsItem*>(key)));
+    }
+    // 不为空
+    if (!containTexts.isEmpty())
+    {
+       containTexts[0]->setSelected(true);
+    }
+}
+
+void Scene::replaceAll(const QString& text, LabelIndex::MatchMode mode, const QString& replacement)
+{
+    // 候选由索引给出，替换后的文本在线程池中计算
+    Qt::CaseSensitivity sensitivity = mode == LabelIndex::Exact ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    QList<quintptr> matched = labels.search(text, mode, sensitivity);
+    QVector<quintptr> keys;
+    QVector<QString> texts;
+    keys.reserve(matched.size());
+    texts.reserve(matched.size());
+    for (quintptr key : qAsConst(matched))
+    {
+        keys.append(key);
+        texts.append(labels.text(key));
+    }
+    replacer.start(keys, texts, text, mode, replacement, sensitivity);
+}
+
+void Scene::applyReplacement(const QVector<quintptr>& keys, const QVector<QString>& oldTexts, const QVector<QString>& newTexts)
+{
+    QList<QGraphicsItem*> items;
+    QVector<QString> oldValues;
+    QVector<QString> newValues;
+    for (int i = 0; i < keys.size(); ++i)
+    {
+        // 计算期间被删除或修改的文本不替换
+        if (!labels.contains(keys.at(i)) || labels.text(keys.at(i)) != oldTexts.at(i))
+        {
+            continue;
+        }
+        items.append(reinterpret_cast<QGraphicsItem*>(keys.at(i)));
+        oldValues.append(oldTexts.at(i));
+        newValues.append(newTexts.at(i));
+    }
+    if (items.isEmpty())
+    {
+        return;
+    }
+    setTexts(items, newValues);
+    addOperation(new ReplacceTextOperation(oldValues, newValues, items));   // 整批替换只记录一次
+}
+
+void Scene::setTexts(const QList<QGraphicsItem*>& items, const QVector<QString>& texts)
+{
+    QList<TextItem*> attached;
+    for (int i = 0; i < items.size(); ++i)
+    {
+        TextItem* textItem = qgraphicsitem_cast<TextItem*>(items.at(i));
+        textItem->setPlainText(texts.at(i));
+        textItem->text = texts.at(i);
+        if (textItem->connectItem != nullptr)
+        {
+            attached.append(textItem);
+        }
+    }
+    // 尺寸都确定后再把关联文本移回图形或线的中心
+    for (TextItem* textItem : qAsConst(attached))
+    {
+        textItem->updatePosition();
+    }
+}
+
+int Scene::refreshSearch()
+{
+    // 新建列表而不是在遍历时删除；已删除的文本不在索引中，只比较键不访问对象
+    Qt::CaseSensitivity sensitivity = searchMode == LabelIndex::Exact ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    QList<TextItem*> validTexts;
+    for (TextItem* textItem : qAsConst(containTexts))
+    {
+        quintptr key = quintptr(static_cast<QGraphicsItem*>(textItem));
+        if (labels.contains(key) && LabelIndex::matches(labels.text(key), currentText, searchMode, sensitivity))
+        {
+            validTexts.append(textItem);
+        }
+    }
+    containTexts = validTexts;
+    if (currentIndex >= containTexts.count())
+    {
+        currentIndex = 0;
+    }
+    return containTexts.count();
+}
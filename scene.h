@@ -6,11 +6,26 @@
 #include <QGraphicsView>
 #include <QGraphicsProxyWidget>
 #include <QSvgGenerator>
+#include <QPointer>
 
 #include "textitem.h"
 #include "pixmapitem.h"
+#include "spatialgrid.h"
+#include "diagrammodel.h"
+#include "operationstack.h"
+#include "layeredlayout.h"
+#include "layoutsearch.h"
+#include "incrementalrouter.h"
+#include "edgebundler.h"
+#include "graphanalysis.h"
+#include "labelindex.h"
+#include "textreplacer.h"
+#include "imagestore.h"
+#include "backgroundrenderer.h"
 
 enum Mode { NoMode, InsertChart, InsertLine, InsertText, MoveItem };
+enum IndexMethod { BspTreeIndexing, LinearIndexing, GridIndexing };            // 场景索引方式
+enum EdgeRouting { StraightRouting, OrthogonalRouting };                        // 连线方式：中心直连或正交绕开图形
 
 class Scene: public QGraphicsScene
 {
@@ -19,12 +34,14 @@ public:
     Scene(QObject *parent = nullptr);
     ~Scene() override;
 
+    OperationStack* operationStack;                                             // 记录操作的撤销栈，由视图设置
     FlowEnumItem flowType;                                                      // 选中的图形类型
     QList<TextItem*> allTexts;                                                  // 所有文本
     QList<LineItem*> allLines;                                                  // 所有线
     QList<TextItem*> containTexts;                                              // 包含选中文本的文本框
     int currentIndex;                                                           // 选中的文本下标
     QString currentText;                                                        // 当前查找的文本
+    LabelIndex::MatchMode searchMode;                                           // 当前查找的匹配方式
 
     void saveSceneToImage(QString filename);                                    // 保存为png图片
     void saveSceneToSVG(QString filename);                                      // 保存为svg图片
@@ -33,6 +50,47 @@ public:
     QList<LineItem*> getConnectLine(QGraphicsItem* item);                       // 获取相关联的线
     Mode getMode() const;
     void clearAllItems();  // 清除所有图形项的函数
+    void markLayoutDirty(ChartItem* item);                                      // 标记图形需要重新布局，在下一帧统一处理
+    IndexMethod getIndexMethod() const;
+    void setIndexMethod(IndexMethod method);                                    // 设置场景索引方式
+    EdgeRouting getEdgeRouting() const;
+    void setEdgeRouting(EdgeRouting routing);                                   // 设置连线方式并重新布线
+    QPolygonF routeEdge(LineItem* line);                                        // 连线的正交折线，移动图形后在后台增量更新
+    IncrementalRouter* getRouter() { return &router; }
+    bool isEdgeBundling() const;
+    void setEdgeBundling(bool enabled);                                         // 开启后入边很多的图形的入边合并为捆绑路径绘制
+    void invalidateBundles();                                                   // 标记捆绑路径需要重建，在下一帧统一处理
+    QList<QGraphicsItem*> diagramItems(const QPointF& position);                // 获取某点下的图形项，按层次从上到下排列
+    QList<QGraphicsItem*> diagramItems(const QRectF& rect, Qt::ItemSelectionMode selectionMode = Qt::IntersectsItemShape); // 获取区域内的图形项
+    void selectItemsInRect(const QRectF& rect);                                 // 选中区域内的图形项
+    static void updateItemIndex(QGraphicsItem* item);                           // 更新图形项在网格索引中的位置
+    static void removeItemIndex(QGraphicsItem* item);                           // 从网格索引中移除图形项
+    static void updateGraphItem(QGraphicsItem* item);                           // 将图形或线登记到流程检查
+    const GraphAnalysis& getGraphAnalysis() const { return graph; }
+    static void updateLabelIndex(TextItem* item);                               // 将文本的当前内容登记到查找索引
+    const LabelIndex& getLabelIndex() const { return labels; }
+    void connectText(TextItem* textItem, QGraphicsItem* item);                  // 将文本关联到图形或线，跟随其位置
+    DiagramModel toModel(const QList<QGraphicsItem*>& items);                   // 将图形项转换为数据模型
+    QList<QGraphicsItem*> addModel(const DiagramModel& model);                  // 按数据模型创建图形项
+    bool saveToXml(QIODevice* device, const QString& tabName, const QString& guid); // 保存为XML
+    void loadFromXml(QIODevice* device);                                        // 从XML读取图形项
+    QString copyToXml(const QList<QGraphicsItem*>& items);                      // 将图形项复制为XML文本，使用新的唯一ID
+    QList<QGraphicsItem*> pasteFromXml(const QString& data, QPointF position, QString* errorString = nullptr); // 以position为中心粘贴XML文本中的图形项
+    ImageStore& getImageStore() { return images; }
+    PixmapItem* createPixmapItem(const QString& key, QSizeF size = QSizeF(), qreal scale = 1); // 创建显示在 size 内的图片项（不加入场景），按 size*scale 像素解码，size 无效时为原图大小
+    void setBackgroundImage(const QString& key, QSize size);                    // 以仓库中的图片按 size 解码作为背景，key 为空时清除背景
+    QString getBackgroundImage() const { return backgroundImage; }
+    QSize getBackgroundSize() const { return backgroundSize; }
+    const BackgroundRenderer& getBackgroundRenderer() const { return backgroundTiles; }
+    void searchText(const QString& text, LabelIndex::MatchMode mode = LabelIndex::Exact); // 查找文本并选中第一个
+    int refreshSearch();                                                        // 移除已不再匹配的查找结果并修正当前下标，返回剩余数量
+    void replaceAll(const QString& text, LabelIndex::MatchMode mode, const QString& replacement); // 在后台计算全部替换，完成后作为一次操作应用
+    TextReplacer* getReplacer() { return &replacer; }
+    static void setTexts(const QList<QGraphicsItem*>& items, const QVector<QString>& texts); // 批量设置文本，全部设置后关联文本再统一重新定位
+    void autoLayout();                                                          // 分层排列所有图形，作为一次可撤销的移动
+    void startAutoLayout();                                                     // 在后台并行搜索布局，边搜索边显示目前最好的结果
+    bool isAutoLayoutRunning() const;                                           // 后台布局是否正在进行
+    void addOperation(Operation* operation);                                    // 将操作压入撤销栈
 //protected:
     void mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent) override;        // 按下鼠标
     void mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent) override;         // 移动鼠标
@@ -40,6 +98,7 @@ public:
 
     void keyPressEvent(QKeyEvent *event) override;                              // 按下键盘
     void keyReleaseEvent(QKeyEvent *event) override;                            // 松开键盘
+    void drawBackground(QPainter *painter, const QRectF &rect) override;        // 只绘制暴露区域内的背景图片块
 private:
      Mode mode;                                                                 // 屏幕的模式
      QGraphicsLineItem* lineItem;                                               // 选中的连接线
@@ -52,12 +111,60 @@ private:
      QList<QGraphicsLineItem*> horizontalLine;                                  // 选中框的横线
      bool isMove;                                                               // 是否在移动一个图形
      bool shiftIsClicked;                                                       // Shift是否一直按住
+     QSet<QGraphicsItem*> dragSelection;                                        // 按下鼠标时缓存的选中项
+     QList<QGraphicsItem*> dragItems;                                           // 随鼠标移动的选中项
+     QGraphicsPathItem* dragProxy;                                              // 大量图形拖动时代替它们移动的轮廓
+     static const int proxyDragThreshold = 200;                                 // 选中项达到该数量时只拖动轮廓
+     QList<QPointer<ChartItem>> dirtyCharts;                                    // 等待布局的图形
+     bool layoutPending;                                                        // 是否已安排布局
+     IndexMethod indexMethod;                                                   // 场景索引方式
+     SpatialGrid<QGraphicsItem*> grid;                                          // 网格索引，只登记顶层图形项
+     EdgeRouting edgeRouting;                                                   // 连线方式
+     IncrementalRouter router;                                                  // 正交布线，障碍物为所有图形
+     bool edgeBundling;                                                         // 是否捆绑扇入连线
+     bool bundlesDirty;                                                         // 捆绑路径是否需要重建
+     QList<QGraphicsPathItem*> bundleItems;                                     // 捆绑路径
+     QList<QPointer<LineItem>> bundledLines;                                    // 被捆绑的线
+     GraphAnalysis graph;                                                       // 流程检查
+     bool analysisPending;                                                      // 是否已安排流程检查
+     LabelIndex labels;                                                         // 文本的查找索引，键为文本项
+     TextReplacer replacer;                                                     // 后台批量替换
+     ImageStore images;                                                         // 图片项和背景使用的图片，按内容哈希去重
+     QString backgroundImage;                                                   // 背景图片的哈希
+     QSize backgroundSize;                                                      // 背景图片的显示大小
+     BackgroundRenderer backgroundTiles;                                        // 按缩放档位缓存的背景图片块
+
+     void scheduleAnalysis();                                                   // 在下一帧统一检查一次
+
+     void rebuildBundles();                                                     // 按当前的线重建捆绑路径
+     LayoutSearch* layoutSearch;                                                // 正在进行的后台布局
+     QList<QPointer<ChartItem>> layoutCharts;                                   // 参与后台布局的图形，与模型同序
+     QList<QPointF> layoutStartPositions;                                       // 开始布局前的位置，用于撤销
+     QList<QPointF> layoutShownPositions;                                       // 最近一次由布局设置的位置，不同则已被用户移动
+
+     void collectLayoutItems(QList<QGraphicsItem*>& charts, QList<QGraphicsItem*>& lines) const; // 获取参与布局的图形和线
+
+     void sortByStacking(QList<QGraphicsItem*>& items) const;                   // 按层次从上到下排序
 
      double distance(QPointF pos1, QPointF pos2);                               // 计算距离
+     QPointF alignToGuides(QPointF position);                                   // 显示临近的对齐线并返回吸附偏移
 
 public slots:
     void setMode(Mode mode);                                                    // 设置模式
     void doubleClickItem();                                                     // 双击选中或创建文本框
+    void flushLayout();                                                         // 更新所有被标记图形的文本和线
+    void analyzeGraph();                                                        // 重新检查流程并更新警告有变化的图形
+    void stopAutoLayout();                                                      // 停止后台布局，保留目前最好的结果
+
+private slots:
+    void applyLayoutPreview(const QVector<QPointF>& positions);                 // 显示搜索到的更好的布局，不记录撤销
+    void finishAutoLayout();                                                    // 应用最好的结果并记录为一次移动
+    void applyRoutes(const QList<quintptr>& edges);                             // 后台重新布线完成，更新对应的线
+    void applyReplacement(const QVector<quintptr>& keys, const QVector<QString>& oldTexts, const QVector<QString>& newTexts); // 应用后台替换的结果
+
+signals:
+    void layoutProgress(int finished, int total);                               // 后台布局完成了一次搜索
+    void layoutFinished();                                                      // 后台布局结束或已停止
 };
 
 #endif // SCENE_H
@@ -0,0 +1,80 @@
+﻿#include "startuptrace.h"
+
+#include <QDebug>
+
+bool StartupTrace::enabled = false;
+
+QElapsedTimer& StartupTrace::clock()
+{
+    static QElapsedTimer timer;
+    return timer;
+}
+
+QVector<StartupTrace::Phase>& StartupTrace::records()
+{
+    static QVector<Phase> phases;
+    return phases;
+}
+
+void StartupTrace::start()
+{
+    records().clear();
+    clock().start();
+    if (!qEnvironmentVariableIsEmpty("FLOWCHARTS_STARTUP_TRACE"))
+    {
+        enabled = true;
+    }
+}
+
+void StartupTrace::mark(const QString& phase)
+{
+    if (!clock().isValid())
+    {
+        clock().start();                                    // 没有调用 start() 时（例如测试）从第一次记录开始
+    }
+    records().append({ phase, clock().nsecsElapsed() });
+}
+
+void StartupTrace::setEnabled(bool enabled)
+{
+    StartupTrace::enabled = enabled;
+}
+
+bool StartupTrace::isEnabled()
+{
+    return enabled;
+}
+
+const QVector<StartupTrace::Phase>& StartupTrace::phases()
+{
+    return records();
+}
+
+qint64 StartupTrace::elapsed(const QString& phase)
+{
+    for (const Phase& record : records())
+    {
+        if (record.name == phase)
+        {
+            return record.nsecs;
+        }
+    }
+    return -1;
+}
+
+void StartupTrace::report()
+{
+    if (!enabled)
+    {
+        return;
+    }
+    qint64 previous = 0;
+    for (const Phase& record : records())
+    {
+        qInfo().noquote() << QString("startup: %1 %2 ms (+%3 ms)")
+                             .arg(record.name, -16)
+                             .arg(record.nsecs / 1e6, 8, 'f', 2)
+                             .arg((record.nsecs - previous) / 1e6, 7, 'f', 2);
+        previous = record.nsecs;
+    }
+}
@@ -0,0 +1,33 @@
+﻿#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+// 启动过程的时间线：每个阶段结束时记录距启动的时间
+// 总是记录（开销只是读一次时钟），只有以 --startup-trace 参数或 FLOWCHARTS_STARTUP_TRACE 环境变量启动时才输出
+class StartupTrace
+{
+public:
+    struct Phase
+    {
+        QString name;
+        qint64 nsecs;                                       // 距 start() 的纳秒数
+    };
+
+    static void start();                                    // 开始计时，清空已有记录，并读取环境变量
+    static void mark(const QString& phase);                 // 记录一个阶段结束
+    static void setEnabled(bool enabled);                   // 是否在 report() 时输出
+    static bool isEnabled();
+    static const QVector<Phase>& phases();
+    static qint64 elapsed(const QString& phase);            // 某个阶段结束的纳秒数，没有记录时返回-1
+    static void report();                                   // 开启时按阶段输出耗时
+
+private:
+    static QElapsedTimer& clock();
+    static QVector<Phase>& records();
+    static bool enabled;
+};
+
+#endif // STARTUPTRACE_H
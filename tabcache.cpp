@@ -0,0 +1,311 @@
+﻿#include "tabcache.h"
+
+#include <QBoxLayout>
+#include <QLabel>
+#include <QPainter>
+#include <QTimer>
+
+TabCache::TabCache(QTabWidget* tabs, const ViewFactory& factory, QObject* parent)
+    : QObject(parent), tabs(tabs), factory(factory), budget(128 * 1024 * 1024), trimPending(false)
+{
+    connect(tabs, &QTabWidget::currentChanged, this, &TabCache::touch);
+}
+
+void TabCache::setMemoryBudget(qint64 bytes)
+{
+    budget = bytes;
+    scheduleTrim();
+}
+
+void TabCache::addPage(QWidget* page)
+{
+    recent.removeAll(page);
+    recent.prepend(page);
+    View* view = page->findChild<View*>("graphicsView");
+    if (view != nullptr)
+    {
+        watch(page, view);
+    }
+    scheduleTrim();
+}
+
+void TabCache::addProjectPage(QWidget* page, const QSharedPointer<ProjectFile>& project)
+{
+    recent.removeAll(page);
+    recent.append(page);                                                // 还没有看过
+    delete page->findChild<View*>("graphicsView");
+    Unloaded entry;
+    entry.scaleMultiple = 1.0;
+    entry.pendingRead = true;
+    unloaded.insert(page, entry);
+    projects.insert(page, project);
+    modified.remove(page);
+
+    QLabel* placeholder = new QLabel(QStringLiteral("正在加载…"), page);
+    placeholder->setObjectName("tabThumbnail");
+    placeholder->setAlignment(Qt::AlignCenter);
+    QBoxLayout* layout = qobject_cast<QBoxLayout*>(page->layout());
+    if (layout != nullptr)
+    {
+        layout->insertWidget(0, placeholder, 1);
+    }
+}
+
+void TabCache::removePage(QWidget* page)
+{
+    recent.removeAll(page);
+    unloaded.remove(page);
+    modified.remove(page);
+    projects.remove(page);
+}
+
+void TabCache::setModified(QWidget* page, bool isModified)
+{
+    if (isModified)
+    {
+        modified.insert(page);
+    }
+    else
+    {
+        modified.remove(page);
+    }
+}
+
+void TabCache::setSourceProject(QWidget* page, const QSharedPointer<ProjectFile>& project)
+{
+    projects.insert(page, project);
+}
+
+DiagramModel TabCache::model(QWidget* page)
+{
+    QHash<QWidget*, Unloaded>::iterator it = unloaded.find(page);
+    if (it != unloaded.end())
+    {
+        readPending(page, it.value());
+        return it->model;
+    }
+    View* view = page->findChild<View*>("graphicsView");
+    return view == nullptr ? DiagramModel() : view->graphicsScene->toModel(view->graphicsScene->items());
+}
+
+void TabCache::watch(QWidget* page, View* view)
+{
+    QPointer<QWidget> guard(page);
+    connect(view->operationStack, &OperationStack::countChange, view, [this, guard]() {
+        if (!guard.isNull())
+        {
+            modified.insert(guard);
+        }
+    });
+}
+
+bool TabCache::readPending(QWidget* page, Unloaded& entry)
+{
+    if (!entry.pendingRead)
+    {
+        return true;
+    }
+    entry.pendingRead = false;
+    QSharedPointer<ProjectFile> project = projects.value(page);
+    QString errorString;
+    if (project.isNull() || !project->readPage(page->objectName(), &entry.model, &errorString))
+    {
+        qWarning("TabCache: %s", qPrintable(errorString));             // 读取失败时显示为空白页面
+        return false;
+    }
+    return true;
+}
+
+View* TabCache::view(QWidget* page)
+{
+    if (page == nullptr)
+    {
+        return nullptr;
+    }
+    QHash<QWidget*, Unloaded>::iterator it = unloaded.find(page);
+    if (it == unloaded.end())
+    {
+        return page->findChild<View*>("graphicsView");
+    }
+    Unloaded entry = it.value();
+    unloaded.erase(it);
+    bool firstRead = entry.pendingRead;
+    readPending(page, entry);
+    delete page->findChild<QLabel*>("tabThumbnail");
+
+    // 由数据模型一次创建所有图形项，与打开文件相同
+    View* view = factory(page);
+    watch(page, view);
+    view->graphicsScene->addModel(entry.model);
+    if (!firstRead)
+    {
+        view->setTransform(entry.transform);                            // 恢复卸载前的缩放和位置
+        view->scaleMultiple = entry.scaleMultiple;
+        view->centerOn(entry.center);
+    }
+    scheduleTrim();
+    return view;
+}
+
+bool TabCache::canUnload(View* view) const
+{
+    Scene* scene = view->graphicsScene;
+    if (scene->isAutoLayoutRunning())
+    {
+        return false;                                                   // 后台布局完成后才能保存
+    }
+    // 撤销记录引用场景中的图形项，无法随数据模型保存，有撤销记录的页面不卸载
+    if (view->operationStack->getUndoCount() > 0 || view->operationStack->getRedoCount() > 0)
+    {
+        return false;
+    }
+    // 图片以压缩数据随数据模型保存；正在编辑的文本不卸载
+    QList<QGraphicsItem*> allItems = scene->items();
+    for (QGraphicsItem* item : qAsConst(allItems))
+    {
+        if (item->type() == TextItem::Type && qgraphicsitem_cast<TextItem*>(item)->isEditing())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TabCache::unload(QWidget* page)
+{
+    if (page == nullptr)
+    {
+        return false;
+    }
+    if (unloaded.contains(page))
+    {
+        return true;
+    }
+    View* view = page->findChild<View*>("graphicsView");
+    if (view == nullptr || page == tabs->currentWidget() || !canUnload(view))
+    {
+        return false;
+    }
+    Scene* scene = view->graphicsScene;
+    Unloaded entry;
+    entry.model = scene->toModel(scene->items());
+    entry.thumbnail = renderThumbnail(scene, QSize(320, 200));
+    entry.transform = view->transform();
+    entry.scaleMultiple = view->scaleMultiple;
+    entry.center = view->mapToScene(view->viewport()->rect().center());
+    entry.pendingRead = false;
+
+    // 缩略图占据视图的位置，重新激活后在下一帧之前换回视图
+    QLabel* placeholder = new QLabel(page);
+    placeholder->setObjectName("tabThumbnail");
+    placeholder->setAlignment(Qt::AlignCenter);
+    placeholder->setPixmap(QPixmap::fromImage(entry.thumbnail));
+    QBoxLayout* layout = qobject_cast<QBoxLayout*>(page->layout());
+    if (layout != nullptr)
+    {
+        layout->insertWidget(qMax(0, layout->indexOf(view)), placeholder, 1);
+    }
+    OperationStack* operationStack = view->operationStack;
+    delete view;                                                        // 场景、图形项和操作随视图释放
+    delete operationStack;                                              // 撤销栈为空，没有丢弃任何撤销记录
+    unloaded.insert(page, entry);
+    return true;
+}
+
+QStringList TabCache::labelTexts(QWidget* page) const
+{
+    QHash<QWidget*, Unloaded>::const_iterator it = unloaded.constFind(page);
+    return it == unloaded.constEnd() ? QStringList() : it->model.labelTexts.toList();
+}
+
+QImage TabCache::thumbnail(QWidget* page) const
+{
+    return unloaded.value(page).thumbnail;
+}
+
+qint64 TabCache::loadedBytes() const
+{
+    qint64 total = 0;
+    for (const QPointer<QWidget>& page : recent)
+    {
+        View* view = page.isNull() || unloaded.contains(page) ? nullptr : page->findChild<View*>("graphicsView");
+        if (view != nullptr)
+        {
+            total += estimateBytes(view->graphicsScene);
+        }
+    }
+    return total;
+}
+
+qint64 TabCache::estimateBytes(const Scene* scene)
+{
+    return bytesPerPage + bytesPerItem * scene->items().size();
+}
+
+QImage TabCache::renderThumbnail(Scene* scene, const QSize& size)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QRectF source = scene->itemsBoundingRect();
+    if (!source.isEmpty())
+    {
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        scene->render(&painter, QRectF(image.rect()), source, Qt::KeepAspectRatio);
+    }
+    return image;
+}
+
+void TabCache::touch(int index)
+{
+    QWidget* page = tabs->widget(index);
+    if (page == nullptr)
+    {
+        return;
+    }
+    recent.removeAll(page);
+    recent.prepend(page);
+    if (unloaded.contains(page))
+    {
+        // 先显示缩略图，下一轮事件循环再创建图形项
+        QPointer<QWidget> guard(page);
+        QTimer::singleShot(0, this, [this, guard]() {
+            if (!guard.isNull())
+            {
+                view(guard);
+            }
+        });
+    }
+    scheduleTrim();
+}
+
+void TabCache::scheduleTrim()
+{
+    if (!trimPending)
+    {
+        trimPending = true;
+        QMetaObject::invokeMethod(this, "trim", Qt::QueuedConnection);  // 切换页面后再卸载，不拖慢切换
+    }
+}
+
+void TabCache::trim()
+{
+    trimPending = false;
+    recent.removeAll(QPointer<QWidget>());                             // 已销毁的页面
+    qint64 total = loadedBytes();
+    // 从最久未用的页面开始卸载，当前页面总是保留
+    for (int i = recent.size() - 1; i >= 0 && total > budget; --i)
+    {
+        QWidget* page = recent.at(i);
+        View* view = unloaded.contains(page) ? nullptr : page->findChild<View*>("graphicsView");
+        if (view == nullptr)
+        {
+            continue;
+        }
+        qint64 bytes = estimateBytes(view->graphicsScene);
+        if (unload(page))
+        {
+            total -= bytes;
+        }
+    }
+}
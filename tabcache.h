@@ -0,0 +1,80 @@
+﻿#ifndef TABCACHE_H
+#define TABCACHE_H
+
+#include <QHash>
+#include <QImage>
+#include <QPointer>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTabWidget>
+#include <functional>
+
+#include "view.h"
+#include "projectfile.h"
+
+// 标签页缓存：不活动的页面可以卸载为数据模型和缩略图，只保留页面和底部工具栏，视图、场景、撤销栈和图形项全部释放
+// 已加载页面的估计内存超过预算时，在后台按最近使用的顺序卸载最久未看的页面，有撤销记录的页面保留；
+// 页面再次激活时先显示缩略图，随后由数据模型重新创建视图，通过 view() 访问时立即重新创建
+// 项目文件中的页面登记时只有名称，首次激活时才从文件读取；撤销栈有变化的页面记为已修改，保存项目时只写这些页面
+class TabCache : public QObject
+{
+    Q_OBJECT
+public:
+    using ViewFactory = std::function<View*(QWidget* page)>;           // 在页面中创建并设置好视图
+
+    TabCache(QTabWidget* tabs, const ViewFactory& factory, QObject* parent = nullptr);
+
+    void setMemoryBudget(qint64 bytes);                                 // 设置已加载页面的内存预算
+    qint64 getMemoryBudget() const { return budget; }
+    void addPage(QWidget* page);                                        // 登记新页面，作为最近使用的页面
+    void addProjectPage(QWidget* page, const QSharedPointer<ProjectFile>& project); // 登记项目中的页面，guid 为页面的对象名，首次激活时读取
+    void removePage(QWidget* page);                                     // 页面关闭时丢弃缓存
+    bool isModified(QWidget* page) const { return modified.contains(page); }
+    void setModified(QWidget* page, bool isModified);
+    QSharedPointer<ProjectFile> sourceProject(QWidget* page) const { return projects.value(page); } // 页面所在的项目文件
+    void setSourceProject(QWidget* page, const QSharedPointer<ProjectFile>& project);
+    DiagramModel model(QWidget* page);                                  // 页面当前的内容，不重新创建视图
+    bool isLoaded(QWidget* page) const { return !unloaded.contains(page); }
+    View* view(QWidget* page);                                          // 页面的视图，已卸载时先重新创建
+    bool unload(QWidget* page);                                         // 卸载页面，当前页面、有撤销记录的页面和不能完整保存的页面不卸载
+    QStringList labelTexts(QWidget* page) const;                        // 已卸载页面的文本，用于跨页查找
+    QImage thumbnail(QWidget* page) const;                              // 已卸载页面的缩略图
+    qint64 loadedBytes() const;                                         // 已加载页面的估计内存
+
+    static qint64 estimateBytes(const Scene* scene);                    // 按图形项数量粗略估计页面占用的内存
+    static QImage renderThumbnail(Scene* scene, const QSize& size);     // 将所有图形缩放绘制到图片中
+
+public slots:
+    void touch(int index);                                              // 页面被激活：移到最近使用处，已卸载时安排重新创建
+    void trim();                                                        // 卸载最久未用的页面直到满足预算
+
+private:
+    struct Unloaded
+    {
+        DiagramModel model;                                             // 图形、连线和文本
+        QImage thumbnail;                                               // 缩略图
+        QTransform transform;                                           // 视图的缩放
+        double scaleMultiple;                                           // 视图记录的缩放倍数
+        QPointF center;                                                 // 视图中心对应的场景坐标
+        bool pendingRead;                                               // 还没有从项目文件读取
+    };
+
+    static const qint64 bytesPerPage = 512 * 1024;                      // 视图、场景和索引的固定开销
+    static const qint64 bytesPerItem = 2 * 1024;                        // 每个图形项连同缓存的字形和路径
+
+    QTabWidget* tabs;
+    ViewFactory factory;
+    qint64 budget;                                                      // 已加载页面的内存预算
+    QList<QPointer<QWidget>> recent;                                    // 页面，最近使用的在前
+    QHash<QWidget*, Unloaded> unloaded;                                 // 已卸载的页面
+    bool trimPending;                                                   // 是否已安排 trim
+    QSet<QWidget*> modified;                                            // 读取或保存后修改过的页面
+    QHash<QWidget*, QSharedPointer<ProjectFile>> projects;              // 页面所在的项目文件
+
+    void scheduleTrim();                                                // 在下一帧检查预算
+    void watch(QWidget* page, View* view);                              // 撤销栈变化时标记页面已修改
+    bool readPending(QWidget* page, Unloaded& entry);                   // 从项目文件读取尚未读取的页面
+    bool canUnload(View* view) const;
+};
+
+#endif // TABCACHE_H
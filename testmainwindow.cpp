@@ -12,12 +12,20 @@ class TestMainWindow : public QObject
 private:
     MainWindow* mainWindow;
 
+    // 处理所有已排队的事件（包括场景的布局），不依赖等待时间，结果是确定的
+    void processEvents()
+    {
+        QCoreApplication::sendPostedEvents();
+        QCoreApplication::processEvents();
+    }
+
 private slots:
     void initTestCase()
     {
         mainWindow = new MainWindow();
         mainWindow->show();
-        QTest::qWait(100); // 等待事件循环初始化
+        processEvents(); // 处理显示窗口产生的事件
+        QTRY_VERIFY(mainWindow->isStartupFinished());   // 颜色和模板菜单在第一帧之后创建
     }
 
     void cleanupTestCase()
@@ -250,7 +258,7 @@ private slots:
         mainWindow->pasteSelect();
 
         // 等待事件完成
-        QTest::qWait(100);
+        processEvents();
 
         // 检查粘贴后的图形项数量
         int finalChartCountAfterPaste = countChartItems(scene);
@@ -276,7 +284,7 @@ private slots:
         mainWindow->cutSelect();
 
         // 等待事件完成
-        QTest::qWait(100);
+        processEvents();
 
         // 检查剪切后的图形项数量
         int finalChartCountAfterCut = countChartItems(scene);
@@ -288,7 +296,7 @@ private slots:
         mainWindow->pasteSelect();
 
         // 等待事件完成
-        QTest::qWait(100);
+        processEvents();
 
         // 检查最终图形项数量
         int finalChartCount = countChartItems(scene);
@@ -375,7 +383,7 @@ private slots:
         QApplication::sendEvent(scene, &releaseEvent);
 
         // 等待事件完成
-        QTest::qWait(100);
+        processEvents();
 
         // 验证图形项的新位置
         QCOMPARE(addedItem->pos(), newPosition);
@@ -384,7 +392,7 @@ private slots:
         QAction* undoAction = mainWindow->findChild<QAction*>("undoAction");
         QVERIFY(undoAction != nullptr);
         undoAction->trigger();
-        QTest::qWait(100);
+        processEvents();
 
         // 验证图形项恢复到初始位置
         QCOMPARE(addedItem->pos(), startPosition);
@@ -393,7 +401,7 @@ private slots:
         QAction* redoAction = mainWindow->findChild<QAction*>("redoAction");
         QVERIFY(redoAction != nullptr);
         redoAction->trigger();
-        QTest::qWait(100);
+        processEvents();
 
         // 验证图形项再次移动到新位置
         QCOMPARE(addedItem->pos(), newPosition);
@@ -442,7 +450,7 @@ private slots:
         QTest::mouseMove(view->viewport(), view->mapFromScene(rightTopScenePos));
 
         // 等待事件循环，确保事件处理完成
-        QTest::qWait(100);
+        processEvents();
 
         // 验证是否正确移动到 RightTop 控制点
         QRectF rightTopRect = QRectF(rightTopScenePos, QSizeF(1.5, 1.5)); // RightTop 控制点的区域
@@ -461,7 +469,7 @@ private slots:
         QTest::mouseRelease(view->viewport(), Qt::LeftButton, Qt::NoModifier, view->mapFromScene(posbtn));
 
         // 等待事件循环，确保界面更新生效
-        QTest::qWait(100);
+        processEvents();
 
         // 验证图形项大小是否更新
         QRectF updatedBoundingRect = chartItem->boundingRect();
@@ -541,7 +549,7 @@ private slots:
         QApplication::sendEvent(scene, &releaseEvent);
 
         // 等待事件完成
-        QTest::qWait(100);
+        processEvents();
 
         // 验证图形项的新位置
         QCOMPARE(addedItem->pos(), newPosition);
@@ -597,7 +605,7 @@ private slots:
         eventRelease.setButton(Qt::LeftButton);
         scene->mouseReleaseEvent(&eventRelease);
         // 等待事件完成
-        QTest::qWait(200);
+        processEvents();
         // 验证框选的图形数量
         int graphicsItemCount = 0;
         QList<QGraphicsItem*> itemsToSelect; // 保存框选的项目
@@ -630,7 +638,7 @@ private slots:
         pasteAction->trigger(); // 触发粘贴功能
 
         // 等待事件完成
-        QTest::qWait(200);
+        processEvents();
 
         // 验证粘贴的项目是否正确存在
         QList<QGraphicsItem*> pastedItems;
@@ -695,7 +703,7 @@ private slots:
         QVERIFY(yellowAction);
 
         yellowAction->trigger(); // 触发黄色填充颜色修改
-        QTest::qWait(100);
+        processEvents();
 
         QCOMPARE(chartItem->getCurrentFillColor(), "y");
 
@@ -713,7 +721,7 @@ private slots:
         QVERIFY(redAction);
 
         redAction->trigger(); // 触发红色边框颜色修改
-        QTest::qWait(100);
+        processEvents();
 
         QCOMPARE(chartItem->getCurrentBorderColor(), "r");
 
@@ -728,11 +736,11 @@ private slots:
         QVERIFY(undoAction);
 
         undoAction->trigger();
-        QTest::qWait(100);
+        processEvents();
         QCOMPARE(chartItem->getCurrentPath(), updatedPathFill);
 
         undoAction->trigger();
-        QTest::qWait(100);
+        processEvents();
         QCOMPARE(chartItem->getCurrentPath(), initialPath);
 
         // 验证操作栈状态
@@ -744,11 +752,11 @@ private slots:
         QVERIFY(redoAction);
 
         redoAction->trigger();
-        QTest::qWait(100);
+        processEvents();
         QCOMPARE(chartItem->getCurrentPath(), updatedPathFill);
 
         redoAction->trigger();
-        QTest::qWait(100);
+        processEvents();
         QCOMPARE(chartItem->getCurrentPath(), updatedPathBorder);
 
         // 最终操作栈状态验证
@@ -895,6 +903,902 @@ private slots:
         QCOMPARE(textItem->defaultTextColor(), newColor);
     }
 
+    void testStaticTextLabel()
+    {
+        TextItem textItem;
+
+        // 未编辑时不创建文档，由静态文本给出边界
+        QVERIFY(!textItem.isEditing());
+        QCOMPARE(textItem.toPlainText(), QString("文本"));
+        QVERIFY(!textItem.boundingRect().isEmpty());
+
+        // 进入编辑时才创建文档，并带上当前的文本和样式
+        QFont font("Arial", 16);
+        textItem.setFont(font);
+        textItem.setTextEditFlags(Qt::TextEditorInteraction);
+        QVERIFY(textItem.isEditing());
+        QCOMPARE(textItem.toPlainText(), QString("文本"));
+        QCOMPARE(textItem.font(), font);
+        QPointer<QTextDocument> editorDocument = textItem.document();
+
+        // 退出编辑后保留编辑结果并释放文档
+        textItem.setPlainText("Edited");
+        textItem.setTextEditFlags(Qt::NoTextInteraction);
+        QVERIFY(!textItem.isEditing());
+        QCOMPARE(textItem.toPlainText(), QString("Edited"));
+        QCOMPARE(textItem.text, QString("Edited"));
+        QVERIFY(editorDocument.isNull());
+        QVERIFY(textItem.document()->isEmpty());
+
+        // 再次编辑时重新创建文档
+        textItem.setTextEditFlags(Qt::TextEditorInteraction);
+        QVERIFY(textItem.document() != nullptr && textItem.document()->parent() == &textItem);
+        QCOMPARE(textItem.toPlainText(), QString("Edited"));
+        textItem.setTextEditFlags(Qt::NoTextInteraction);
+        QVERIFY(textItem.document()->isEmpty());
+    }
+
+    void testBatchedLayout()
+    {
+        Scene scene;
+        ChartItem* chartItem = new ChartItem(FlowEnumItem::Flow1);
+        ChartItem* endItem = new ChartItem(FlowEnumItem::Flow1);
+        scene.addItem(chartItem);
+        scene.addItem(endItem);
+        endItem->setPos(400, 0);
+        LineItem* lineItem = new LineItem(chartItem, endItem);
+        scene.addItem(lineItem);
+        scene.flushLayout();
+
+        QSignalSpy chartSpy(chartItem, &ChartItem::itemPositionHasChanged);
+        QSignalSpy lineSpy(lineItem, &LineItem::itemPositionHasChanged);
+        QLineF oldLine = lineItem->line();
+
+        // 同一帧内多次移动只标记，不立即更新
+        for (int i = 1; i <= 10; ++i)
+        {
+            chartItem->setPos(0, i * 10);
+        }
+        QCOMPARE(chartSpy.count(), 0);
+        QCOMPARE(lineItem->line(), oldLine);
+
+        // 布局时每个图形只通知一次
+        scene.flushLayout();
+        QCOMPARE(chartSpy.count(), 1);
+        QCOMPARE(lineSpy.count(), 1);
+        QVERIFY(lineItem->line() != oldLine);
+    }
+
+    void testGridIndex()
+    {
+        Scene scene;
+        scene.setIndexMethod(GridIndexing);
+        ChartItem* chartItem = new ChartItem(FlowEnumItem::Flow1);
+        scene.addItem(chartItem);
+        chartItem->setPos(1000, 1000);
+        QPointF center = chartItem->sceneBoundingRect().center();
+
+        // 网格查询与场景自带的查询结果一致
+        QVERIFY(scene.diagramItems(center).contains(chartItem));
+        QVERIFY(scene.diagramItems(QRectF(900, 900, 400, 400)).contains(chartItem));
+        QVERIFY(scene.diagramItems(QPointF(0, 0)).isEmpty());
+
+        // 移动后索引随之更新
+        chartItem->setPos(5000, 5000);
+        QVERIFY(!scene.diagramItems(center).contains(chartItem));
+        QVERIFY(scene.diagramItems(chartItem->sceneBoundingRect().center()).contains(chartItem));
+
+        // 删除后不再返回
+        QPointF newCenter = chartItem->sceneBoundingRect().center();
+        delete chartItem;
+        QVERIFY(scene.diagramItems(newCenter).isEmpty());
+
+        // 重叠的图形与BSP模式一致，后加入的在上面，移动不改变上下关系
+        ChartItem* lower = new ChartItem(FlowEnumItem::Flow1);
+        ChartItem* upper = new ChartItem(FlowEnumItem::Flow1);
+        scene.addItem(lower);
+        scene.addItem(upper);
+        lower->setPos(2000, 2000);
+        upper->setPos(2040, 2040);
+        lower->setPos(2020, 2020);
+        QPointF overlap = upper->sceneBoundingRect().intersected(lower->sceneBoundingRect()).center();
+        QCOMPARE(scene.diagramItems(overlap).first(), static_cast<QGraphicsItem*>(upper));
+        QCOMPARE(scene.items(overlap).first(), static_cast<QGraphicsItem*>(upper));
+        scene.setIndexMethod(BspTreeIndexing);
+        scene.setIndexMethod(GridIndexing);
+        QCOMPARE(scene.diagramItems(overlap).first(), static_cast<QGraphicsItem*>(upper));
+    }
+
+    void testProxyDrag()
+    {
+        // 选中项达到阈值时只拖动轮廓，松开时统一移动并记录一次操作
+        View view;
+        Scene* scene = view.graphicsScene;
+        QList<QGraphicsItem*> charts;
+        QList<QPointF> positions;
+        for (int i = 0; i < 210; ++i)
+        {
+            ChartItem* chart = new ChartItem(FlowEnumItem::Flow1);
+            chart->setFlags(QGraphicsItem::ItemIsMovable | QGraphicsItem::ItemIsSelectable);
+            chart->setPos((i % 15) * 300, (i / 15) * 300);
+            scene->addItem(chart);
+            chart->setSelected(true);
+            charts.append(chart);
+            positions.append(chart->pos());
+        }
+        QVERIFY(scene->selectedItems().size() >= 200);
+        int initialUndoCount = view.operationStack->getUndoCount();
+        QPointF pressPosition = charts.first()->sceneBoundingRect().center();
+        QPointF offset(50, 70);
+
+        QGraphicsSceneMouseEvent pressEvent(QEvent::GraphicsSceneMousePress);
+        pressEvent.setScenePos(pressPosition);
+        pressEvent.setButtonDownScenePos(Qt::LeftButton, pressPosition);
+        pressEvent.setButton(Qt::LeftButton);
+        pressEvent.setButtons(Qt::LeftButton);
+        QApplication::sendEvent(scene, &pressEvent);
+
+        QGraphicsSceneMouseEvent moveEvent(QEvent::GraphicsSceneMouseMove);
+        moveEvent.setScenePos(pressPosition + offset);
+        moveEvent.setLastScenePos(pressPosition);
+        moveEvent.setButtonDownScenePos(Qt::LeftButton, pressPosition);
+        moveEvent.setButtons(Qt::LeftButton);
+        QApplication::sendEvent(scene, &moveEvent);
+
+        // 拖动过程中图形保持原位
+        for (int i = 0; i < charts.size(); ++i)
+        {
+            QCOMPARE(charts.at(i)->pos(), positions.at(i));
+        }
+
+        QGraphicsSceneMouseEvent releaseEvent(QEvent::GraphicsSceneMouseRelease);
+        releaseEvent.setScenePos(pressPosition + offset);
+        releaseEvent.setButtonDownScenePos(Qt::LeftButton, pressPosition);
+        releaseEvent.setButton(Qt::LeftButton);
+        QApplication::sendEvent(scene, &releaseEvent);
+
+        // 松开后全部移动，只记录一次移动操作
+        for (int i = 0; i < charts.size(); ++i)
+        {
+            QCOMPARE(charts.at(i)->pos(), positions.at(i) + offset);
+        }
+        QCOMPARE(view.operationStack->getUndoCount(), initialUndoCount + 1);
+        QVERIFY(qobject_cast<MoveOperation*>(view.operationStack->undoStack->top()) != nullptr);
+
+        // 撤销后全部回到原位
+        view.operationStack->undo();
+        for (int i = 0; i < charts.size(); ++i)
+        {
+            QCOMPARE(charts.at(i)->pos(), positions.at(i));
+        }
+    }
+
+    void testDiagramModel()
+    {
+        // 模型不依赖场景，可以直接构建并读写
+        DiagramModel model;
+        int start = model.addNode("a", StartOrEnd, QPointF(0, 0));
+        int end = model.addNode("b", Judge, QPointF(300, 0), QTransform(), DiagramModel::styleId("l", "y"));
+        int edge = model.addEdge("c", start, end, QLineF(0, 0, 300, 0));
+        model.addLabel("d", "是", QPointF(150, 0), QFont(), qRgb(0, 0, 0), QTransform(), DiagramModel::EdgeOwner, edge);
+        QCOMPARE(model.nodeAt(QPointF(308, 8)), end);
+        QCOMPARE(model.nodesInRect(QRectF(-10, -10, 20, 20)), QVector<int>() << start);
+
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(model.writeXml(&buffer));
+        buffer.close();
+
+        // 场景按模型创建图形项，关联关系保持不变
+        Scene scene;
+        buffer.open(QIODevice::ReadOnly);
+        scene.loadFromXml(&buffer);
+        QCOMPARE(scene.allLines.size(), 1);
+        QCOMPARE(scene.allTexts.size(), 1);
+        QCOMPARE(scene.allTexts.first()->connectItem, static_cast<QGraphicsItem*>(scene.allLines.first()));
+
+        for (QGraphicsItem* item : scene.items())
+        {
+            if (item->type() == ChartItem::Type && qgraphicsitem_cast<ChartItem*>(item)->Uid == "b")
+            {
+                QCOMPARE(qgraphicsitem_cast<ChartItem*>(item)->getCurrentPath(), QString(":/image/flowchart/icon/fc-4-ly.svg"));
+            }
+        }
+
+        DiagramModel loaded = scene.toModel(scene.items());
+        QCOMPARE(loaded.nodeCount(), 2);
+        QCOMPARE(loaded.edgeCount(), 1);
+        QCOMPARE(loaded.labelCount(), 1);
+        QCOMPARE(int(loaded.labelOwners.first()), int(DiagramModel::EdgeOwner));
+        QCOMPARE(loaded.labelTexts.first(), QString("是"));
+    }
+
+    void testAutoLayout()
+    {
+        // 开始 -> 判定 -> 两个分支 -> 结束，另有一条回到判定的边
+        DiagramModel model;
+        int start = model.addNode("start", StartOrEnd, QPointF(900, 40));
+        int end = model.addNode("end", StartOrEnd, QPointF(0, 0));
+        int judge = model.addNode("judge", Judge, QPointF(500, 700));
+        int yes = model.addNode("yes", Flow1, QPointF(30, 300));
+        int no = model.addNode("no", Flow1, QPointF(800, 900), QTransform::fromScale(10, 10));
+        model.addEdge("e1", start, judge, QLineF());
+        model.addEdge("e2", judge, yes, QLineF());
+        model.addEdge("e3", judge, no, QLineF());
+        model.addEdge("e4", yes, end, QLineF());
+        model.addEdge("e5", no, judge, QLineF());
+        model.addEdge("e6", no, end, QLineF());
+
+        LayeredLayout layout(model);
+        QVector<QPointF> positions = layout.run();
+        QCOMPARE(positions.size(), model.nodeCount());
+        QCOMPARE(layout.crossings(), qint64(0));
+        // 开始在最上方，结束在最下方，分支按连线顺序从左到右排在判定下方
+        QVERIFY(positions[start].y() < positions[judge].y());
+        QVERIFY(positions[judge].y() < positions[yes].y());
+        QVERIFY(positions[yes].x() < positions[no].x());
+        QVERIFY(positions[no].y() < positions[end].y());
+
+        // 并行搜索的结果不差于同步布局
+        LayoutSearch search(model, 4);
+        QSignalSpy finishedSpy(&search, &LayoutSearch::finished);
+        search.start();
+        QVERIFY(finishedSpy.wait(5000) || finishedSpy.count() == 1);
+        QCOMPARE(search.bestCrossings(), qint64(0));
+        QCOMPARE(search.bestPositions().size(), model.nodeCount());
+
+        // 在场景中布局后可以一次撤销
+        View view;
+        Scene* scene = view.graphicsScene;
+        view.addChartItem(FlowEnumItem::StartOrEnd, QPointF(500, 500));
+        view.addChartItem(FlowEnumItem::Flow1, QPointF(0, 0));
+        ChartItem* first = nullptr;
+        ChartItem* second = nullptr;
+        for (QGraphicsItem* item : scene->items())
+        {
+            if (item->type() == ChartItem::Type)
+            {
+                (first == nullptr ? first : second) = qgraphicsitem_cast<ChartItem*>(item);
+            }
+        }
+        QVERIFY(first && second);
+        LineItem* line = new LineItem(first->getChartType() == StartOrEnd ? first : second, first->getChartType() == StartOrEnd ? second : first);
+        scene->addItem(line);
+        QPointF oldFirst = first->pos();
+        QPointF oldSecond = second->pos();
+        int undoCount = view.operationStack->getUndoCount();
+        scene->autoLayout();
+        QCOMPARE(view.operationStack->getUndoCount(), undoCount + 1);
+        QCOMPARE(line->startItem->y() < line->endItem->y(), true);
+        view.operationStack->undo();
+        QCOMPARE(first->pos(), oldFirst);
+        QCOMPARE(second->pos(), oldSecond);
+    }
+
+    void testOrthogonalRouting()
+    {
+        // 两个图形之间隔着一堵墙，连线必须绕过去
+        OrthogonalRouter router;
+        QRectF source(0, 0, 160, 160);
+        QRectF target(600, 0, 160, 160);
+        QRectF wall(280, -200, 160, 560);
+        router.setObstacle(1, source);
+        router.setObstacle(2, target);
+        router.setObstacle(3, wall);
+        QPolygonF path = router.route(source, target, 1, 2);
+        QVERIFY(path.size() >= 4);
+        QVERIFY(source.contains(path.first()));
+        QVERIFY(target.contains(path.last()));
+        for (int i = 1; i < path.size(); ++i)
+        {
+            QPointF a = path.at(i - 1);
+            QPointF b = path.at(i);
+            QVERIFY(a.x() == b.x() || a.y() == b.y());
+            QRectF segment = QRectF(a, b).normalized();
+            bool crosses = segment.left() < wall.right() && segment.right() > wall.left() && segment.top() < wall.bottom() && segment.bottom() > wall.top();
+            QVERIFY(!crosses);
+        }
+
+        // 场景切换为正交连线后，线的两端仍在各自的图形上
+        View view;
+        Scene* scene = view.graphicsScene;
+        view.addChartItem(FlowEnumItem::Flow1, QPointF(0, 0));
+        view.addChartItem(FlowEnumItem::Flow1, QPointF(400, 300));
+        QList<ChartItem*> charts;
+        for (QGraphicsItem* item : scene->items())
+        {
+            if (item->type() == ChartItem::Type)
+            {
+                charts.append(qgraphicsitem_cast<ChartItem*>(item));
+            }
+        }
+        QCOMPARE(charts.size(), 2);
+        LineItem* line = new LineItem(charts.at(0), charts.at(1));
+        scene->addItem(line);
+        scene->setEdgeRouting(OrthogonalRouting);
+        QPolygonF routed = line->getPath();
+        QVERIFY(routed.size() >= 3);
+        QVERIFY(charts.at(0)->sceneBoundingRect().contains(routed.first()));
+        QVERIFY(charts.at(1)->sceneBoundingRect().contains(routed.last()));
+        scene->setEdgeRouting(StraightRouting);
+        QCOMPARE(line->getPath().size(), 2);
+    }
+
+    void testIncrementalRouting()
+    {
+        // 上下两条互不相干的水平连线
+        IncrementalRouter router;
+        router.setObstacle(1, QRectF(0, 0, 160, 160));
+        router.setObstacle(2, QRectF(600, 0, 160, 160));
+        router.setObstacle(3, QRectF(0, 1000, 160, 160));
+        router.setObstacle(4, QRectF(600, 1000, 160, 160));
+        QCOMPARE(router.route(10, QRectF(0, 0, 160, 160), QRectF(600, 0, 160, 160), 1, 2).size(), 2);
+        QPolygonF lower = router.route(11, QRectF(0, 1000, 160, 160), QRectF(600, 1000, 160, 160), 3, 4);
+        QList<quintptr> changed;
+        connect(&router, &IncrementalRouter::routesChanged, this, [&changed](const QList<quintptr>& edges) { changed += edges; });
+
+        // 障碍物移到上面的连线中间，只有这条线需要重新布线
+        router.setObstacle(5, QRectF(300, -100, 160, 360));
+        QCOMPARE(router.pendingRoutes(), QList<quintptr>() << 10);
+        router.waitForDone();
+        QCOMPARE(changed, QList<quintptr>() << 10);
+        QVERIFY(router.route(10, QRectF(0, 0, 160, 160), QRectF(600, 0, 160, 160), 1, 2).size() >= 4);
+        QVERIFY(router.dependentRoutes(5).contains(10));
+        QCOMPARE(router.route(11, QRectF(0, 1000, 160, 160), QRectF(600, 1000, 160, 160), 3, 4), lower);
+
+        // 障碍物移走后，绕行的连线恢复为直线
+        changed.clear();
+        router.setObstacle(5, QRectF(3000, 3000, 160, 160));
+        router.waitForDone();
+        QCOMPARE(changed, QList<quintptr>() << 10);
+        QCOMPARE(router.route(10, QRectF(0, 0, 160, 160), QRectF(600, 0, 160, 160), 1, 2).size(), 2);
+
+        // 后台批次计算期间连线被删除后重新加入（如撤销删除），旧批次的结果不覆盖立即计算的折线
+        changed.clear();
+        router.setObstacle(5, QRectF(300, -100, 160, 360));
+        router.flush();
+        router.removeRoute(10);
+        QPolygonF fresh = router.route(10, QRectF(0, 0, 160, 160), QRectF(0, 1000, 160, 160), 1, 3);
+        router.waitForDone();
+        QVERIFY(!changed.contains(10));
+        QCOMPARE(router.route(10, QRectF(0, 0, 160, 160), QRectF(0, 1000, 160, 160), 1, 3), fresh);
+    }
+
+    void testEdgeBundling()
+    {
+        // 十个图形连到同一个目标，另有一个图形只有两条入边
+        QVector<QRectF> bounds;
+        QVector<int> starts;
+        QVector<int> ends;
+        bounds << QRectF(500, 800, 160, 160) << QRectF(2000, 0, 160, 160);
+        for (int i = 0; i < 10; ++i)
+        {
+            bounds << QRectF(i * 200, 0, 160, 160);
+            starts << bounds.size() - 1;
+            ends << 0;
+        }
+        starts << 2 << 3;
+        ends << 1 << 1;
+        QVector<EdgeBundler::Bundle> bundles = EdgeBundler::bundle(bounds, starts, ends);
+        QCOMPARE(bundles.size(), 1);
+        QCOMPARE(bundles.first().target, 0);
+        QCOMPARE(bundles.first().edges.size(), 10);
+        // 入边都来自上方，主汇合点在目标上方
+        QVERIFY(bundles.first().junction.y() < bounds.at(0).top());
+
+        // 场景中被捆绑的线不再单独绘制，关闭后恢复
+        View view;
+        Scene* scene = view.graphicsScene;
+        ChartItem* target = new ChartItem(FlowEnumItem::Flow1);
+        target->setPos(500, 800);
+        scene->addItem(target);
+        QList<LineItem*> lines;
+        for (int i = 0; i < 10; ++i)
+        {
+            ChartItem* source = new ChartItem(FlowEnumItem::Flow1);
+            source->setPos(i * 200, 0);
+            scene->addItem(source);
+            LineItem* line = new LineItem(source, target);
+            scene->addItem(line);
+            scene->allLines.append(line);
+            lines.append(line);
+        }
+        scene->setEdgeBundling(true);
+        for (LineItem* line : qAsConst(lines))
+        {
+            QVERIFY(line->isBundled());
+        }
+        // 未绘制的线不能被点中
+        QPointF middle = lines.first()->line().center();
+        QVERIFY(!lines.first()->contains(lines.first()->mapFromScene(middle)));
+        lines.first()->setSelected(true);
+        QVERIFY(lines.first()->contains(lines.first()->mapFromScene(middle)));
+        lines.first()->setSelected(false);
+
+        // 颜色不同的线和带文本的线不捆绑，其余八条仍然捆绑
+        lines.last()->color = Qt::red;
+        TextItem* label = new TextItem();
+        scene->addItem(label);
+        scene->allTexts.append(label);
+        scene->connectText(label, lines.at(1));
+        scene->setEdgeBundling(false);
+        scene->setEdgeBundling(true);
+        QVERIFY(!lines.last()->isBundled());
+        QVERIFY(!lines.at(1)->isBundled());
+        QVERIFY(lines.first()->isBundled());
+
+        // 正交布线时不捆绑
+        scene->setEdgeRouting(OrthogonalRouting);
+        QVERIFY(!lines.first()->isBundled());
+        scene->setEdgeRouting(StraightRouting);
+        QVERIFY(lines.first()->isBundled());
+
+        scene->setEdgeBundling(false);
+        QVERIFY(!lines.first()->isBundled());
+    }
+
+    void testGraphAnalysis()
+    {
+        // 开始 -> 判定 -> 流程 -> 结束，判定的另一分支回到判定；另有一段与开始不相连的流程 -> 判定
+        QVector<int> types = { StartOrEnd, Judge, Flow1, StartOrEnd, Flow1, Flow1, Judge };
+        QVector<int> starts = { 0, 1, 2, 1, 4, 5 };
+        QVector<int> ends = { 1, 2, 3, 4, 1, 6 };
+        QVector<quint8> warnings = GraphAnalysis::analyze(types, starts, ends);
+        QCOMPARE(int(warnings[0]), int(GraphAnalysis::NoWarning));
+        QCOMPARE(int(warnings[1]), int(GraphAnalysis::InCycle));
+        QCOMPARE(int(warnings[2]), int(GraphAnalysis::NoWarning));
+        QCOMPARE(int(warnings[3]), int(GraphAnalysis::NoWarning));
+        QCOMPARE(int(warnings[4]), int(GraphAnalysis::InCycle));
+        QCOMPARE(int(warnings[5]), GraphAnalysis::Unreachable | GraphAnalysis::DeadEnd);
+        QCOMPARE(int(warnings[6]), GraphAnalysis::Unreachable | GraphAnalysis::DeadEnd | GraphAnalysis::JudgeBranches);
+
+        // 增量编辑只报告警告发生变化的图形
+        GraphAnalysis graph;
+        graph.setNode(1, StartOrEnd);
+        graph.setNode(2, Flow1);
+        graph.setNode(3, StartOrEnd);
+        graph.setEdge(10, 1, 2);
+        graph.setEdge(11, 2, 3);
+        QCOMPARE(graph.analyze(), QList<quintptr>());
+        QVERIFY(!graph.isDirty());
+        graph.removeEdge(11);
+        QCOMPARE(graph.analyze(), QList<quintptr>() << 1 << 2);
+        QCOMPARE(graph.warnings(2), int(GraphAnalysis::DeadEnd));
+        QCOMPARE(graph.warnings(3), int(GraphAnalysis::NoWarning));
+        graph.setEdge(11, 2, 3);
+        QCOMPARE(graph.analyze(), QList<quintptr>() << 1 << 2);
+        QCOMPARE(graph.warnings(2), int(GraphAnalysis::NoWarning));
+    }
+
+    void testLabelIndex()
+    {
+        LabelIndex index;
+        index.setLabel(1, "开始处理");
+        index.setLabel(2, "Process Order");
+        index.setLabel(3, "order");
+        index.setLabel(4, "ab");
+        QCOMPARE(index.search("order", LabelIndex::Exact, Qt::CaseSensitive), QList<quintptr>() << 3);
+        QCOMPARE(index.search("ORDER", LabelIndex::Substring), QList<quintptr>() << 2 << 3);
+        QCOMPARE(index.search("proc", LabelIndex::Prefix), QList<quintptr>() << 2);
+        QCOMPARE(index.search("处理", LabelIndex::Substring), QList<quintptr>() << 1);
+        QCOMPARE(index.search("a", LabelIndex::Substring), QList<quintptr>() << 4);
+        QCOMPARE(index.search("^Pro\\w+ Ord", LabelIndex::Regex), QList<quintptr>() << 2);
+        QVERIFY(index.search("(", LabelIndex::Regex).isEmpty());       // 无效的正则表达式
+
+        // 修改和删除只影响自己的倒排项，空槽会被复用
+        index.setLabel(3, "closed");
+        QCOMPARE(index.search("order", LabelIndex::Substring), QList<quintptr>() << 2);
+        index.removeLabel(2);
+        QVERIFY(index.search("order", LabelIndex::Substring).isEmpty());
+        index.setLabel(5, "new order");
+        QCOMPARE(index.search("order", LabelIndex::Substring), QList<quintptr>() << 5);
+        QCOMPARE(index.count(), 4);
+
+        // 可选分组和断言中的字面量不是必须的，不能用来缩小范围
+        index.setLabel(6, "xyz");
+        QCOMPARE(index.search("(abc)?x", LabelIndex::Regex), QList<quintptr>() << 6);
+        QCOMPARE(index.search("^(?!abc).*x", LabelIndex::Regex), QList<quintptr>() << 6);
+        QCOMPARE(index.search("^(?!abc)", LabelIndex::Regex).size(), 5);
+        // 重复次数不是必须出现的字面量
+        index.setLabel(7, "abbb");
+        index.setLabel(8, "x" + QString(12, QLatin1Char('x')));
+        QCOMPARE(index.search("ab{2,4}", LabelIndex::Regex), QList<quintptr>() << 7);
+        QCOMPARE(index.search("x{10,20}", LabelIndex::Regex), QList<quintptr>() << 8);
+        index.removeLabel(7);
+        index.removeLabel(8);
+        QCOMPARE(index.search("\\(x", LabelIndex::Regex), QList<quintptr>());
+        index.removeLabel(6);
+
+        // 场景中编辑过的文本不再出现在查找结果中
+        Scene scene;
+        TextItem* first = new TextItem();
+        TextItem* second = new TextItem();
+        scene.addItem(first);
+        scene.addItem(second);
+        first->setPlainText("判断");
+        second->setPlainText("判断");
+        scene.searchText("判断");
+        QCOMPARE(scene.containTexts.size(), 2);
+        second->setPlainText("结束");
+        QCOMPARE(scene.refreshSearch(), 1);
+        QCOMPARE(scene.containTexts.first(), first);
+        delete first;
+        QCOMPARE(scene.refreshSearch(), 0);
+        QCOMPARE(scene.getLabelIndex().count(), 1);
+    }
+
+    void testReplaceAll()
+    {
+        QCOMPARE(TextReplacer::replace("Check order", "ORDER", LabelIndex::Substring, "item"), QString("Check item"));
+        QCOMPARE(TextReplacer::replace("步骤12", "步骤(\\d+)", LabelIndex::Regex, "第\\1步"), QString("第12步"));
+        QCOMPARE(TextReplacer::replace("开始", "结束", LabelIndex::Exact, "x"), QString("开始"));
+
+        // 原文各不相同的文本整批替换，撤销后各自恢复
+        Scene scene;
+        OperationStack stack;
+        scene.operationStack = &stack;
+        QStringList texts = { "审核订单", "订单完成", "发货", "取消订单并退款" };
+        QList<TextItem*> items;
+        for (const QString& text : texts)
+        {
+            TextItem* textItem = new TextItem();
+            scene.addItem(textItem);
+            textItem->setPlainText(text);
+            items.append(textItem);
+        }
+        scene.replaceAll("订单", LabelIndex::Substring, "单据");
+        scene.getReplacer()->waitForDone();
+        QCOMPARE(stack.getUndoCount(), 1);
+        QCOMPARE(items[0]->toPlainText(), QString("审核单据"));
+        QCOMPARE(items[1]->toPlainText(), QString("单据完成"));
+        QCOMPARE(items[2]->toPlainText(), QString("发货"));
+        QCOMPARE(items[3]->text, QString("取消单据并退款"));
+        QVERIFY(scene.getLabelIndex().search("订单", LabelIndex::Substring).isEmpty());
+        stack.undo();
+        for (int i = 0; i < items.size(); ++i)
+        {
+            QCOMPARE(items[i]->toPlainText(), texts[i]);
+        }
+        stack.redo();
+        QCOMPARE(items[3]->toPlainText(), QString("取消单据并退款"));
+    }
+
+    void testTabUnloading()
+    {
+        // 与主窗口相同的页面结构：视图在上，其余控件在下
+        QTabWidget tabs;
+        TabCache::ViewFactory factory = [](QWidget* page) {
+            View* view = new View(page);
+            view->setObjectName("graphicsView");
+            qobject_cast<QVBoxLayout*>(page->layout())->insertWidget(0, view);
+            return view;
+        };
+        TabCache cache(&tabs, factory);
+        QList<QWidget*> pages;
+        for (int i = 0; i < 3; ++i)
+        {
+            QWidget* page = new QWidget();
+            new QVBoxLayout(page);
+            factory(page);
+            tabs.addTab(page, QString::number(i));
+            cache.addPage(page);
+            pages.append(page);
+        }
+        View* view = cache.view(pages[1]);
+        view->addChartItem(FlowEnumItem::StartOrEnd, QPointF(100, 100));
+        view->graphicsScene->allTexts.first()->setPlainText("审批");
+        tabs.setCurrentIndex(0);
+        processEvents();
+        qint64 emptyPage = TabCache::estimateBytes(pages[0]->findChild<View*>("graphicsView")->graphicsScene);
+        QCOMPARE(cache.loadedBytes(), 2 * emptyPage + TabCache::estimateBytes(view->graphicsScene));
+
+        // 有撤销记录的页面不卸载
+        cache.setMemoryBudget(0);
+        processEvents();
+        QVERIFY(cache.isLoaded(pages[1]));
+        QVERIFY(!cache.isLoaded(pages[2]));
+        QVERIFY(view->operationStack->getUndoCount() > 0);
+
+        // 预算为0时只保留当前页面
+        view->operationStack->clearall();
+        cache.setMemoryBudget(0);
+        processEvents();
+        QVERIFY(cache.isLoaded(pages[0]));
+        QVERIFY(!cache.isLoaded(pages[1]));
+        QVERIFY(!cache.isLoaded(pages[2]));
+        QVERIFY(pages[1]->findChild<View*>("graphicsView") == nullptr);
+        QVERIFY(!cache.thumbnail(pages[1]).isNull());
+        QCOMPARE(cache.labelTexts(pages[1]), QStringList() << "审批");
+
+        // 激活时由数据模型重新创建
+        cache.setMemoryBudget(qint64(1) << 30);
+        tabs.setCurrentIndex(1);
+        processEvents();
+        QVERIFY(cache.isLoaded(pages[1]));
+        View* restored = pages[1]->findChild<View*>("graphicsView");
+        QVERIFY(restored != nullptr);
+        QCOMPARE(restored->graphicsScene->allTexts.size(), 1);
+        QCOMPARE(restored->graphicsScene->allTexts.first()->toPlainText(), QString("审批"));
+        QVERIFY(pages[1]->findChild<QWidget*>("tabThumbnail") == nullptr);
+    }
+
+    void testProjectFile()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        QString path = dir.filePath("pages.fcproj");
+        QVector<ProjectFile::SavedPage> pages(3);
+        for (int i = 0; i < pages.size(); ++i)
+        {
+            pages[i].guid = QString("page%1").arg(i);
+            pages[i].name = QString("第%1页").arg(i + 1);
+            pages[i].dirty = true;
+            pages[i].model.addNode(QString("node%1").arg(i), StartOrEnd, QPointF(i * 100, 0));
+        }
+        ProjectFile file;
+        QVERIFY(file.save(path, pages));
+        QVERIFY(ProjectFile::isProjectFile(path));
+
+        // 只修改第二页：其余页面的位置不变，新内容追加在后面
+        ProjectFile reopened;
+        QVERIFY(reopened.open(path));
+        QCOMPARE(reopened.pages().size(), 3);
+        QCOMPARE(reopened.pages()[2].name, QString("第3页"));
+        qint64 firstOffset = reopened.pages()[0].offset;
+        pages[0].dirty = false;
+        pages[2].dirty = false;
+        pages[1].model.addNode("extra", Flow1, QPointF(100, 100));
+        QVERIFY(reopened.save(path, pages));
+        QCOMPARE(reopened.pages()[0].offset, firstOffset);
+        QVERIFY(reopened.pages()[1].offset > reopened.pages()[2].offset);
+
+        ProjectFile latest;
+        QVERIFY(latest.open(path));
+        DiagramModel model;
+        QVERIFY(latest.readPage("page1", &model));
+        QCOMPARE(model.nodeUids, QVector<QString>() << "node1" << "extra");
+
+        // 打开项目时只显示页名，激活的页面才创建图形项
+        QTabWidget* tabWidget = mainWindow->findChild<QTabWidget*>("tabWidget");
+        int before = tabWidget->count();
+        bool opened = false;
+        QMetaObject::invokeMethod(mainWindow, "openProjectFile", Q_RETURN_ARG(bool, opened), Q_ARG(QString, path));
+        processEvents();
+        QVERIFY(opened);
+        QCOMPARE(tabWidget->count(), before + 3);
+        QCOMPARE(tabWidget->tabText(before + 1), QString("第2页"));
+        QVERIFY(tabWidget->widget(before)->findChild<View*>("graphicsView") != nullptr);
+        QVERIFY(tabWidget->widget(before + 1)->findChild<View*>("graphicsView") == nullptr);
+        tabWidget->setCurrentIndex(before + 1);
+        processEvents();
+        View* view = tabWidget->widget(before + 1)->findChild<View*>("graphicsView");
+        QVERIFY(view != nullptr);
+        QCOMPARE(view->graphicsScene->toModel(view->graphicsScene->items()).nodeCount(), 2);
+        while (tabWidget->count() > before)
+        {
+            QMetaObject::invokeMethod(mainWindow, "closeTab", Q_ARG(int, before));
+        }
+    }
+
+    void testPixmapMipmaps()
+    {
+        // 每级宽高减半，取不小于目标大小的最小一级
+        QImage image(1000, 600, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::red);
+        MipPyramid pyramid(image);
+        QCOMPARE(pyramid.levelCount(), 6);
+        QCOMPARE(pyramid.level(1).size(), QSize(500, 300));
+        QCOMPARE(pyramid.levelFor(QSize(200, 100)).size(), QSize(250, 150));
+        QCOMPARE(pyramid.levelFor(QSize(2000, 100)).size(), QSize(1000, 600));
+        QCOMPARE(pyramid.scaled(QSize(100, 60), Qt::FastTransformation).size(), QSize(100, 60));
+
+        // 改变大小后立即得到快速缩放的结果，平滑缩放的结果在后台完成后替换
+        Scene scene;
+        PixmapItem* item = new PixmapItem(QPixmap::fromImage(image));
+        scene.addItem(item);
+        QThreadPool::globalInstance()->waitForDone();               // 等待各级缩小版本生成
+        processEvents();
+        item->changeRect(QRectF(0, 0, 300, 300));
+        QCOMPARE(item->pixmap().size(), QSize(300, 180));
+        QTRY_VERIFY(item->isSmooth());
+        QCOMPARE(item->pixmap().size(), QSize(300, 180));
+        item->changeRect(QRectF(0, 0, 500, 500), true);             // 正好是一级，无需再平滑缩放
+        QVERIFY(item->isSmooth());
+        item->changeRect(QRectF(0, 0, 120, 400));
+        delete item;                                                // 后台结果到达时图形已析构
+        QThreadPool::globalInstance()->waitForDone();
+        processEvents();
+    }
+
+    void testImageStore()
+    {
+        QImage image(400, 200, QImage::Format_RGB32);
+        image.fill(Qt::blue);
+        QByteArray encoded;
+        QBuffer buffer(&encoded);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "png");
+
+        // 相同内容只保存一份，只按需要的大小解码
+        Scene scene;
+        ImageStore& store = scene.getImageStore();
+        QString key = store.insert(encoded);
+        QCOMPARE(store.insert(QByteArray(encoded)), key);
+        QVERIFY(store.insert(QByteArray("not an image")).isEmpty());
+        QCOMPARE(store.count(), 1);
+        QCOMPARE(store.imageSize(key), QSize(400, 200));
+        QCOMPARE(store.image(key, QSize(100, 100)).size(), QSize(100, 50));
+
+        PixmapItem* first = scene.createPixmapItem(key, QSize(200, 100));
+        PixmapItem* second = scene.createPixmapItem(key);
+        scene.addItem(first);
+        scene.addItem(second);
+        QCOMPARE(first->pixmap().size(), QSize(200, 100));
+        QCOMPARE(second->pixmap().size(), QSize(400, 200));
+        scene.setBackgroundImage(key, QSize(40, 40));
+
+        // 复制两个图片项只带一份图片数据，也不带背景
+        QString data = scene.copyToXml(scene.items());
+        QCOMPARE(data.count("<Image "), 1);
+        QVERIFY(!data.contains("<Background"));
+        QList<QGraphicsItem*> pasted = scene.pasteFromXml(data, QPointF(500, 500));
+        QCOMPARE(pasted.size(), 2);
+        QCOMPARE(store.count(), 1);
+
+        // 保存后读取：图片按保存时的显示大小解码，背景也一起恢复
+        QByteArray xml;
+        QBuffer file(&xml);
+        file.open(QIODevice::WriteOnly);
+        QVERIFY(scene.saveToXml(&file, "images", "images"));
+        file.close();
+        QCOMPARE(xml.count("<Image "), 1);
+        Scene loaded;
+        file.open(QIODevice::ReadOnly);
+        loaded.loadFromXml(&file);
+        QCOMPARE(loaded.getImageStore().count(), 1);
+        QCOMPARE(loaded.getBackgroundImage(), key);
+        QCOMPARE(loaded.getBackgroundRenderer().imageSize(), QSize(40, 20));
+        int pictures = 0;
+        QList<QGraphicsItem*> loadedItems = loaded.items();
+        for (QGraphicsItem* item : qAsConst(loadedItems))
+        {
+            if (item->type() == PixmapItem::Type)
+            {
+                ++pictures;
+                QCOMPARE(qgraphicsitem_cast<PixmapItem*>(item)->imageKey(), key);
+            }
+        }
+        QCOMPARE(pictures, 4);
+        QThreadPool::globalInstance()->waitForDone();
+        processEvents();
+    }
+
+    void testDecodeAtDisplaySize()
+    {
+        QImage image(2000, 1000, QImage::Format_RGB32);
+        image.fill(Qt::green);
+        QByteArray encoded;
+        QBuffer buffer(&encoded);
+        buffer.open(QIODevice::WriteOnly);
+        image.save(&buffer, "png");
+
+        // 导入时只按显示大小乘以缩放比例解码
+        Scene scene;
+        QString key = scene.getImageStore().insert(encoded);
+        PixmapItem* item = scene.createPixmapItem(key, QSizeF(400, 400), 0.5);
+        scene.addItem(item);
+        QCOMPARE(item->getDisplaySize(), QSizeF(400, 200));
+        QCOMPARE(item->boundingRect(), QRectF(0, 0, 400, 200));
+        QCOMPARE(item->image().size(), QSize(200, 100));
+
+        // 放大绘制时在后台按需要的分辨率重新解码，显示大小不变
+        QImage frame(1600, 800, QImage::Format_ARGB32_Premultiplied);
+        QPainter painter(&frame);
+        scene.render(&painter, QRectF(frame.rect()), item->sceneBoundingRect());
+        painter.end();
+        QTRY_COMPARE(item->pixmap().size(), QSize(1600, 800));
+        QCOMPARE(item->image().size(), QSize(1600, 800));
+        QCOMPARE(item->getDisplaySize(), QSizeF(400, 200));
+
+        // 缩小绘制时保留已有的分辨率，超过原图时不再增加
+        painter.begin(&frame);
+        scene.render(&painter, QRectF(0, 0, 100, 50), item->sceneBoundingRect());
+        scene.render(&painter, QRectF(frame.rect()), QRectF(0, 0, 100, 50));
+        painter.end();
+        QTRY_VERIFY(item->isSmooth());
+        QCOMPARE(item->pixmap().size(), QSize(2000, 1000));
+        QThreadPool::globalInstance()->waitForDone();
+        processEvents();
+    }
+
+    void testTiledBackground()
+    {
+        QCOMPARE(BackgroundRenderer::bucketFor(1), 0);
+        QCOMPARE(BackgroundRenderer::bucketFor(1.5), 1);
+        QCOMPARE(BackgroundRenderer::bucketFor(0.3), -1);
+        QCOMPARE(BackgroundRenderer::bucketFor(100), BackgroundRenderer::maxBucket);
+
+        // 300×200 的图片从场景原点开始重复，原比例下每个重复单元为两块
+        QImage image(300, 200, QImage::Format_RGB32);
+        image.fill(Qt::red);
+        image.setPixel(0, 0, qRgb(0, 0, 255));
+        BackgroundRenderer renderer;
+        renderer.setImage(image);
+        QImage frame(600, 400, QImage::Format_RGB32);
+        frame.fill(Qt::white);
+        QPainter painter(&frame);
+        renderer.draw(&painter, QRectF(0, 0, 600, 400));
+        QCOMPARE(renderer.cachedTiles(), 2);
+        renderer.draw(&painter, QRectF(100, 100, 50, 50));             // 只重画暴露区域，块已缓存
+        QCOMPARE(renderer.cachedTiles(), 2);
+        painter.end();
+        QCOMPARE(frame.pixel(450, 350), qRgb(255, 0, 0));
+        QCOMPARE(frame.pixel(300, 200), qRgb(0, 0, 255));              // 第二个重复单元的左上角
+
+        // 放大两倍时使用下一档，只生成暴露区域内的块
+        frame.fill(Qt::white);
+        painter.begin(&frame);
+        painter.scale(2, 2);
+        renderer.draw(&painter, QRectF(0, 0, 100, 100));
+        painter.end();
+        QCOMPARE(renderer.cachedTiles(), 3);
+        QCOMPARE(frame.pixel(150, 150), qRgb(255, 0, 0));
+    }
+
+    void testIconCache()
+    {
+        QTemporaryDir directory;
+        QString resource = ":/image/flowchart/icon/fc-1-bw.svg";
+        int renders = 0;
+        auto render = [&renders]()
+        {
+            ++renders;
+            QImage image(40, 20, QImage::Format_ARGB32_Premultiplied);
+            image.fill(Qt::blue);
+            return image;
+        };
+
+        // 第一次渲染并写入磁盘，之后的实例直接读取
+        IconCache cold(directory.path());
+        QCOMPARE(cold.image(resource, QSize(40, 20), render).size(), QSize(40, 20));
+        QCOMPARE(cold.misses(), 1);
+        IconCache warm(directory.path());
+        QImage cached = warm.image(resource, QSize(40, 20), render);
+        QCOMPARE(renders, 1);
+        QCOMPARE(warm.hits(), 1);
+        QCOMPARE(cached.pixelColor(10, 10), QColor(Qt::blue));
+
+        // 像素大小或资源不同时重新渲染
+        warm.image(resource, QSize(80, 40), render);
+        warm.image(":/image/flowchart/icon/fc-2-bw.svg", QSize(40, 20), render);
+        QCOMPARE(renders, 3);
+        QVERIFY(warm.clear());
+        IconCache(directory.path()).image(resource, QSize(40, 20), render);
+        QCOMPARE(renders, 4);
+    }
+
+    void testDeferredStartup()
+    {
+        // 刚创建的窗口不创建首帧之后的界面，显示并绘制后才创建
+        StartupTrace::start();
+        MainWindow window;
+        QToolButton* templateButton = window.findChild<QToolButton*>("templateToolButton");
+        QVERIFY(templateButton);
+        QVERIFY(templateButton->menu() == nullptr);
+        QVERIFY(!window.isStartupFinished());
+        window.show();
+        QTRY_VERIFY(window.isStartupFinished());
+        QCOMPARE(templateButton->menu()->actions().size(), 3);
+        QVERIFY(StartupTrace::elapsed("createToolBar") <= StartupTrace::elapsed("firstFrame"));
+        QVERIFY(StartupTrace::elapsed("firstFrame") <= StartupTrace::elapsed("interactive"));
+
+        // 一直不显示的窗口超时后也会创建
+        MainWindow hidden;
+        QTRY_VERIFY(hidden.isStartupFinished());
+        QVERIFY(hidden.findChild<QToolButton*>("templateToolButton")->menu() != nullptr);
+    }
+
     void testTextAssociationWithChart()
     {
         // 获取视图和场景
@@ -930,7 +1834,7 @@ private slots:
         QCOMPARE(textItem->toPlainText(), QString("开始或结束"));
 
         // 检查文本的初始位置是否正确
-        QTest::qWait(100); // 等待事件循环以确保所有更新已完成
+        processEvents(); // 处理所有更新
         QPointF initialTextPosition = textItem->pos();
 
         // 计算预期位置，遵循 updatePosition 的逻辑
@@ -951,7 +1855,7 @@ private slots:
         chartItem->setPos(newChartPosition);
 
         // 等待事件循环以确保更新
-        QTest::qWait(100);
+        processEvents();
 
         // 验证图形位置是否已更新
         QCOMPARE(chartItem->pos(), newChartPosition);
@@ -1150,7 +2054,7 @@ private slots:
         // 移动第一个元素，验证连线是否随动
         QPointF newPosition1(100, 100);
         item1->setPos(newPosition1);
-        QTest::qWait(100);
+        processEvents();
 
         // 检查连线是否已经更新
         QCOMPARE(lineItem->line().p1(), item1EdgePoint);
@@ -1346,5 +2250,18 @@ private slots:
         }
     }
 };
-//QTEST_MAIN(TestMainWindow)
-//#include "testmainwindow.moc"
+// 应用程序中只编译测试类；tests 目标定义 FLOWCHARTS_HEADLESS_TESTS，默认在 offscreen 平台上无界面运行
+#ifdef FLOWCHARTS_HEADLESS_TESTS
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    View::showPrompts = false;   // 没有人点击提示框
+    TestMainWindow test;
+    return QTest::qExec(&test, argc, argv);
+}
+#include "testmainwindow.moc"
+#endif
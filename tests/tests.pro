@@ -0,0 +1,26 @@
+# 功能测试：无界面运行 testmainwindow.cpp 中的测试（默认使用 offscreen 平台）
+# make check 运行全部测试；也可以按测试函数名拆分到多个进程并行运行，例如：
+#   ./tests testBatchedLayout testGridIndex
+include(../flowcharts.pri)
+
+QT       += testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tests
+DEFINES += FLOWCHARTS_HEADLESS_TESTS
+
+SOURCES += \
+    ../flowlayout.cpp \
+    ../mainwindow.cpp \
+    ../chartbutton.cpp \
+    ../testmainwindow.cpp
+
+HEADERS += \
+    ../flowlayout.h \
+    ../mainwindow.h \
+    ../chartbutton.h
+
+FORMS += \
+    ../mainwindow.ui
@@ -2,16 +2,39 @@
 #include "operation.h"
 #include "scene.h"
 #include "view.h"
+#include "profiler.h"
 #include <QDebug>
+#include <QCoreApplication>
+#include <QGuiApplication>
+#include <QPointer>
+#include <QStyleOptionGraphicsItem>
+#include <QTextDocumentFragment>
+
+// 退出编辑后所有文本共用的空文档，不为每个文本保留排版数据
+static QTextDocument* emptyDocument()
+{
+    static QPointer<QTextDocument> document;
+    if (document.isNull())
+    {
+        document = new QTextDocument(QCoreApplication::instance());
+        document->setUndoRedoEnabled(false);
+    }
+    return document;
+}
 
 TextItem::TextItem(QGraphicsItem* parent)
-    : QGraphicsTextItem(parent), text("文本"), connectItem(nullptr), Uid("")
+    : QGraphicsTextItem(parent), text("文本"), connectItem(nullptr), Uid(""), editorActive(false)
 {
     this->setAcceptHoverEvents(true);                                   // 接受悬停事件
+    this->setAcceptDrops(false);                                        // 未编辑时没有文档接收拖放
     setFlag(QGraphicsItem::ItemIsMovable, true);                        // 设置图形项可移动
     setFlag(QGraphicsItem::ItemIsSelectable, true);                     // 设置图形项可选中
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges, true);             // 位置变化时更新场景索引
     this->Uid = QUuid::createUuid().toString(QUuid::WithoutBraces);     // 生成唯一ID
-    this->setPlainText(text);                                           // 设置图形项的HTML内容
+    labelColor = QGuiApplication::palette().color(QPalette::Text);      // 与基类文档的默认颜色一致
+    staticText.setTextFormat(Qt::PlainText);                            // 按纯文本排版
+    staticText.setPerformanceHint(QStaticText::AggressiveCaching);      // 缓存字形，重绘时不再排版
+    this->setPlainText(text);                                           // 设置图形项的文本内容
 
     this->setZValue(1000);                                              // 设置Z值，确保在其他图形项之上
     // 设置文本字体大小
@@ -20,6 +43,11 @@ TextItem::TextItem(QGraphicsItem* parent)
     this->setFont(font);
 }
 
+TextItem::~TextItem()
+{
+    Scene::removeItemIndex(this);                                       // 析构时不会收到场景变更事件
+}
+
 int TextItem::type() const
 {
     return Type;
@@ -35,17 +63,16 @@ void TextItem::setTextEditFlags(Qt::TextInteractionFlags flags)
     {
         case Qt::NoTextInteraction:
         {
-            text = this->document()->toRawText();       // 保存当前文本内容
-            this->setPlainText(text);                   // 更新为HTML文本
+            setTextInteractionFlags(flags);             // 设置标志并释放编辑文档
+            text = this->toPlainText();                 // 保存当前文本内容
             updatePosition();                           // 更新位置
-            setTextInteractionFlags(flags);             // 设置标志
             break;
         }
         case Qt::TextEditorInteraction:
         {
             if (text != "")
             this->setPlainText(text);                   // 设置纯文本
-            setTextInteractionFlags(flags);             // 设置标志
+            setTextInteractionFlags(flags);             // 设置标志，按需创建编辑文档
             this->setFocus();                           // 设置焦点
             break;
         }
@@ -54,6 +81,177 @@ void TextItem::setTextEditFlags(Qt::TextInteractionFlags flags)
     }
 }
 
+QString TextItem::toPlainText() const
+{
+    if (editorActive)
+    {
+        return QGraphicsTextItem::toPlainText();        // 编辑中以文档为准
+    }
+    return labelText;
+}
+
+void TextItem::setPlainText(const QString& plainText)
+{
+    labelText = plainText;
+    if (editorActive)
+    {
+        QGraphicsTextItem::setPlainText(plainText);
+    }
+    else
+    {
+        updateStaticText();
+    }
+    Scene::updateLabelIndex(this);                      // 撤销、替换和读取文件都经过这里
+}
+
+void TextItem::setHtml(const QString& html)
+{
+    setPlainText(QTextDocumentFragment::fromHtml(html).toPlainText());  // 标签只按纯文本显示
+}
+
+QFont TextItem::font() const
+{
+    return labelFont;
+}
+
+void TextItem::setFont(const QFont& font)
+{
+    labelFont = font;
+    if (editorActive)
+    {
+        QGraphicsTextItem::setFont(font);
+    }
+    else
+    {
+        updateStaticText();
+    }
+}
+
+QColor TextItem::defaultTextColor() const
+{
+    return labelColor;
+}
+
+void TextItem::setDefaultTextColor(const QColor& color)
+{
+    labelColor = color;
+    if (editorActive)
+    {
+        QGraphicsTextItem::setDefaultTextColor(color);
+    }
+    update();
+}
+
+void TextItem::setTextInteractionFlags(Qt::TextInteractionFlags flags)
+{
+    if (flags == Qt::NoTextInteraction)
+    {
+        closeEditor();                                  // 退出编辑时释放文档
+        return;
+    }
+    openEditor();                                       // 进入编辑时才创建文档
+    QGraphicsTextItem::setTextInteractionFlags(flags);
+}
+
+bool TextItem::isEditing() const
+{
+    return editorActive;
+}
+
+void TextItem::openEditor()
+{
+    if (editorActive)
+    {
+        return;
+    }
+    prepareGeometryChange();
+    editorActive = true;
+    setDocument(new QTextDocument(this));               // 每次编辑使用自己的文档，退出时释放
+    QGraphicsTextItem::setFont(labelFont);              // 将当前样式同步到文档
+    QGraphicsTextItem::setDefaultTextColor(labelColor);
+    QGraphicsTextItem::setPlainText(labelText);
+    setAcceptDrops(true);
+}
+
+void TextItem::closeEditor()
+{
+    if (!editorActive)
+    {
+        return;
+    }
+    labelText = QGraphicsTextItem::toPlainText();       // 保留编辑结果
+    QGraphicsTextItem::setTextInteractionFlags(Qt::NoTextInteraction);
+    prepareGeometryChange();
+    editorActive = false;
+    QTextDocument* editorDocument = document();
+    setDocument(emptyDocument());                       // 换成共用的空文档，释放编辑文档及其排版和撤销记录
+    if (editorDocument->parent() == this)
+    {
+        delete editorDocument;
+    }
+    setAcceptDrops(false);
+    updateStaticText();
+    Scene::updateLabelIndex(this);
+}
+
+void TextItem::updateStaticText()
+{
+    prepareGeometryChange();
+    QString displayText = labelText;
+    displayText.replace(QLatin1Char('\n'), QChar::LineSeparator);   // 静态文本按行分隔符换行
+    staticText.setText(displayText);
+    staticText.prepare(QTransform(), labelFont);                    // 预先排版，绘制时直接使用字形
+    QSizeF size = staticText.size();
+    if (labelText.isEmpty())
+    {
+        size.setHeight(QFontMetricsF(labelFont).height());          // 空文本保留一行高度
+    }
+    labelRect = QRectF(0, 0, size.width() + 2 * labelMargin, size.height() + 2 * labelMargin);
+    Scene::updateItemIndex(this);                                   // 尺寸变化后更新网格索引
+    update();
+}
+
+QRectF TextItem::boundingRect() const
+{
+    if (editorActive)
+    {
+        return QGraphicsTextItem::boundingRect();
+    }
+    return labelRect;
+}
+
+QPainterPath TextItem::shape() const
+{
+    QPainterPath path;
+    path.addRect(boundingRect());
+    return path;
+}
+
+bool TextItem::contains(const QPointF& point) const
+{
+    return boundingRect().contains(point);
+}
+
+void TextItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    PROFILE_PAINT(TextPaint);
+    if (editorActive)
+    {
+        QGraphicsTextItem::paint(painter, option, widget);  // 编辑中由文档绘制
+        return;
+    }
+    painter->setFont(labelFont);
+    painter->setPen(labelColor);
+    painter->drawStaticText(QPointF(labelMargin, labelMargin), staticText);
+    // 选中时绘制虚线框
+    if (option->state & (QStyle::State_Selected | QStyle::State_HasFocus))
+    {
+        painter->setPen(QPen(option->palette.windowText(), 0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(labelRect);
+    }
+}
+
 void TextItem::setConnectItem(QGraphicsItem* item)
 {
     connectItem = item;
@@ -82,7 +280,7 @@ void TextItem::updatePosition()
             case LineItem::Type:                                        // 连接线项
             {
                 LineItem* flowitem = qgraphicsitem_cast<LineItem*>(connectItem);
-                QPointF flowcenter = flowitem->line().center();
+                QPointF flowcenter = flowitem->pathCenter();                // 正交布线时取折线的中点
                 QPointF textcenter = this->boundingRect().center() + this->pos();
                 this->setPos(this->pos() + (flowcenter - textcenter));  // 调整文本位置
                 break;
@@ -90,6 +288,7 @@ void TextItem::updatePosition()
             default:
                 break;
         }
+        Scene::updateItemIndex(this);                                   // 关联文本不发送几何变更事件，手动更新索引
     }
 }
 
@@ -102,6 +301,18 @@ QVariant TextItem::itemChange(GraphicsItemChange change, const QVariant &value)
             setTextEditFlags(Qt::NoTextInteraction);        // 禁用文本编辑
         }
     }
+    else if (change == QGraphicsItem::ItemSceneChange)
+    {
+        Scene::removeItemIndex(this);                       // 从原场景的索引中移除
+    }
+    else if (change == QGraphicsItem::ItemSceneHasChanged || change == QGraphicsItem::ItemPositionHasChanged)
+    {
+        Scene::updateItemIndex(this);                       // 更新网格索引
+        if (change == QGraphicsItem::ItemSceneHasChanged)
+        {
+            Scene::updateLabelIndex(this);                  // 登记到新场景的查找索引
+        }
+    }
     return QGraphicsTextItem::itemChange(change, value);    // 返回父类处理结果
 }
 
@@ -117,17 +328,13 @@ void TextItem::focusOutEvent(QFocusEvent* event)
         Scene* parentScene = dynamic_cast<Scene*>(this->scene());
         if (parentScene)
         {
-            // 获取 View 的操作栈
-            OperationStack* operationStack = qobject_cast<View*>(parentScene->parent())->operationStack;
-            if (operationStack)
-            {
-                // 创建一个文本编辑操作并推入撤销栈
-                operationStack->addOperation(new ReplacceTextOperation(text, newText, QList<QGraphicsItem*>() << this));
-            }
+            // 创建一个文本编辑操作并推入撤销栈
+            parentScene->addOperation(new ReplacceTextOperation(text, newText, QList<QGraphicsItem*>() << this));
         }
 
         // 更新当前文本内容
         text = newText;
+        Scene::updateLabelIndex(this);                      // 编辑结束后才更新查找索引，不随每次按键更新
     }
 
     // 调用父类的焦点事件处理
@@ -135,12 +342,92 @@ void TextItem::focusOutEvent(QFocusEvent* event)
 }
 
 
+void TextItem::mousePressEvent(QGraphicsSceneMouseEvent* event)
+{
+    // 未编辑时没有文档，直接按普通图形项处理
+    if (editorActive)
+    {
+        QGraphicsTextItem::mousePressEvent(event);
+    }
+    else
+    {
+        QGraphicsItem::mousePressEvent(event);
+    }
+}
+
+void TextItem::mouseMoveEvent(QGraphicsSceneMouseEvent* event)
+{
+    if (editorActive)
+    {
+        QGraphicsTextItem::mouseMoveEvent(event);
+    }
+    else
+    {
+        QGraphicsItem::mouseMoveEvent(event);
+    }
+}
+
+void TextItem::mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
+{
+    if (editorActive)
+    {
+        QGraphicsTextItem::mouseReleaseEvent(event);
+    }
+    else
+    {
+        QGraphicsItem::mouseReleaseEvent(event);
+    }
+}
+
 void TextItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent* event)
 {
-    QGraphicsTextItem::mouseDoubleClickEvent(event);  // 调用父类的双击事件处理
+    if (editorActive)
+    {
+        QGraphicsTextItem::mouseDoubleClickEvent(event);  // 调用父类的双击事件处理
+    }
+    else
+    {
+        QGraphicsItem::mouseDoubleClickEvent(event);
+    }
 
     if (textInteractionFlags() == Qt::NoTextInteraction)
     {
         setTextEditFlags(Qt::TextEditorInteraction);  // 启用文本编辑
     }
 }
+
+void TextItem::hoverEnterEvent(QGraphicsSceneHoverEvent* event)
+{
+    if (editorActive)
+    {
+        QGraphicsTextItem::hoverEnterEvent(event);
+    }
+    else
+    {
+        QGraphicsItem::hoverEnterEvent(event);
+    }
+}
+
+void TextItem::hoverMoveEvent(QGraphicsSceneHoverEvent* event)
+{
+    if (editorActive)
+    {
+        QGraphicsTextItem::hoverMoveEvent(event);
+    }
+    else
+    {
+        QGraphicsItem::hoverMoveEvent(event);
+    }
+}
+
+void TextItem::hoverLeaveEvent(QGraphicsSceneHoverEvent* event)
+{
+    if (editorActive)
+    {
+        QGraphicsTextItem::hoverLeaveEvent(event);
+    }
+    else
+    {
+        QGraphicsItem::hoverLeaveEvent(event);
+    }
+}
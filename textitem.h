@@ -3,15 +3,18 @@
 
 #include <QGraphicsTextItem>
 #include <QTextDocument>
+#include <QStaticText>
 #include <QUuid>
 
 #include "lineitem.h"
 
+// 文本项：未编辑时由缓存的 QStaticText 绘制，进入编辑时才创建 QTextDocument
 class TextItem: public QGraphicsTextItem
 {
     Q_OBJECT
 public:
     TextItem(QGraphicsItem* parent = nullptr);
+    ~TextItem() override;
 
     QString text;                                                                   // 文本内容
     QGraphicsItem* connectItem;                                                     // 关联对象
@@ -24,10 +27,47 @@ public:
     void setConnectItem(QGraphicsItem* item);                                       // 设置关联图形
     void updatePosition();                                                          // 位置更新改变
 
+    // 以下接口遮蔽 QGraphicsTextItem 的同名函数，未编辑时不触碰基类的文档
+    // 它们不是虚函数，通过 QGraphicsTextItem 指针调用会绕过缓存，外部一律经 TextItem* 调用
+    QString toPlainText() const;                                                    // 获取纯文本
+    void setPlainText(const QString& plainText);                                    // 设置纯文本
+    void setHtml(const QString& html);                                              // 设置HTML文本（按纯文本显示）
+    QFont font() const;                                                             // 获取字体
+    void setFont(const QFont& font);                                                // 设置字体
+    QColor defaultTextColor() const;                                                // 获取文本颜色
+    void setDefaultTextColor(const QColor& color);                                  // 设置文本颜色
+    void setTextInteractionFlags(Qt::TextInteractionFlags flags);                   // 设置交互标志，按需创建编辑文档
+    bool isEditing() const;                                                         // 是否处于编辑状态
+
+    QRectF boundingRect() const override;                                           // 返回边界矩形
+    QPainterPath shape() const override;                                            // 返回形状
+    bool contains(const QPointF& point) const override;                             // 判断点是否在文本内
+    void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override; // 绘制文本
+
 protected:
     QVariant itemChange(GraphicsItemChange change, const QVariant &value) override; // 图形更改事件
     void focusOutEvent(QFocusEvent* event) override;                                // 失去光标事件
+    void mousePressEvent(QGraphicsSceneMouseEvent* event) override;                 // 鼠标按下事件
+    void mouseMoveEvent(QGraphicsSceneMouseEvent* event) override;                  // 鼠标移动事件
+    void mouseReleaseEvent(QGraphicsSceneMouseEvent* event) override;               // 鼠标释放事件
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override;           // 鼠标双击事件
+    void hoverEnterEvent(QGraphicsSceneHoverEvent* event) override;                 // 鼠标进入事件
+    void hoverMoveEvent(QGraphicsSceneHoverEvent* event) override;                  // 鼠标悬停事件
+    void hoverLeaveEvent(QGraphicsSceneHoverEvent* event) override;                 // 鼠标离开事件
+
+private:
+    QString labelText;                                                              // 显示的文本
+    QFont labelFont;                                                                // 显示的字体
+    QColor labelColor;                                                              // 显示的颜色
+    QStaticText staticText;                                                         // 缓存的字形
+    QRectF labelRect;                                                               // 未编辑时的边界矩形
+    bool editorActive;                                                              // 是否已创建编辑文档
+
+    static const int labelMargin = 4;                                               // 与 QTextDocument 默认边距一致
+
+    void updateStaticText();                                                        // 重新排版静态文本
+    void openEditor();                                                              // 创建编辑文档
+    void closeEditor();                                                             // 释放编辑文档，换回共用的空文档
 
 public slots:
     void parentPositionHasChanged();                                                // 更新位置
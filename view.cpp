@@ -1,9 +1,12 @@
 ﻿#include "view.h"
 
 #include <QDebug>
+#include <QFileDialog>
+
+bool View::showPrompts = true;
 
 View::View(QWidget *parent)
-    : QGraphicsView(parent), scaleMultiple(1.0), isMoveView(false)
+    : QGraphicsView(parent), operationStack(nullptr), scaleMultiple(1.0), isMoveView(false), rubberBand(nullptr)
 {
     setRenderHint(QPainter::Antialiasing);              // 启用反锯齿渲染
     setCacheMode(QGraphicsView::CacheBackground);       // 设置缓存模式为背景缓存
@@ -15,9 +18,17 @@ View::View(QWidget *parent)
     this->setAcceptDrops(true);                         // 启用拖放操作
 
     operationStack = new OperationStack(parent);        // 创建操作栈，用于撤销和重做操作
+    graphicsScene->operationStack = operationStack;     // 场景中的操作也记录到该栈
 
     // 当操作栈的操作数量发生改变时，判断撤销和重做按钮是否依然可用
     connect(operationStack, &OperationStack::countChange, this, &View::buttonChange);
+    // 栈为空时提示用户，无界面运行测试时不弹出
+    connect(operationStack, &OperationStack::stackIsEmpty, this, [this](const QString& message) {
+        if (View::showPrompts)
+        {
+            QMessageBox::information(parentWidget(), tr("提示"), message);
+        }
+    });
 
     // 设置快捷键Ctrl+Z用于撤销
     /*QShortcut* undoCut = new QShortcut(QKeySequence(tr("Ctrl+Z")), this, nullptr, nullptr, Qt::ApplicationShortcut);
@@ -30,6 +41,17 @@ View::View(QWidget *parent)
     // 设置快捷键Esc用于退出文本编辑模式
     QShortcut* outTextCut = new QShortcut(QKeySequence("Esc"), this, nullptr, nullptr, Qt::ApplicationShortcut);
     connect(outTextCut, &QShortcut::activated, this, &View::outTextEdit);
+
+#ifdef FLOWCHARTS_PROFILING
+    // F12显示或隐藏性能浮层，Ctrl+F12导出性能记录
+    QShortcut* overlayCut = new QShortcut(QKeySequence("F12"), this, nullptr, nullptr, Qt::WidgetWithChildrenShortcut);
+    connect(overlayCut, &QShortcut::activated, this, [&]() {
+        Profiler::instance().overlayVisible = !Profiler::instance().overlayVisible;
+        viewport()->update();
+    });
+    QShortcut* exportCut = new QShortcut(QKeySequence("Ctrl+F12"), this, nullptr, nullptr, Qt::WidgetWithChildrenShortcut);
+    connect(exportCut, &QShortcut::activated, this, &View::exportProfile);
+#endif
 }
 
 
@@ -55,14 +77,8 @@ void View::addChartItem(FlowEnumItem type, QPointF position)
     TextItem* textItem = new TextItem();                                    // 创建文本项
     textItem->setPlainText(item->text);
     textItem->text = item->text;
-    textItem->setConnectItem(item);                                         // 设置关联文本
-    // 设置文本项的属性
-    textItem->setFlag(QGraphicsItem::ItemIsMovable, false);                 // 禁用移动
-    textItem->setFlag(QGraphicsItem::ItemIsSelectable, true);               // 启用选择
-    textItem->setFlag(QGraphicsRectItem::ItemSendsGeometryChanges, false);  // 禁用几何变更信号
+    graphicsScene->connectText(textItem, item);                              // 设置关联文本并跟随图形移动
     graphicsScene->addItem(textItem);                                        // 将文本项添加到场景中
-    // 连接图形项位置变化信号
-    connect(item, &ChartItem::itemPositionHasChanged, textItem, &TextItem::parentPositionHasChanged);
     graphicsScene->allTexts.append(textItem);                                // 添加到文本列表
     item->setPos(position);                                                  // 设置流程图项的位置
     // 将添加操作记录到命令栈中，用于撤销操作
@@ -73,6 +89,7 @@ void View::addChartItem(FlowEnumItem type, QPointF position)
 void View::setScene(Scene *scene)
 {
     graphicsScene = scene;
+    graphicsScene->operationStack = operationStack;
     QGraphicsView::setScene(scene);
 
     // 创建撤销和重做按钮
@@ -151,10 +168,52 @@ void View::wheelEvent(QWheelEvent *event)
 
 void View::paintEvent(QPaintEvent *event)
 {
+#ifdef FLOWCHARTS_PROFILING
+    Profiler::instance().beginFrame();
+#endif
     updateButtonPosition(); // 更新按钮位置
     QGraphicsView::paintEvent(event);
+#ifdef FLOWCHARTS_PROFILING
+    Profiler::instance().endFrame(operationStack->getUndoCount() + operationStack->getRedoCount());
+#endif
+}
+
+#ifdef FLOWCHARTS_PROFILING
+void View::drawForeground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+    if (!Profiler::instance().overlayVisible)
+    {
+        return;
+    }
+    // 浮层画在视图坐标中，不随缩放和平移变化；显示的是上一帧的数据
+    painter->save();
+    painter->resetTransform();
+    QString text = Profiler::instance().overlayText();
+    QRect textRect = painter->fontMetrics().boundingRect(QRect(0, 0, 400, 400), Qt::AlignLeft | Qt::TextWordWrap, text);
+    textRect.moveTopRight(QPoint(viewport()->width() - 10, 10));
+    painter->fillRect(textRect.adjusted(-6, -6, 6, 6), QColor(0, 0, 0, 160));
+    painter->setPen(Qt::white);
+    painter->drawText(textRect, Qt::AlignLeft, text);
+    painter->restore();
 }
 
+void View::exportProfile()
+{
+    QString fileName = QFileDialog::getSaveFileName(this, tr("导出性能记录"), "profile.csv", tr("CSV文件 (*.csv);;Chrome Trace (*.json)"));
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+    bool saved = fileName.endsWith(".json", Qt::CaseInsensitive) ? Profiler::instance().exportChromeTrace(fileName)
+                                                                  : Profiler::instance().exportCsv(fileName);
+    if (!saved)
+    {
+        QMessageBox::warning(this, tr("提示"), tr("无法写入文件!"));
+    }
+}
+#endif
+
 void View::dragEnterEvent(QDragEnterEvent* event)
 {
     if (event->mimeData()->hasText() && event->mimeData()->text().toInt() > 0 && event->mimeData()->text().toInt() <= 10)
@@ -200,6 +259,20 @@ void View::mousePressEvent(QMouseEvent *event)
         viewport()->setCursor(Qt::ClosedHandCursor);    // 设置光标为手形
     }
     QGraphicsView::mousePressEvent(event);
+
+    // 网格索引下视图不使用自带的橡皮筋，在空白处按下左键时自己框选
+    Scene* flowScene = qobject_cast<Scene*>(scene());
+    if (event->button() == Qt::LeftButton && flowScene != nullptr && flowScene->getIndexMethod() == GridIndexing
+            && flowScene->getMode() == NoMode && flowScene->mouseGrabberItem() == nullptr)
+    {
+        if (rubberBand == nullptr)
+        {
+            rubberBand = new QRubberBand(QRubberBand::Rectangle, viewport());
+        }
+        rubberBandOrigin = event->pos();
+        rubberBand->setGeometry(QRect(rubberBandOrigin, QSize()));
+        rubberBand->show();
+    }
 }
 
 void View::mouseMoveEvent(QMouseEvent *event)
@@ -213,6 +286,16 @@ void View::mouseMoveEvent(QMouseEvent *event)
                               scene()->sceneRect().height());
         movePosition = event->pos();                                                                // 更新当前鼠标位置
     }
+    else if (rubberBand != nullptr && rubberBand->isVisible())
+    {
+        QRect bandRect = QRect(rubberBandOrigin, event->pos()).normalized();
+        rubberBand->setGeometry(bandRect);
+        Scene* flowScene = qobject_cast<Scene*>(scene());
+        if (flowScene != nullptr)
+        {
+            flowScene->selectItemsInRect(mapToScene(bandRect).boundingRect());                      // 通过网格查询选中项
+        }
+    }
     QGraphicsView::mouseMoveEvent(event);
 }
 
@@ -232,6 +315,10 @@ void View::mouseReleaseEvent(QMouseEvent *event)
         this->operationStack->addOperation(new  ViewMoveOperation(this->mapToScene(pressPosition), endpos, this));
         isMoveView = false;                     // 禁用视图移动
     }
+    if (rubberBand != nullptr)
+    {
+        rubberBand->hide();                     // 结束框选
+    }
 
     QGraphicsView::mouseReleaseEvent(event);
 }
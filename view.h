@@ -5,9 +5,12 @@
 #include <QIcon>
 #include <QMimeData>
 #include <QShortcut>
+#include <QRubberBand>
+#include <QMessageBox>
 
 #include "scene.h"
-#include "operationstack.h"
+#include "operation.h"
+#include "profiler.h"
 
 class View: public QGraphicsView
 {
@@ -18,6 +21,7 @@ public:
     OperationStack* operationStack;                                     // 撤销栈和重做栈
     Scene* graphicsScene;                                               // 界面
     double scaleMultiple;                                               // 缩放的倍数
+    static bool showPrompts;                                            // 是否弹出提示框，无界面运行测试时关闭
 
     void scaleByWheel(double scaleX,double scaleY, QPointF position);   // 滚轮引发的缩放
     void addChartItem(FlowEnumItem type, QPointF position);             // 添加图形
@@ -35,6 +39,9 @@ protected:
     void mousePressEvent(QMouseEvent *event) override;                  // 按下鼠标
     void mouseMoveEvent(QMouseEvent *event) override;                   // 移动鼠标
     void mouseReleaseEvent(QMouseEvent *event) override;
+#ifdef FLOWCHARTS_PROFILING
+    void drawForeground(QPainter *painter, const QRectF &rect) override;  // 绘制性能浮层
+#endif
 
 private:
     QPushButton* undoButton;                                            // 撤销按钮
@@ -46,10 +53,15 @@ private:
     QPoint movePosition;                                                // 鼠标的位置
     QPoint pressPosition;                                               // 按下鼠标的位置
     bool isMoveView;                                                    // 视图是否在移动
+    QRubberBand* rubberBand;                                            // 网格索引下使用的橡皮筋
+    QPoint rubberBandOrigin;                                            // 橡皮筋的起点
 
 public slots:
     void buttonChange(int undoCount, int redoCount);                    // 栈内操作数量改变引起按钮状态改变
     void outTextEdit();                                                 // Esc键退出文本编辑状态
+#ifdef FLOWCHARTS_PROFILING
+    void exportProfile();                                               // 导出性能记录
+#endif
 
 signals:
    void scaleMultipleChanged(double scaleMultiple);                     // 缩放比例改变的信号